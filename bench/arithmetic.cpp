@@ -0,0 +1,91 @@
+/*
+ * \file arithmetic.cpp
+ * \brief Benchmark: integer time arithmetic vs. double round trip
+ *
+ * Compares the timeval/timespec operators (TimeArithmetic.hpp) with the
+ * former implementation (timeval --> double --> fmod --> timeval).
+ *
+ * output: CSV (benchmark,ns_per_op)
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "ITimer.hpp"
+#include "TimeArithmetic.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace de::Koesling::ITimer;
+
+//! number of operations per benchmark
+static constexpr std::size_t ITERATIONS = 10000000;
+
+//! former implementation: multiply timeval via double
+static timeval double_mul(const timeval &time, double factor) noexcept
+{
+    double value = (static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_usec) / 1000000.0) * factor;
+    timeval ret_val;
+    ret_val.tv_sec = static_cast<time_t>(value);
+    ret_val.tv_usec = static_cast<suseconds_t>(fmod(value, 1.0) * 1000000.0);
+    return ret_val;
+}
+
+//! former implementation: divide timeval via double
+static timeval double_div(const timeval &time, double factor) noexcept
+{
+    double value = (static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_usec) / 1000000.0) / factor;
+    timeval ret_val;
+    ret_val.tv_sec = static_cast<time_t>(value);
+    ret_val.tv_usec = static_cast<suseconds_t>(fmod(value, 1.0) * 1000000.0);
+    return ret_val;
+}
+
+//! run benchmark and print result
+template <typename Function>
+static void run(const char *name, Function function)
+{
+    // factors and values are not known at compile time
+    volatile double factor = 1.37;
+    volatile time_t sec = 12345;
+    volatile suseconds_t usec = 678901;
+
+    long sink = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i < ITERATIONS; ++i)
+    {
+        timeval time = {sec, usec};
+        sink += function(time, factor).tv_usec;
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    printf("%s,%.3f\n", name, ns / static_cast<double>(ITERATIONS));
+
+    // prevent optimization
+    if(sink == 42) printf("%ld\n", sink);
+}
+
+int main()
+{
+    printf("benchmark,ns_per_op\n");
+
+    run("timeval_mul_double", double_mul);
+    run("timeval_mul_integer", [](const timeval &t, double f) { return timeval_mul(t, f); });
+    run("timeval_div_double", double_div);
+    run("timeval_div_integer", [](const timeval &t, double f) { return timeval_div(t, f); });
+    run("timespec_mul_integer", [](const timeval &t, double f) {
+        timespec spec = {t.tv_sec, t.tv_usec * 1000};
+        spec = timespec_mul(spec, f);
+        return timeval{spec.tv_sec, spec.tv_nsec / 1000};
+    });
+    run("timespec_div_integer", [](const timeval &t, double f) {
+        timespec spec = {t.tv_sec, t.tv_usec * 1000};
+        spec = timespec_div(spec, f);
+        return timeval{spec.tv_sec, spec.tv_nsec / 1000};
+    });
+
+    return EXIT_SUCCESS;
+}
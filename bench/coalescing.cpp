@@ -0,0 +1,79 @@
+/*
+ * \file coalescing.cpp
+ * \brief Benchmark: wakeups of periodic timers with different slack tolerances
+ *
+ * 32 periodic timers with slightly different intervals (10 ms, 10.1 ms, ...)
+ * in one CoalescingGroup. A larger slack lets more expirations share one
+ * wakeup.
+ *
+ * usage: coalescing [seconds]
+ *
+ * output: CSV (slack_us,timers,expirations,wakeups,saved_wakeups,cpu_us)
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "CoalescingGroup.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <vector>
+
+using namespace de::Koesling::ITimer;
+
+//! number of timers
+static constexpr long TIMERS = 32;
+
+//! expiration callback (no work)
+static void expired(CoalescedTimer &timer, void *arg)
+{
+    static_cast<void>(timer);
+    static_cast<void>(arg);
+}
+
+//! cpu time of the process in microseconds
+static long long cpu_time()
+{
+    timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return static_cast<long long>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+//! run all timers for duration with the given slack
+static void run(std::chrono::microseconds slack, std::chrono::milliseconds duration)
+{
+    CoalescingGroup group;
+
+    std::vector<std::unique_ptr<CoalescedTimer>> timers;
+    for(long i = 0; i < TIMERS; ++i)
+    {
+        timers.emplace_back(new CoalescedTimer(group, std::chrono::microseconds(10000 + i * 100), slack, expired));
+        timers.back()->start();
+    }
+
+    const long long cpu_start = cpu_time();
+    const auto end = std::chrono::steady_clock::now() + duration;
+    while(std::chrono::steady_clock::now() < end) group.wait();
+    const long long cpu = cpu_time() - cpu_start;
+
+    const auto statistics = group.get_statistics();
+    printf("%lld,%ld,%llu,%llu,%llu,%lld\n", static_cast<long long>(slack.count()), TIMERS,
+            static_cast<unsigned long long>(statistics.expirations),
+            static_cast<unsigned long long>(statistics.wakeups),
+            static_cast<unsigned long long>(statistics.saved_wakeups), cpu);
+}
+
+int main(int argc, char **argv)
+{
+    const std::chrono::milliseconds duration(argc > 1 ? atoi(argv[1]) * 1000 : 2000);
+
+    printf("slack_us,timers,expirations,wakeups,saved_wakeups,cpu_us\n");
+
+    for(long slack : {0, 100, 500, 1000, 2000, 5000})
+        run(std::chrono::microseconds(slack), duration);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+/*
+ * \file coro.cpp
+ * \brief Benchmark: coroutines waiting for timer expirations
+ *
+ * Many coroutines wait for the same TimerFd (reactor) and for a
+ * PosixTimer_Monotonic (SignalDispatcher --> CoroutineLoop::notify()).
+ * Measures the cpu time of the loop thread per resumed coroutine.
+ *
+ * Requires the coroutine library (-DITIMER_BUILD_COROUTINES=ON).
+ *
+ * usage: coro [coroutines]
+ *
+ * output: CSV (benchmark,coroutines,ticks,ns_per_resume)
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "CoroutineLoop.hpp"
+#include "PosixTimer.hpp"
+#include "SignalDispatcher.hpp"
+#include "TimerFd.hpp"
+#include <coroutine>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <exception>
+
+using namespace de::Koesling::ITimer;
+
+//! number of expirations per coroutine
+static constexpr std::uint64_t TICKS = 100;
+
+//! fire and forget coroutine
+struct Task
+{
+    struct promise_type
+    {
+        Task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept { }
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+// gcc generates switch statements without default case for coroutines
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wswitch-default"
+
+//! wait for TICKS expirations with next_tick()
+static Task wait_next_tick(CoroutineLoop &loop, const ITimer &timer, std::uint64_t &resumes)
+{
+    for(std::uint64_t ticks = 0; ticks < TICKS;)
+    {
+        ticks += co_await loop.next_tick(timer);
+        ++resumes;
+    }
+}
+
+//! wait for TICKS expirations with a stream
+static Task wait_stream(CoroutineLoop &loop, const ITimer &timer, std::uint64_t &resumes)
+{
+    auto stream = loop.ticks(timer);
+    const std::uint64_t first = stream.get_seen();
+    while(stream.get_seen() - first < TICKS)
+    {
+        co_await stream.next();
+        ++resumes;
+    }
+}
+
+#pragma GCC diagnostic pop
+
+//! run all coroutines and print the result
+template <typename Function>
+static void run(const char *name, CoroutineLoop &loop, unsigned coroutines, Function function)
+{
+    std::uint64_t resumes = 0;
+    for(unsigned i = 0; i < coroutines; ++i) function(resumes);
+
+    // cpu time of the loop thread (without the time waiting for the timer)
+    timespec start, end;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+    loop.run();
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+
+    const double ns = static_cast<double>(to_nsec(timespec_sub(end, start)));
+    printf("%s,%u,%llu,%.3f\n", name, coroutines, static_cast<unsigned long long>(TICKS),
+            ns / static_cast<double>(resumes ? resumes : 1));
+}
+
+int main(int argc, char **argv)
+{
+    const unsigned coroutines = argc > 1 ? static_cast<unsigned>(atoi(argv[1])) : 10000;
+
+    CoroutineLoop loop;
+    printf("benchmark,coroutines,ticks,ns_per_resume\n");
+
+    TimerFd timer_fd(timespec{0, 1000000});
+    loop.attach(timer_fd);
+    timer_fd.start();
+    run("timerfd_next_tick", loop, coroutines, [&](std::uint64_t &resumes) { wait_next_tick(loop, timer_fd, resumes); });
+    run("timerfd_stream", loop, coroutines, [&](std::uint64_t &resumes) { wait_stream(loop, timer_fd, resumes); });
+    timer_fd.stop();
+    loop.detach(timer_fd);
+
+    SignalDispatcher dispatcher;
+    PosixTimer_Monotonic posix(timespec{0, 1000000});
+    dispatcher.add(posix, CoroutineLoop::dispatch, &loop.attach(posix));
+    posix.start();
+    run("posix_dispatch_next_tick", loop, coroutines, [&](std::uint64_t &resumes) { wait_next_tick(loop, posix, resumes); });
+    run("posix_dispatch_stream", loop, coroutines, [&](std::uint64_t &resumes) { wait_stream(loop, posix, resumes); });
+    posix.stop();
+    dispatcher.remove(posix);
+    loop.detach(posix);
+
+    return EXIT_SUCCESS;
+}
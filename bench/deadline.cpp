@@ -0,0 +1,88 @@
+/*
+ * \file deadline.cpp
+ * \brief Benchmark: per request timeouts with DeadlineManager
+ *
+ * Simulates requests with a timeout that complete long before the timeout
+ * (arm + cancel, a fixed number of requests in flight). Compared with
+ * re-arming ITimer_Real for every request.
+ *
+ * usage: deadline [requests]
+ *
+ * output: CSV (method,requests,ns_per_request,timer_rearms)
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "DeadlineManager.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace de::Koesling::ITimer;
+
+//! requests in flight
+static constexpr std::size_t IN_FLIGHT = 1000;
+
+//! request timeout
+static constexpr std::chrono::seconds TIMEOUT(30);
+
+//! timeout callback (never called)
+static void timeout(void *arg)
+{
+    static_cast<void>(arg);
+}
+
+//! arm and cancel one deadline per request
+static void deadline_manager(unsigned long requests)
+{
+    DeadlineManager manager(2 * IN_FLIGHT);
+    std::vector<DeadlineManager::Deadline> in_flight(IN_FLIGHT);
+
+    for(auto &deadline : in_flight) deadline = manager.arm(TIMEOUT, timeout);
+
+    const auto start = std::chrono::steady_clock::now();
+    for(unsigned long i = 0; i < requests; ++i)
+    {
+        // the oldest request completes, a new one starts
+        auto &deadline = in_flight[i % IN_FLIGHT];
+        manager.cancel(deadline);
+        deadline = manager.arm(TIMEOUT, timeout);
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    printf("deadline_manager,%lu,%.1f,%llu\n", requests, static_cast<double>(ns) / static_cast<double>(requests),
+            static_cast<unsigned long long>(manager.get_rearms()));
+}
+
+//! re-arm the timer for each request
+static void rearm_per_request(unsigned long requests)
+{
+    ITimer_Real timer(timeval{3600, 0});
+
+    const auto start = std::chrono::steady_clock::now();
+    for(unsigned long i = 0; i < requests; ++i)
+    {
+        if(timer.is_running()) timer.stop();
+        timer.start(duration_to_timespec(TIMEOUT));
+    }
+    const auto end = std::chrono::steady_clock::now();
+    timer.stop();
+
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    printf("rearm_per_request,%lu,%.1f,%lu\n", requests, static_cast<double>(ns) / static_cast<double>(requests),
+            requests);
+}
+
+int main(int argc, char **argv)
+{
+    const unsigned long requests = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    printf("method,requests,ns_per_request,timer_rearms\n");
+    deadline_manager(requests);
+    rearm_per_request(requests);
+
+    return EXIT_SUCCESS;
+}
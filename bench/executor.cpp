@@ -0,0 +1,81 @@
+/*
+ * \file executor.cpp
+ * \brief Benchmark: PeriodicExecutor with different numbers of worker threads
+ *
+ * Many fixed rate jobs with a busy loop share one tick timer. With one
+ * worker thread the callbacks are serialized and runs are skipped; more
+ * workers (work stealing) execute the due jobs in parallel.
+ *
+ * usage: executor [seconds]
+ *
+ * output: CSV (threads,jobs,expected_runs,runs,skipped)
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "PeriodicExecutor.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace de::Koesling::ITimer;
+
+//! number of jobs
+static constexpr unsigned JOBS = 64;
+
+//! job period
+static constexpr std::chrono::milliseconds PERIOD(10);
+
+//! cpu time of one run
+static constexpr std::chrono::microseconds WORK(400);
+
+//! busy loop (the job occupies its worker)
+static void job(void *arg)
+{
+    static_cast<void>(arg);
+
+    const auto end = std::chrono::steady_clock::now() + WORK;
+    while(std::chrono::steady_clock::now() < end);
+}
+
+//! run all jobs for duration with the given number of worker threads
+static void run(unsigned threads, std::chrono::milliseconds duration)
+{
+    PeriodicExecutor executor(timespec{0, 1000000}, threads);
+
+    std::vector<PeriodicExecutor::JobId> ids;
+    for(unsigned i = 0; i < JOBS; ++i)
+        ids.push_back(executor.add(PERIOD, std::chrono::milliseconds(i % PERIOD.count()), job));
+
+    executor.start();
+    std::this_thread::sleep_for(duration);
+    executor.stop();
+
+    unsigned long long runs = 0, skipped = 0;
+    for(auto id : ids)
+    {
+        const auto statistics = executor.get_statistics(id);
+        runs += statistics.runs;
+        skipped += statistics.skipped;
+        executor.remove(id);
+    }
+
+    printf("%u,%u,%llu,%llu,%llu\n", threads, JOBS,
+            static_cast<unsigned long long>(JOBS * (duration / PERIOD)), runs, skipped);
+}
+
+int main(int argc, char **argv)
+{
+    const std::chrono::milliseconds duration(argc > 1 ? atoi(argv[1]) * 1000 : 2000);
+
+    printf("threads,jobs,expected_runs,runs,skipped\n");
+
+    const unsigned cpus = std::thread::hardware_concurrency();
+    for(unsigned threads = 1; threads <= (cpus ? cpus : 1); threads *= 2)
+        run(threads, duration);
+
+    return EXIT_SUCCESS;
+}
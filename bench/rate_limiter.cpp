@@ -0,0 +1,86 @@
+/*
+ * \file rate_limiter.cpp
+ * \brief Benchmark: TokenBucket with concurrent threads, unsharded and sharded
+ *
+ * All threads take tokens from one bucket as fast as possible. With one
+ * shard all threads update the same cache line; with one shard per cpu the
+ * threads use different cache lines until their shard is exhausted.
+ *
+ * usage: rate_limiter [seconds]
+ *
+ * output: CSV (shards,threads,attempts_per_s,accepted,expected)
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "RateLimiter.hpp"
+#include "PosixTimer.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace de::Koesling::ITimer;
+
+//! refill rate (tokens per second)
+static constexpr double RATE = 1e6;
+
+//! capacity of the bucket
+static constexpr double BURST = 1000;
+
+//! take tokens from one bucket with the given number of threads
+static void run(PosixTimer_Monotonic &timer, unsigned shards, unsigned threads, std::chrono::milliseconds duration)
+{
+    TokenBucket bucket(timer, RATE, BURST, shards);
+
+    std::atomic<bool> stop(false);
+    std::atomic<unsigned long long> attempts(0), accepted(0);
+
+    std::vector<std::thread> workers;
+    for(unsigned i = 0; i < threads; ++i)
+    {
+        workers.emplace_back([&]() {
+            unsigned long long local_attempts = 0, local_accepted = 0;
+            while(!stop.load(std::memory_order_relaxed))
+            {
+                ++local_attempts;
+                if(bucket.try_acquire()) ++local_accepted;
+            }
+            attempts += local_attempts;
+            accepted += local_accepted;
+        });
+    }
+
+    std::this_thread::sleep_for(duration);
+    stop.store(true);
+    for(auto &worker : workers) worker.join();
+
+    const double seconds = std::chrono::duration<double>(duration).count();
+    printf("%u,%u,%.0f,%llu,%.0f\n", bucket.get_shards(), threads, static_cast<double>(attempts.load()) / seconds,
+            accepted.load(), RATE * seconds + BURST);
+}
+
+int main(int argc, char **argv)
+{
+    const std::chrono::milliseconds duration(argc > 1 ? atoi(argv[1]) * 1000 : 2000);
+
+    // the scaled time of the timer drives the refill, the timer must not expire
+    PosixTimer_Monotonic timer(timespec{3600, 0});
+    timer.start();
+
+    printf("shards,threads,attempts_per_s,accepted,expected\n");
+
+    const unsigned cpus = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    for(unsigned shards : {1u, cpus})
+    {
+        for(unsigned threads = 1; threads <= cpus; threads *= 2)
+            run(timer, shards, threads, duration);
+        if(cpus == 1) break;
+    }
+
+    timer.stop();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/*
+ * \file stress.cpp
+ * \brief Stress test: concurrent use of one timer
+ *
+ * Writer threads start, stop and change the speed of shared timers while
+ * reader threads query them. Multiple threads race to construct ITimer_Real.
+ * Violated invariants are reported and the exit code is 1.
+ *
+ * Intended to be run with ThreadSanitizer:
+ *      cmake -DITIMER_BUILD_BENCHMARKS=ON -DITIMER_SANITIZE_THREAD=ON
+ *
+ * usage: stress [seconds]
+ *
+ * output: CSV (test,operations)
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "ITimer.hpp"
+#include "PosixTimer.hpp"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace de::Koesling::ITimer;
+
+//! number of writer threads per timer
+static constexpr unsigned WRITERS = 3;
+
+//! number of reader threads per timer
+static constexpr unsigned READERS = 3;
+
+//! number of threads that construct ITimer_Real
+static constexpr unsigned CONSTRUCTORS = 4;
+
+//! timer interval
+static constexpr timespec INTERVAL = {0, 1000000};
+
+//! tolerance of the timer value (drift correction)
+static constexpr timespec TOLERANCE = {0, 1000000};
+
+static std::atomic<bool> stop_threads(false);
+static std::atomic<unsigned long> errors(0);
+
+//! report violated invariant
+static void fail(const char *message)
+{
+    errors.fetch_add(1, std::memory_order_relaxed);
+    fprintf(stderr, "error: %s\n", message);
+}
+
+//! start/stop/speed changes in random order
+static void writer(ITimer &timer, unsigned seed, std::atomic<unsigned long> &operations)
+{
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> action(0, 3);
+    std::uniform_real_distribution<double> speed(0.25, 4.0);
+
+    while(!stop_threads.load(std::memory_order_relaxed))
+    {
+        try
+        {
+            switch(action(random))
+            {
+                case 0: timer.start(); break;
+                case 1: timer.stop(); break;
+                case 2: timer.set_speed_factor(speed(random)); break;
+                default: timer.set_speed_to_normal(); break;
+            }
+        }
+        catch(const std::logic_error &)
+        {
+            // already started
+        }
+        catch(const std::runtime_error &)
+        {
+            // already stopped
+        }
+        operations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+//! read the timer and check the values
+static void reader(const ITimer &timer, std::atomic<unsigned long> &operations)
+{
+    const timespec limit = timespec_add(INTERVAL, TOLERANCE);
+
+    while(!stop_threads.load(std::memory_order_relaxed))
+    {
+        const timespec value = timer.get_timer_value_timespec();
+        const timespec queried = timer.query_timer_value();
+
+        if(to_nsec(value) < 0 || timespec_compare(value, limit) > 0) fail("calculated timer value out of range");
+        if(to_nsec(queried) < 0 || timespec_compare(queried, limit) > 0) fail("queried timer value out of range");
+        if(timespec_compare(timer.get_interval_timespec(), INTERVAL) != 0) fail("interval modified");
+        if(to_nsec(timer.get_scaled_time()) < 0) fail("negative scaled time");
+
+        static_cast<void>(timer.is_running());
+        static_cast<void>(timer.get_expirations());
+        static_cast<void>(timer.get_corrected_drift());
+        operations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+//! construct ITimer_Real concurrently, only one instance may exist
+static void constructor(std::atomic<unsigned> &instances, std::atomic<unsigned long> &operations)
+{
+    while(!stop_threads.load(std::memory_order_relaxed))
+    {
+        try
+        {
+            ITimer_Real timer(timeval{3600, 0});
+            if(instances.fetch_add(1) != 0) fail("multiple ITimer_Real instances");
+            timer.start();
+            timer.stop();
+            instances.fetch_sub(1);
+        }
+        catch(const std::logic_error &)
+        {
+            // instance exists
+        }
+        operations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const int seconds = argc > 1 ? atoi(argv[1]) : 2;
+
+    // expirations are not handled
+    signal(SIGALRM, SIG_IGN);
+
+    PosixTimer_Monotonic posix(INTERVAL);
+
+    std::atomic<unsigned long> write_operations(0);
+    std::atomic<unsigned long> read_operations(0);
+    std::atomic<unsigned long> construct_operations(0);
+    std::atomic<unsigned> instances(0);
+
+    std::vector<std::thread> threads;
+    for(unsigned i = 0; i < WRITERS; ++i)
+        threads.emplace_back(writer, std::ref(posix), i, std::ref(write_operations));
+    for(unsigned i = 0; i < READERS; ++i)
+        threads.emplace_back(reader, std::cref(posix), std::ref(read_operations));
+    for(unsigned i = 0; i < CONSTRUCTORS; ++i)
+        threads.emplace_back(constructor, std::ref(instances), std::ref(construct_operations));
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stop_threads = true;
+    for(auto &thread : threads) thread.join();
+
+    printf("test,operations\n");
+    printf("write,%lu\n", write_operations.load());
+    printf("read,%lu\n", read_operations.load());
+    printf("construct,%lu\n", construct_operations.load());
+    printf("errors,%lu\n", errors.load());
+
+    return errors.load() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,496 @@
+/*
+ * \file suite.cpp
+ * \brief Benchmark suite: API cost, operator cost, expiration latency
+ *
+ * measures
+ *  - the cost of start/stop, set_speed_factor, get_timer_value,
+ *    query_timer_value and to_fstream
+ *  - the cost of an expected error (start of a running timer): exception
+ *    vs. error code (try_start())
+ *  - the same for the header only StaticITimer_Real (no virtual dispatch,
+ *    inlined)
+ *  - the cost of the timeval/timespec operators
+ *  - the latency (expiration --> signal handler/wakeup) and jitter of each
+ *    wall clock timer type for different intervals and speed factors
+ *  - the lateness of PrecisionTimer deadlines (deadline --> return of wait())
+ *
+ * usage: Linux_ITimer_bench_suite [--json] [--quick]
+ *
+ * output (stdout): CSV (default) or JSON, all values in nanoseconds
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "BasicITimer.hpp"
+#include "ITimer.hpp"
+#include "PosixTimer.hpp"
+#include "PrecisionTimer.hpp"
+#include "TimerFd.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace de::Koesling::ITimer;
+
+//! statistics of one benchmark
+struct Result
+{
+    std::string name;
+    std::size_t samples;
+    double mean;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+    double stddev;
+};
+
+//! benchmark configuration
+struct Config
+{
+    //! number of batches per cost benchmark
+    std::size_t batches;
+    //! number of operations per batch
+    std::size_t batch_size;
+    //! number of expirations per latency benchmark
+    std::size_t expirations;
+};
+
+//! calculate statistics (values are sorted)
+static Result statistics(const std::string &name, std::vector<double> &values)
+{
+    Result result = {name, values.size(), 0, 0, 0, 0, 0, 0};
+    if(values.empty()) return result;
+
+    std::sort(values.begin(), values.end());
+    const auto percentile = [&](double p) {
+        return values[static_cast<std::size_t>(p * static_cast<double>(values.size() - 1))];
+    };
+
+    double sum = 0;
+    for(double value : values) sum += value;
+    result.mean = sum / static_cast<double>(values.size());
+
+    double square_sum = 0;
+    for(double value : values) square_sum += (value - result.mean) * (value - result.mean);
+    result.stddev = std::sqrt(square_sum / static_cast<double>(values.size()));
+
+    result.p50 = percentile(0.5);
+    result.p90 = percentile(0.9);
+    result.p99 = percentile(0.99);
+    result.max = values.back();
+    return result;
+}
+
+//! nanoseconds of a timespec
+static std::int64_t nsec(const timespec &time) noexcept
+{
+    return static_cast<std::int64_t>(to_nsec(time));
+}
+
+//! current time (CLOCK_MONOTONIC)
+static timespec monotonic_now() noexcept
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now;
+}
+
+// ---------------------------------------------------------------------------
+// cost benchmarks
+// ---------------------------------------------------------------------------
+
+//! measure mean cost per operation of each batch
+template <typename Function>
+static Result measure_cost(const std::string &name, const Config &config, Function function)
+{
+    std::vector<double> values;
+    values.reserve(config.batches);
+
+    for(std::size_t batch = 0; batch < config.batches; ++batch)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for(std::size_t i = 0; i < config.batch_size; ++i) function();
+        const auto end = std::chrono::steady_clock::now();
+
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        values.push_back(static_cast<double>(ns) / static_cast<double>(config.batch_size));
+    }
+
+    return statistics(name, values);
+}
+
+//! API cost of one timer
+static void api_cost(const std::string &prefix, ITimer &timer, const Config &config, std::vector<Result> &results)
+{
+    std::ofstream null("/dev/null", std::ios::binary);
+    volatile long sink = 0;
+
+    results.push_back(measure_cost(prefix + "/start_stop", config, [&]() {
+        timer.start();
+        timer.stop();
+    }));
+
+    timer.start();
+    bool toggle = false;
+    results.push_back(measure_cost(prefix + "/set_speed_factor", config, [&]() {
+        timer.set_speed_factor((toggle = !toggle) ? 2.0 : 1.0);
+    }));
+    timer.set_speed_to_normal();
+
+    results.push_back(measure_cost(prefix + "/get_timer_value", config, [&]() {
+        sink = sink + timer.get_timer_value_timespec().tv_nsec;
+    }));
+    results.push_back(measure_cost(prefix + "/query_timer_value", config, [&]() {
+        sink = sink + timer.query_timer_value().tv_nsec;
+    }));
+    results.push_back(measure_cost(prefix + "/to_fstream", config, [&]() {
+        timer.to_fstream(null);
+    }));
+
+    // expected error: start of a running timer
+    results.push_back(measure_cost(prefix + "/start_running_throw", config, [&]() {
+        try
+        {
+            timer.start();
+        }
+        catch(const std::logic_error &)
+        {
+            sink = sink + 1;
+        }
+    }));
+    results.push_back(measure_cost(prefix + "/start_running_try", config, [&]() {
+        sink = sink + timer.try_start().value();
+    }));
+    timer.stop();
+}
+
+//! API cost of a header only timer
+template <typename Timer>
+static void static_api_cost(const std::string &prefix, Timer &timer, const Config &config, std::vector<Result> &results)
+{
+    volatile long sink = 0;
+
+    results.push_back(measure_cost(prefix + "/start_stop", config, [&]() {
+        timer.start();
+        timer.stop();
+    }));
+
+    timer.start();
+    bool toggle = false;
+    results.push_back(measure_cost(prefix + "/set_speed_factor", config, [&]() {
+        timer.set_speed_factor((toggle = !toggle) ? 2.0 : 1.0);
+    }));
+    timer.set_speed_to_normal();
+
+    results.push_back(measure_cost(prefix + "/get_timer_value", config, [&]() {
+        sink = sink + timer.get_timer_value().tv_nsec;
+    }));
+    results.push_back(measure_cost(prefix + "/is_running", config, [&]() {
+        sink = sink + timer.is_running();
+    }));
+    timer.stop();
+}
+
+//! operator cost
+static void operator_cost(const Config &config, std::vector<Result> &results)
+{
+    // factors and values are not known at compile time
+    volatile double factor = 1.37;
+    volatile time_t sec = 12345;
+    volatile long frac = 678901;
+    volatile long sink = 0;
+
+    results.push_back(measure_cost("operator/timeval_mul", config, [&]() {
+        timeval time = {sec, frac};
+        time *= factor;
+        sink = sink + time.tv_usec;
+    }));
+    results.push_back(measure_cost("operator/timeval_div", config, [&]() {
+        timeval time = {sec, frac};
+        time /= factor;
+        sink = sink + time.tv_usec;
+    }));
+    results.push_back(measure_cost("operator/itimerval_mul", config, [&]() {
+        itimerval time = {{sec, frac}, {sec, frac}};
+        time = time * factor;
+        sink = sink + time.it_value.tv_usec;
+    }));
+    results.push_back(measure_cost("operator/timespec_mul", config, [&]() {
+        timespec time = {sec, frac};
+        time *= factor;
+        sink = sink + time.tv_nsec;
+    }));
+    results.push_back(measure_cost("operator/timespec_div", config, [&]() {
+        timespec time = {sec, frac};
+        time /= factor;
+        sink = sink + time.tv_nsec;
+    }));
+    results.push_back(measure_cost("operator/itimerspec_mul", config, [&]() {
+        itimerspec time = {{sec, frac}, {sec, frac}};
+        time = time * factor;
+        sink = sink + time.it_value.tv_nsec;
+    }));
+}
+
+// ---------------------------------------------------------------------------
+// latency benchmarks
+// ---------------------------------------------------------------------------
+
+//! reception times of the signal handler
+static std::vector<timespec> received;
+
+//! number of valid entries in received
+static std::atomic<std::size_t> received_count(0);
+
+//! signal handler: store reception time
+static void record_signal(int sig)
+{
+    static_cast<void>(sig);
+
+    const timespec now = monotonic_now();
+    const std::size_t index = received_count.load(std::memory_order_relaxed);
+    if(index < received.size())
+    {
+        received[index] = now;
+        received_count.store(index + 1, std::memory_order_release);
+    }
+}
+
+/*! \brief latency of each reception time
+ *
+ * the k-th expiration (k >= 0) is expected at first + k * interval. The
+ * latency is the time since the last expected expiration (latencies above the
+ * interval are not detected).
+ */
+static Result latency(const std::string &name, const std::vector<timespec> &times,
+        const timespec &first, std::int64_t interval)
+{
+    std::vector<double> values;
+    values.reserve(times.size());
+
+    for(const auto &time : times)
+    {
+        const std::int64_t since_first = nsec(time) - nsec(first);
+        if(since_first < 0) continue;
+        values.push_back(static_cast<double>(since_first % interval));
+    }
+
+    return statistics(name, values);
+}
+
+//! latency of a signal generating timer
+static Result signal_latency(const std::string &name, ITimer &timer, double speed_factor,
+        const Config &config)
+{
+    received.assign(config.expirations, timespec{0, 0});
+    received_count.store(0);
+
+    struct sigaction action, old_action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = record_signal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(timer.get_signal(), &action, &old_action);
+
+    const std::int64_t interval = nsec(timer.get_interval_timespec() / speed_factor);
+
+    timer.set_speed_factor(speed_factor);
+    const timespec start = monotonic_now();
+    timer.start();
+    while(received_count.load(std::memory_order_acquire) < config.expirations) pause();
+    timer.stop();
+    timer.set_speed_to_normal();
+
+    sigaction(timer.get_signal(), &old_action, nullptr);
+
+    const timespec first = nsec_to_timespec(nsec(start) + interval);
+    return latency(name, received, first, interval);
+}
+
+//! latency of a timerfd (wakeup of poll)
+static Result timerfd_latency(const std::string &name, TimerFd &timer, double speed_factor,
+        const Config &config)
+{
+    std::vector<timespec> times;
+    times.reserve(config.expirations);
+
+    const std::int64_t interval = nsec(timer.get_interval_timespec() / speed_factor);
+
+    timer.set_speed_factor(speed_factor);
+    const timespec start = monotonic_now();
+    timer.start();
+    while(times.size() < config.expirations)
+    {
+        pollfd fd = {timer.get_fd(), POLLIN, 0};
+        if(poll(&fd, 1, -1) <= 0) continue;
+        times.push_back(monotonic_now());
+        timer.read_expirations();
+    }
+    timer.stop();
+    timer.set_speed_to_normal();
+
+    const timespec first = nsec_to_timespec(nsec(start) + interval);
+    return latency(name, times, first, interval);
+}
+
+//! lateness of a PrecisionTimer (deadline --> return of wait())
+static Result precision_latency(const std::string &name, PrecisionTimer &timer, double speed_factor,
+        const Config &config)
+{
+    std::vector<double> values;
+    values.reserve(config.expirations);
+
+    const std::int64_t interval = nsec(timer.get_interval_timespec() / speed_factor);
+
+    timer.set_speed_factor(speed_factor);
+    while(values.size() < config.expirations)
+    {
+        const timespec start = monotonic_now();
+        timer.start();
+        timer.wait();
+        values.push_back(static_cast<double>(nsec(monotonic_now()) - nsec(start) - interval));
+    }
+    timer.set_speed_to_normal();
+
+    return statistics(name, values);
+}
+
+//! latency for all wall clock timer types
+static void latency_benchmarks(const Config &config, std::vector<Result> &results)
+{
+    static constexpr long INTERVALS_NS[] = {100000, 1000000, 10000000};
+    static constexpr double SPEED_FACTORS[] = {1.0, 2.0};
+
+    for(long interval_ns : INTERVALS_NS)
+    {
+        const timespec interval = nsec_to_timespec(interval_ns);
+
+        for(double speed_factor : SPEED_FACTORS)
+        {
+            char suffix[64];
+            snprintf(suffix, sizeof(suffix), "/interval_%ldns/speed_%.1f", interval_ns, speed_factor);
+
+            {
+                ITimer_Real timer(timespec_to_timeval(interval));
+                results.push_back(signal_latency(std::string("latency/itimer_real") + suffix,
+                        timer, speed_factor, config));
+            }
+            {
+                PosixTimer_Monotonic timer(interval);
+                results.push_back(signal_latency(std::string("latency/posix_monotonic") + suffix,
+                        timer, speed_factor, config));
+            }
+            {
+                PosixTimer_Boottime timer(interval);
+                results.push_back(signal_latency(std::string("latency/posix_boottime") + suffix,
+                        timer, speed_factor, config));
+            }
+            {
+                TimerFd timer(interval);
+                results.push_back(timerfd_latency(std::string("latency/timerfd") + suffix,
+                        timer, speed_factor, config));
+            }
+            {
+                PrecisionTimer timer(interval);
+                results.push_back(precision_latency(std::string("latency/precision") + suffix,
+                        timer, speed_factor, config));
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// output
+// ---------------------------------------------------------------------------
+
+static void print_csv(const std::vector<Result> &results)
+{
+    printf("benchmark,samples,mean_ns,p50_ns,p90_ns,p99_ns,max_ns,stddev_ns\n");
+    for(const auto &r : results)
+    {
+        printf("%s,%zu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", r.name.c_str(), r.samples,
+                r.mean, r.p50, r.p90, r.p99, r.max, r.stddev);
+    }
+}
+
+static void print_json(const std::vector<Result> &results)
+{
+    printf("{\n  \"version\": %lu,\n  \"benchmarks\": [\n", ITimer::getSourceVersion());
+    for(std::size_t i = 0; i < results.size(); ++i)
+    {
+        const auto &r = results[i];
+        printf("    {\"name\": \"%s\", \"samples\": %zu, \"mean_ns\": %.3f, \"p50_ns\": %.3f, "
+               "\"p90_ns\": %.3f, \"p99_ns\": %.3f, \"max_ns\": %.3f, \"stddev_ns\": %.3f}%s\n",
+                r.name.c_str(), r.samples, r.mean, r.p50, r.p90, r.p99, r.max, r.stddev,
+                i + 1 < results.size() ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+int main(int argc, char **argv)
+{
+    bool json = false;
+    Config config = {200, 1000, 2000};
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(std::strcmp(argv[i], "--json") == 0)
+        {
+            json = true;
+        }
+        else if(std::strcmp(argv[i], "--quick") == 0)
+        {
+            config = {20, 100, 100};
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--json] [--quick]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // timers of the cost benchmarks must not expire
+    signal(SIGALRM, SIG_IGN);
+
+    std::vector<Result> results;
+
+    {
+        ITimer_Real timer(timeval{3600, 0});
+        api_cost("api/itimer_real", timer, config, results);
+    }
+    {
+        StaticITimer_Real timer(timespec{3600, 0});
+        static_api_cost("api/static_itimer_real", timer, config, results);
+    }
+    {
+        PosixTimer_Monotonic timer(timespec{3600, 0});
+        api_cost("api/posix_monotonic", timer, config, results);
+    }
+    {
+        TimerFd timer(timespec{3600, 0});
+        api_cost("api/timerfd", timer, config, results);
+    }
+
+    operator_cost(config, results);
+
+    latency_benchmarks(config, results);
+
+    if(json)
+        print_json(results);
+    else
+        print_csv(results);
+
+    return EXIT_SUCCESS;
+}
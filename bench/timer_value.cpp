@@ -0,0 +1,65 @@
+/*
+ * \file timer_value.cpp
+ * \brief Benchmark: calculated vs. queried timer value
+ *
+ * Compares get_timer_value_timespec() (calculated from the arm time and
+ * clock_gettime) with query_timer_value() (getitimer/timer_gettime) for
+ * running timers.
+ *
+ * output: CSV (benchmark,ns_per_op)
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "ITimer.hpp"
+#include "PosixTimer.hpp"
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace de::Koesling::ITimer;
+
+//! number of operations per benchmark
+static constexpr std::size_t ITERATIONS = 1000000;
+
+//! run benchmark and print result
+template <typename Function>
+static void run(const char *name, Function function)
+{
+    long sink = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i < ITERATIONS; ++i)
+        sink += function().tv_nsec;
+    const auto end = std::chrono::steady_clock::now();
+
+    const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    printf("%s,%.3f\n", name, ns / static_cast<double>(ITERATIONS));
+
+    // prevent optimization
+    if(sink == 42) printf("%ld\n", sink);
+}
+
+int main()
+{
+    // the timers must not expire during the benchmark
+    signal(SIGALRM, SIG_IGN);
+
+    printf("benchmark,ns_per_op\n");
+
+    ITimer_Real real(timeval{3600, 0});
+    real.start();
+    run("itimer_real_query", [&]() { return real.query_timer_value(); });
+    run("itimer_real_calculated", [&]() { return real.get_timer_value_timespec(); });
+    real.stop();
+
+    PosixTimer_Monotonic monotonic(timespec{3600, 0});
+    monotonic.start();
+    monotonic.set_speed_factor(2.0);
+    run("posix_monotonic_query", [&]() { return monotonic.query_timer_value(); });
+    run("posix_monotonic_calculated", [&]() { return monotonic.get_timer_value_timespec(); });
+    monotonic.stop();
+
+    return EXIT_SUCCESS;
+}
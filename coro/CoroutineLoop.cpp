@@ -0,0 +1,315 @@
+/*
+ * \file CoroutineLoop.cpp
+ * \brief Source file de::Koesling::ITimer::CoroutineLoop
+ *
+ * required compiler options:
+ *          -std=c++20 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "CoroutineLoop.hpp"
+#include <cerrno>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <utility>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+void CoroutineLoop::WaitList::push(TickAwaiter &awaiter) noexcept
+{
+    awaiter.prev = tail;
+    awaiter.next = nullptr;
+    if(tail) tail->next = &awaiter;
+    else head = &awaiter;
+    tail = &awaiter;
+}
+
+void CoroutineLoop::WaitList::remove(TickAwaiter &awaiter) noexcept
+{
+    if(awaiter.prev) awaiter.prev->next = awaiter.next;
+    else head = awaiter.next;
+    if(awaiter.next) awaiter.next->prev = awaiter.prev;
+    else tail = awaiter.prev;
+    awaiter.prev = nullptr;
+    awaiter.next = nullptr;
+}
+
+CoroutineLoop::TickAwaiter* CoroutineLoop::WaitList::pop() noexcept
+{
+    TickAwaiter *awaiter = head;
+    if(awaiter) remove(*awaiter);
+    return awaiter;
+}
+
+CoroutineLoop::TickAwaiter::TickAwaiter(Channel &channel, std::uint64_t *seen) noexcept :
+        loop(&channel.loop),
+        channel(&channel),
+        seen(seen),
+        since(0),
+        result(0),
+        prev(nullptr),
+        next(nullptr),
+        handle(),
+        state(State::IDLE)
+{
+}
+
+CoroutineLoop::TickAwaiter::~TickAwaiter()
+{
+    // coroutine destroyed while waiting
+    switch(state)
+    {
+        case State::WAITING:
+            channel->waiters.remove(*this);
+            --loop->waiting;
+            break;
+        case State::READY:
+            loop->ready.remove(*this);
+            --loop->waiting;
+            break;
+        case State::IDLE:
+        default:
+            break;
+    }
+}
+
+bool CoroutineLoop::TickAwaiter::await_ready() noexcept
+{
+    if(!seen || channel->ticks == *seen) return false;
+
+    // stream: unseen expirations
+    result = channel->ticks - *seen;
+    return true;
+}
+
+void CoroutineLoop::TickAwaiter::await_suspend(std::coroutine_handle<> handle) noexcept
+{
+    this->handle = handle;
+    since = seen ? *seen : channel->ticks;
+    channel->waiters.push(*this);
+    state = State::WAITING;
+    ++loop->waiting;
+}
+
+std::uint64_t CoroutineLoop::TickAwaiter::await_resume() noexcept
+{
+    if(seen) *seen += result;
+    return result;
+}
+
+CoroutineLoop::TickStream::TickStream(Channel &channel) noexcept :
+        channel(&channel),
+        seen(channel.ticks)
+{
+}
+
+CoroutineLoop::Channel::Channel(CoroutineLoop &loop, const ITimer &timer, TimerFd *timer_fd) noexcept :
+        loop(loop),
+        timer(timer),
+        timer_fd(timer_fd),
+        pending(0),
+        ticks(0),
+        waiters({nullptr, nullptr})
+{
+}
+
+void CoroutineLoop::Channel::deliver(std::uint64_t expirations) noexcept
+{
+    ticks += expirations;
+
+    while(TickAwaiter *awaiter = waiters.pop())
+    {
+        awaiter->result = ticks - awaiter->since;
+        awaiter->state = TickAwaiter::State::READY;
+        loop.ready.push(*awaiter);
+    }
+}
+
+CoroutineLoop::CoroutineLoop() :
+        event_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+        ready({nullptr, nullptr}),
+        waiting(0)
+{
+    if(event_fd < 0) throw std::system_error(errno, std::system_category(), std::string(__PRETTY_FUNCTION__) + " - eventfd");
+
+    try
+    {
+        reactor.add(event_fd, EPOLLIN, event_callback, this);
+    }
+    catch(...)
+    {
+        close(event_fd);
+        throw;
+    }
+}
+
+CoroutineLoop::~CoroutineLoop()
+{
+    for(auto &entry : channels)
+    {
+        // waiting coroutines are abandoned
+        Channel &channel = entry.second;
+        while(TickAwaiter *awaiter = channel.waiters.pop()) awaiter->state = TickAwaiter::State::IDLE;
+
+        if(channel.timer_fd)
+        {
+            try
+            {
+                reactor.remove(*channel.timer_fd);
+            }
+            catch(const std::exception &)
+            {
+                // reactor is destroyed anyway
+            }
+        }
+    }
+
+    while(TickAwaiter *awaiter = ready.pop()) awaiter->state = TickAwaiter::State::IDLE;
+    close(event_fd);
+}
+
+CoroutineLoop::Channel& CoroutineLoop::channel_of(const ITimer &timer)
+{
+    auto entry = channels.find(&timer);
+    if(entry == channels.end())
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": timer is not attached");
+
+    return entry->second;
+}
+
+CoroutineLoop::Channel& CoroutineLoop::attach(TimerFd &timer)
+{
+    auto entry = channels.emplace(std::piecewise_construct, std::forward_as_tuple(&timer),
+            std::forward_as_tuple(*this, timer, &timer));
+    if(!entry.second)
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": timer is already attached");
+
+    try
+    {
+        reactor.add(timer, timer_callback, &entry.first->second);
+    }
+    catch(...)
+    {
+        channels.erase(entry.first);
+        throw;
+    }
+
+    return entry.first->second;
+}
+
+CoroutineLoop::Channel& CoroutineLoop::attach(const ITimer &timer)
+{
+    auto entry = channels.emplace(std::piecewise_construct, std::forward_as_tuple(&timer),
+            std::forward_as_tuple(*this, timer, nullptr));
+    if(!entry.second)
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": timer is already attached");
+
+    return entry.first->second;
+}
+
+void CoroutineLoop::detach(const ITimer &timer)
+{
+    Channel &channel = channel_of(timer);
+
+    if(channel.timer_fd) reactor.remove(*channel.timer_fd);
+
+    // resumed by run_once() with 0 expirations
+    while(TickAwaiter *awaiter = channel.waiters.pop())
+    {
+        awaiter->result = 0;
+        awaiter->state = TickAwaiter::State::READY;
+        ready.push(*awaiter);
+    }
+
+    channels.erase(&timer);
+}
+
+void CoroutineLoop::notify(Channel &channel, std::uint64_t expirations) noexcept
+{
+    channel.pending.fetch_add(expirations, std::memory_order_release);
+
+    // wake up the loop (async signal safe)
+    const std::uint64_t one = 1;
+    const ssize_t ignored = write(channel.loop.event_fd, &one, sizeof(one));
+    static_cast<void>(ignored);
+}
+
+void CoroutineLoop::dispatch(const SignalDispatcher::Expiration &expiration, void *arg) noexcept
+{
+    const auto overrun = expiration.overrun > 0 ? static_cast<std::uint64_t>(expiration.overrun) : 0;
+    notify(*static_cast<Channel*>(arg), 1 + overrun);
+}
+
+CoroutineLoop::TickAwaiter CoroutineLoop::next_tick(const ITimer &timer)
+{
+    return TickAwaiter(channel_of(timer), nullptr);
+}
+
+CoroutineLoop::TickStream CoroutineLoop::ticks(const ITimer &timer)
+{
+    return TickStream(channel_of(timer));
+}
+
+void CoroutineLoop::timer_callback(TimerFd &timer, std::uint64_t expirations, void *arg)
+{
+    static_cast<void>(timer);
+    if(expirations) static_cast<Channel*>(arg)->deliver(expirations);
+}
+
+void CoroutineLoop::event_callback(int fd, std::uint32_t events, void *arg)
+{
+    static_cast<void>(events);
+    auto loop = static_cast<CoroutineLoop*>(arg);
+
+    std::uint64_t value;
+    if(read(fd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+        throw std::system_error(errno, std::system_category(), std::string(__PRETTY_FUNCTION__) + " - read");
+
+    for(auto &entry : loop->channels)
+    {
+        Channel &channel = entry.second;
+        const std::uint64_t expirations = channel.pending.exchange(0, std::memory_order_acquire);
+        if(expirations) channel.deliver(expirations);
+    }
+}
+
+std::size_t CoroutineLoop::resume_ready()
+{
+    std::size_t count = 0;
+    while(TickAwaiter *awaiter = ready.pop())
+    {
+        awaiter->state = TickAwaiter::State::IDLE;
+        --waiting;
+        ++count;
+        awaiter->handle.resume();
+    }
+    return count;
+}
+
+std::size_t CoroutineLoop::run_once(int timeout)
+{
+    // coroutines of detached timers are ready without event
+    reactor.wait(ready.head ? 0 : timeout);
+    return resume_ready();
+}
+
+void CoroutineLoop::run()
+{
+    while(waiting) run_once();
+}
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
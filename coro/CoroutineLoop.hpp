@@ -0,0 +1,400 @@
+/*
+ * \file CoroutineLoop.hpp
+ * \brief Header file de::Koesling::ITimer::CoroutineLoop
+ *
+ * Only available in the optional coroutine library
+ * (cmake -DITIMER_BUILD_COROUTINES=ON, target Linux_ITimer_coro).
+ *
+ * required compiler options:
+ *          -std=c++20 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include "ITimer.hpp"
+#include "SignalDispatcher.hpp"
+#include "TimerFd.hpp"
+#include "TimerReactor.hpp"
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    /*! \brief class CoroutineLoop
+     *
+     * Event loop that resumes coroutines at timer expirations:
+     *
+     *      co_await loop.next_tick(timer);         // next expiration
+     *
+     *      auto ticks = loop.ticks(timer);         // stream of expirations
+     *      for(;;) co_await ticks.next();          // no expiration is missed
+     *
+     * Any number of coroutines can wait for the same timer. Waiting does not
+     * allocate (the awaiter is an intrusive list node in the coroutine frame)
+     * and needs neither a thread nor a signal handler per coroutine.
+     *
+     * Timers have to be attached before coroutines can wait for them:
+     *      - TimerFd: the loop waits for the file descriptor (TimerReactor).
+     *      - any other ITimer: expirations are reported with notify() (async
+     *        signal safe, thread safe), e.g. by a SignalDispatcher callback
+     *        (see dispatch()) or a SimulatedTimer callback.
+     *
+     * The coroutines are resumed by run_once()/run() (not by the reactor
+     * callbacks or notify()) in the order in which they started to wait.
+     * Resumed coroutines may attach and detach timers. A waiting coroutine may
+     * be destroyed (the awaiter is removed from the loop).
+     * Apart from notify(), the loop is not thread safe.
+     *
+     * gcc generates switch statements without default case for coroutines.
+     * The core library exports -Wswitch-default -Werror, coroutines in code
+     * that is built with these options need
+     * #pragma GCC diagnostic ignored "-Wswitch-default" (push/pop around the
+     * coroutine, see bench/coro.cpp).
+     */
+    class CoroutineLoop
+    {
+        public:
+            class Channel;
+            class TickAwaiter;
+            class TickStream;
+
+        private:
+            //! intrusive FIFO of awaiters (internal use only!)
+            struct WaitList
+            {
+                TickAwaiter *head;
+                TickAwaiter *tail;
+
+                void push(TickAwaiter &awaiter) noexcept;
+                void remove(TickAwaiter &awaiter) noexcept;
+                TickAwaiter* pop() noexcept;
+            };
+
+        public:
+            /*! \brief awaiter for the expiration of a timer (see next_tick(), TickStream::next())
+             *
+             * co_await returns the number of expirations since the coroutine
+             * started to wait (0 if the timer was detached).
+             */
+            class TickAwaiter
+            {
+                private:
+                    //! awaiter state
+                    enum class State
+                    {
+                        IDLE,       //!< not waiting
+                        WAITING,    //!< in the waiter list of the channel
+                        READY       //!< in the ready list of the loop
+                    };
+
+                    //! loop of the channel
+                    CoroutineLoop *loop;
+
+                    //! channel of the timer
+                    Channel *channel;
+
+                    //! expirations already seen by a stream (nullptr: next_tick())
+                    std::uint64_t *seen;
+
+                    //! channel tick count at the start of the wait
+                    std::uint64_t since;
+
+                    //! number of expirations (co_await result)
+                    std::uint64_t result;
+
+                    //! list node
+                    TickAwaiter *prev;
+                    TickAwaiter *next;
+
+                    //! waiting coroutine
+                    std::coroutine_handle<> handle;
+
+                    //! awaiter state
+                    State state;
+
+                    TickAwaiter(Channel &channel, std::uint64_t *seen) noexcept;
+
+                    friend class CoroutineLoop;
+                    friend struct WaitList;
+                    friend class TickStream;
+
+                public:
+                    //! remove a waiting (destroyed) coroutine from the loop
+                    ~TickAwaiter();
+
+                    //! copying is not possible
+                    TickAwaiter(const TickAwaiter &other) = delete;
+                    //! moving is not possible
+                    TickAwaiter(TickAwaiter &&other) = delete;
+                    //! copying is not possible
+                    TickAwaiter& operator=(const TickAwaiter &other) = delete;
+                    //! moving is not possible
+                    TickAwaiter& operator=(TickAwaiter &&other) = delete;
+
+                    //! ready if a stream has unseen expirations
+                    bool await_ready() noexcept;
+
+                    //! enqueue coroutine
+                    void await_suspend(std::coroutine_handle<> handle) noexcept;
+
+                    //! number of expirations
+                    std::uint64_t await_resume() noexcept;
+            };
+
+            /*! \brief expiration stream of a timer (see ticks())
+             *
+             * counts the expirations that the owner has seen. next() completes
+             * immediately if the timer expired since the last call.
+             * Must not be used after the timer was detached.
+             */
+            class TickStream
+            {
+                private:
+                    //! channel of the timer
+                    Channel *channel;
+
+                    //! number of seen expirations
+                    std::uint64_t seen;
+
+                    explicit TickStream(Channel &channel) noexcept;
+
+                    friend class CoroutineLoop;
+
+                public:
+                    /*! \brief wait for the next expiration(s)
+                     *
+                     * co_await returns the number of expirations since the
+                     * last call (0 if the timer was detached).
+                     */
+                    inline TickAwaiter next() noexcept;
+
+                    //! number of expirations seen by the stream
+                    inline std::uint64_t get_seen() const noexcept;
+            };
+
+            //! timer attached to the loop
+            class Channel
+            {
+                private:
+                    //! loop of the channel
+                    CoroutineLoop &loop;
+
+                    //! attached timer
+                    const ITimer &timer;
+
+                    //! timer registered in the reactor (nullptr: expirations reported by notify())
+                    TimerFd *timer_fd;
+
+                    //! expirations reported by notify(), not delivered yet
+                    std::atomic<std::uint64_t> pending;
+
+                    //! number of delivered expirations
+                    std::uint64_t ticks;
+
+                    //! waiting coroutines
+                    WaitList waiters;
+
+                    //! add expirations, move all waiting coroutines to the ready list
+                    void deliver(std::uint64_t expirations) noexcept;
+
+                    friend class CoroutineLoop;
+                    friend class TickAwaiter;
+
+                public:
+                    //! internal use only! (see attach())
+                    Channel(CoroutineLoop &loop, const ITimer &timer, TimerFd *timer_fd) noexcept;
+
+                    //! copying is not possible
+                    Channel(const Channel &other) = delete;
+                    //! moving is not possible
+                    Channel(Channel &&other) = delete;
+                    //! copying is not possible
+                    Channel& operator=(const Channel &other) = delete;
+                    //! moving is not possible
+                    Channel& operator=(Channel &&other) = delete;
+
+                    //! number of delivered expirations
+                    inline std::uint64_t get_ticks() const noexcept;
+            };
+
+        private:
+            //! event loop backend
+            TimerReactor reactor;
+
+            //! eventfd for notify()
+            int event_fd;
+
+            //! attached timers
+            std::unordered_map<const ITimer*, Channel> channels;
+
+            //! coroutines that will be resumed by run_once()
+            WaitList ready;
+
+            //! number of waiting coroutines (including ready)
+            std::size_t waiting;
+
+            //! get channel of an attached timer
+            Channel& channel_of(const ITimer &timer);
+
+            //! resume all ready coroutines
+            std::size_t resume_ready();
+
+            //! reactor callback of TimerFd timers
+            static void timer_callback(TimerFd &timer, std::uint64_t expirations, void *arg);
+
+            //! reactor callback of the eventfd
+            static void event_callback(int fd, std::uint32_t events, void *arg);
+
+        public:
+            /*! \brief create coroutine loop
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            CoroutineLoop();
+
+            /*! \brief destroy loop
+             *
+             * waiting coroutines are not resumed and must not be resumed
+             * later. Attached TimerFd timers are removed from the reactor.
+             */
+            ~CoroutineLoop();
+
+            //! copying is not possible
+            CoroutineLoop(const CoroutineLoop &other) = delete;
+            //! moving is not possible
+            CoroutineLoop(CoroutineLoop &&other) = delete;
+            //! copying is not possible
+            CoroutineLoop& operator=(const CoroutineLoop &other) = delete;
+            //! moving is not possible
+            CoroutineLoop& operator=(CoroutineLoop &&other) = delete;
+
+            /*! \brief attach TimerFd
+             *
+             * the loop waits for the file descriptor of the timer.
+             * The timer must not be destroyed before it is detached.
+             *
+             * possible throws:
+             *      std::logic_error    timer is already attached
+             *      std::system_error   a system call failed
+             */
+            Channel& attach(TimerFd &timer);
+
+            /*! \brief attach timer
+             *
+             * expirations of the timer have to be reported with notify().
+             * The timer must not be destroyed before it is detached.
+             *
+             * possible throws:
+             *      std::logic_error    timer is already attached
+             */
+            Channel& attach(const ITimer &timer);
+
+            /*! \brief detach timer
+             *
+             * waiting coroutines are resumed by the next run_once() (co_await
+             * returns 0).
+             *
+             * possible throws:
+             *      std::logic_error    timer is not attached
+             *      std::system_error   a system call failed
+             */
+            void detach(const ITimer &timer);
+
+            /*! \brief report expirations of a timer
+             *
+             * the waiting coroutines are resumed by the next run_once().
+             * Thread safe and async signal safe.
+             */
+            static void notify(Channel &channel, std::uint64_t expirations = 1) noexcept;
+
+            /*! \brief SignalDispatcher callback
+             *
+             * reports an expiration (arg: Channel of the timer):
+             *      dispatcher.add(timer, CoroutineLoop::dispatch, &loop.attach(timer));
+             */
+            static void dispatch(const SignalDispatcher::Expiration &expiration, void *arg) noexcept;
+
+            /*! \brief wait for the next expiration of timer
+             *
+             * possible throws:
+             *      std::logic_error    timer is not attached
+             */
+            TickAwaiter next_tick(const ITimer &timer);
+
+            /*! \brief expiration stream of timer
+             *
+             * the stream starts with the current expiration count.
+             *
+             * possible throws:
+             *      std::logic_error    timer is not attached
+             */
+            TickStream ticks(const ITimer &timer);
+
+            /*! \brief wait for expirations and resume the waiting coroutines
+             *
+             * attributes:
+             *      timeout: maximum time to wait in milliseconds (-1: infinite)
+             *
+             * returns the number of resumed coroutines (0 on timeout or if
+             * interrupted by a signal)
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             *      any exception of a resumed coroutine
+             */
+            std::size_t run_once(int timeout = -1);
+
+            /*! \brief run until no coroutine is waiting
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             *      any exception of a resumed coroutine
+             */
+            void run();
+
+            //! number of waiting coroutines
+            inline std::size_t get_waiting() const noexcept;
+
+            //! event loop backend (e.g. to wait for other file descriptors)
+            inline TimerReactor& get_reactor() noexcept;
+    };
+
+    inline CoroutineLoop::TickAwaiter CoroutineLoop::TickStream::next() noexcept
+    {
+        return TickAwaiter(*channel, &seen);
+    }
+
+    inline std::uint64_t CoroutineLoop::TickStream::get_seen() const noexcept
+    {
+        return seen;
+    }
+
+    inline std::uint64_t CoroutineLoop::Channel::get_ticks() const noexcept
+    {
+        return ticks;
+    }
+
+    inline std::size_t CoroutineLoop::get_waiting() const noexcept
+    {
+        return waiting;
+    }
+
+    inline TimerReactor& CoroutineLoop::get_reactor() noexcept
+    {
+        return reactor;
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
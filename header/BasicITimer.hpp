@@ -0,0 +1,762 @@
+/*
+ * \file BasicITimer.hpp
+ * \brief Header file de::Koesling::ITimer::BasicITimer (header only)
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include "TimeArithmetic.hpp"
+#include <sys/time.h>
+#include <sys/timerfd.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <unistd.h>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    // -----------------------------------------------------------------------
+    // clock policies
+    //
+    // id         : clock of the timer and of the value prediction
+    // predictable: the remaining time of a running timer can be calculated
+    //              from the clock (no system call to read the timer)
+    // -----------------------------------------------------------------------
+
+    //! CLOCK_MONOTONIC
+    struct Clock_Monotonic
+    {
+        static constexpr clockid_t id = CLOCK_MONOTONIC;
+        static constexpr bool predictable = true;
+    };
+
+    //! CLOCK_BOOTTIME (includes suspend)
+    struct Clock_Boottime
+    {
+        static constexpr clockid_t id = CLOCK_BOOTTIME;
+        static constexpr bool predictable = true;
+    };
+
+    //! CLOCK_REALTIME (the timer value is read from the kernel, the clock can jump)
+    struct Clock_Realtime
+    {
+        static constexpr clockid_t id = CLOCK_REALTIME;
+        static constexpr bool predictable = false;
+    };
+
+    //! CLOCK_PROCESS_CPUTIME_ID
+    struct Clock_ProcessCpu
+    {
+        static constexpr clockid_t id = CLOCK_PROCESS_CPUTIME_ID;
+        static constexpr bool predictable = false;
+    };
+
+    //! user cpu time of the process (Linux cpu clock id of pid 0 with CPUCLOCK_VIRT, see ITIMER_VIRTUAL)
+    struct Clock_ProcessUserCpu
+    {
+        static constexpr clockid_t id = -7;
+        static constexpr bool predictable = false;
+    };
+
+    namespace detail {
+
+        //! throw std::system_error for errno
+        [[noreturn]] inline void throw_system_error(int error, const char *function)
+        {
+            throw std::system_error(std::error_code(error, std::system_category()), function);
+        }
+
+        //! convert std::chrono::duration to timespec (truncated to nanoseconds)
+        template <typename Rep, typename Period>
+        constexpr timespec chrono_to_timespec(const std::chrono::duration<Rep, Period> &duration) noexcept
+        {
+            return nsec_to_timespec(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+        }
+
+        //! convert timespec to timeval (rounded up, a value > 0 must not disarm the timer)
+        constexpr timeval timespec_to_timeval_ceil(const timespec &time) noexcept
+        {
+            return usec_to_timeval(-detail::floor_div(-to_nsec(time), 1000));
+        }
+
+    } /* namespace detail */
+
+    // -----------------------------------------------------------------------
+    // backend policies
+    //
+    // A backend arms and reads one kernel timer:
+    //      signal              : signal at expiration (0: none)
+    //      exclusive           : only one timer per process
+    //      supports<Clock>()   : the backend can be used with Clock
+    //      default_clock       : clock if BasicITimer gets none
+    //      Backend(clockid_t)  : create the kernel timer
+    //      settime()/gettime() : like timer_settime()/timer_gettime()
+    // -----------------------------------------------------------------------
+
+    /*! \brief backend setitimer (ITIMER_REAL, ITIMER_VIRTUAL, ITIMER_PROF)
+     *
+     * Only one instance per type and process is allowed. The check is shared
+     * by all BasicITimer instances with the same type, but not with
+     * ITimer_Real, ITimer_Virtual and ITimer_Prof: do not combine the library
+     * classes with a BasicITimer of the same type.
+     */
+    template <int Type>
+    class Backend_Setitimer
+    {
+            static_assert(Type == ITIMER_REAL || Type == ITIMER_VIRTUAL || Type == ITIMER_PROF,
+                    "invalid setitimer type");
+
+        private:
+            //! only one instance per type and process allowed
+            static std::atomic<bool>& instance_exists() noexcept
+            {
+                static std::atomic<bool> flag(false);
+                return flag;
+            }
+
+        public:
+            static constexpr int type = Type;
+            static constexpr int signal = Type == ITIMER_REAL ? SIGALRM :
+                                         (Type == ITIMER_VIRTUAL ? SIGVTALRM : SIGPROF);
+            static constexpr bool exclusive = true;
+
+            typedef typename std::conditional<Type == ITIMER_REAL, Clock_Monotonic,
+                    typename std::conditional<Type == ITIMER_VIRTUAL,
+                            Clock_ProcessUserCpu, Clock_ProcessCpu>::type>::type default_clock;
+
+            template <typename Clock>
+            static constexpr bool supports() noexcept
+            {
+                return Clock::id == default_clock::id;
+            }
+
+            /*! \brief claim the timer
+             *
+             * possible throws:
+             *      std::logic_error    an instance already exists
+             */
+            explicit Backend_Setitimer(clockid_t clock)
+            {
+                static_cast<void>(clock);
+                if(instance_exists().exchange(true))
+                    throw std::logic_error(std::string(__PRETTY_FUNCTION__) +
+                            ": only one interval timer of each type per process possible");
+            }
+
+            //! release the timer
+            ~Backend_Setitimer()
+            {
+                instance_exists().store(false);
+            }
+
+            Backend_Setitimer(const Backend_Setitimer &other) = delete;
+            Backend_Setitimer& operator=(const Backend_Setitimer &other) = delete;
+
+            //! setitimer (values are rounded up to microseconds)
+            void settime(const itimerspec &new_value, itimerspec *old_value)
+            {
+                itimerval new_val;
+                new_val.it_interval = detail::timespec_to_timeval_ceil(new_value.it_interval);
+                new_val.it_value = detail::timespec_to_timeval_ceil(new_value.it_value);
+
+                itimerval old_val;
+                if(setitimer(Type, &new_val, &old_val) < 0) detail::throw_system_error(errno, "setitimer");
+
+                if(old_value)
+                {
+                    old_value->it_interval = nsec_to_timespec(to_usec(old_val.it_interval) * 1000);
+                    old_value->it_value = nsec_to_timespec(to_usec(old_val.it_value) * 1000);
+                }
+            }
+
+            //! getitimer
+            void gettime(itimerspec &curr_value) const
+            {
+                itimerval val;
+                if(getitimer(Type, &val) < 0) detail::throw_system_error(errno, "getitimer");
+
+                curr_value.it_interval = nsec_to_timespec(to_usec(val.it_interval) * 1000);
+                curr_value.it_value = nsec_to_timespec(to_usec(val.it_value) * 1000);
+            }
+    };
+
+    /*! \brief backend POSIX timer (timer_create) with signal Signal
+     *
+     * si_value.sival_ptr of the signal is nullptr: the backend is not an
+     * ITimer and must not be mistaken for one. The signal must not be shared
+     * with PosixTimer::install_signal_handler(), SignalDispatcher or
+     * TimerService (they do not handle the timer, its expirations are passed
+     * to the previous action, dropped or discarded). Install an own handler
+     * for Signal or use a library class instead.
+     */
+    template <int Signal = SIGALRM>
+    class Backend_PosixTimer
+    {
+            static_assert(Signal > 0 && Signal < NSIG && Signal != SIGKILL && Signal != SIGSTOP,
+                    "invalid signal");
+
+        private:
+            timer_t id;
+
+        public:
+            static constexpr int signal = Signal;
+            static constexpr bool exclusive = false;
+
+            typedef Clock_Monotonic default_clock;
+
+            template <typename Clock>
+            static constexpr bool supports() noexcept
+            {
+                return true;
+            }
+
+            /*! \brief create POSIX timer
+             *
+             * possible throws:
+             *      std::system_error   timer_create failed
+             */
+            explicit Backend_PosixTimer(clockid_t clock)
+            {
+                sigevent event {};
+                event.sigev_notify = SIGEV_SIGNAL;
+                event.sigev_signo = Signal;
+                event.sigev_value.sival_ptr = nullptr;
+                if(timer_create(clock, &event, &id) < 0) detail::throw_system_error(errno, "timer_create");
+            }
+
+            //! delete POSIX timer
+            ~Backend_PosixTimer()
+            {
+                timer_delete(id);
+            }
+
+            Backend_PosixTimer(const Backend_PosixTimer &other) = delete;
+            Backend_PosixTimer& operator=(const Backend_PosixTimer &other) = delete;
+
+            //! timer_settime
+            void settime(const itimerspec &new_value, itimerspec *old_value)
+            {
+                if(timer_settime(id, 0, &new_value, old_value) < 0) detail::throw_system_error(errno, "timer_settime");
+            }
+
+            //! timer_gettime
+            void gettime(itimerspec &curr_value) const
+            {
+                if(timer_gettime(id, &curr_value) < 0) detail::throw_system_error(errno, "timer_gettime");
+            }
+
+            //! get the POSIX timer id
+            timer_t get_id() const noexcept
+            {
+                return id;
+            }
+    };
+
+    /*! \brief backend timerfd (no signal, expirations are read from the fd) */
+    class Backend_TimerFd
+    {
+        private:
+            int fd;
+
+        public:
+            static constexpr int signal = 0;
+            static constexpr bool exclusive = false;
+
+            typedef Clock_Monotonic default_clock;
+
+            template <typename Clock>
+            static constexpr bool supports() noexcept
+            {
+                return Clock::id == CLOCK_MONOTONIC || Clock::id == CLOCK_BOOTTIME || Clock::id == CLOCK_REALTIME;
+            }
+
+            /*! \brief create timerfd (non blocking)
+             *
+             * possible throws:
+             *      std::system_error   timerfd_create failed
+             */
+            explicit Backend_TimerFd(clockid_t clock) :
+                    fd(timerfd_create(clock, TFD_NONBLOCK | TFD_CLOEXEC))
+            {
+                if(fd < 0) detail::throw_system_error(errno, "timerfd_create");
+            }
+
+            //! close timerfd
+            ~Backend_TimerFd()
+            {
+                close(fd);
+            }
+
+            Backend_TimerFd(const Backend_TimerFd &other) = delete;
+            Backend_TimerFd& operator=(const Backend_TimerFd &other) = delete;
+
+            //! timerfd_settime
+            void settime(const itimerspec &new_value, itimerspec *old_value)
+            {
+                if(timerfd_settime(fd, 0, &new_value, old_value) < 0)
+                    detail::throw_system_error(errno, "timerfd_settime");
+            }
+
+            //! timerfd_gettime
+            void gettime(itimerspec &curr_value) const
+            {
+                if(timerfd_gettime(fd, &curr_value) < 0) detail::throw_system_error(errno, "timerfd_gettime");
+            }
+
+            //! get the file descriptor (readable at expiration)
+            int get_fd() const noexcept
+            {
+                return fd;
+            }
+    };
+
+    /*! \brief class BasicITimer
+     *
+     * Header only interval timer without virtual functions. The backend (kernel
+     * timer) and the clock are template parameters, therefore the setitimer
+     * type, the signal and the clock are compile time constants and all
+     * methods (including the time arithmetic) can be inlined.
+     *
+     * Mirrors the ITimer state transitions of start(), stop() and
+     * set_speed_factor() (same exceptions, the speed factor scales interval
+     * and value, a stopped timer keeps its remaining value). The arithmetic
+     * is duplicated on purpose (header only, no virtual calls). The following
+     * ITimer behaviours are deliberately not mirrored:
+     *      - locking: the methods must not be called concurrently
+     *      - drift correction (ITimer::get_corrected_drift()): stop() stores
+     *        the kernel value without correction
+     *      - expired one shot value: ITimer arms a zero value (the timer
+     *        does not expire until it is stopped), BasicITimer starts with
+     *        the interval instead
+     *      - the value of a running timer on a predictable clock is
+     *        calculated from the armed values, not from ITimer's snapshot
+     *        (no expiration counting, see ITimer::record_expiration())
+     *      - no checkpoints, scaled time, statistics or instrumentation
+     *      - no std::error_code API (try_start() etc.), errors are thrown
+     *      - invalid interval or value are rejected by the constructor
+     *        (checked_interval() and checked_value() can be evaluated at
+     *        compile time)
+     *      - the one instance check of the setitimer backends is not shared
+     *        with ITimer_Real, ITimer_Virtual and ITimer_Prof
+     *
+     * Changes of the ITimer semantics have to be applied here as well or
+     * added to this list.
+     *
+     * Use the library classes (ITimer_Real, PosixTimer, TimerFd, ...) if
+     * the timer is shared between threads or used with SignalDispatcher,
+     * TimerService or TimerReactor.
+     */
+    template <typename Backend, typename Clock = typename Backend::default_clock>
+    class BasicITimer final
+    {
+            static_assert(Backend::template supports<Clock>(), "clock is not supported by the backend");
+
+        public:
+            typedef Backend backend_type;
+            typedef Clock clock_type;
+
+            //! signal that is generated at expiration (0: none)
+            static constexpr int signal = Backend::signal;
+
+        private:
+            //! kernel timer
+            Backend backend;
+
+            //! interval (speed factor 1.0)
+            timespec timer_interval;
+
+            //! value of the stopped timer (speed factor 1.0)
+            timespec timer_value;
+
+            //! speed factor
+            double speed_factor;
+
+            //! true if the timer is running
+            bool running;
+
+            //! armed (scaled) values
+            itimerspec armed_value;
+
+            //! time of the last arm (clock time)
+            timespec armed_since;
+
+            //! current time of the clock
+            static timespec now()
+            {
+                timespec ret_val;
+                if(clock_gettime(Clock::id, &ret_val) < 0) detail::throw_system_error(errno, "clock_gettime");
+                return ret_val;
+            }
+
+            //! remaining (scaled) time of the running timer
+            timespec current_value() const;
+
+            //! arm the backend and remember the armed values
+            void arm(const itimerspec &value);
+
+        public:
+            /*! \brief validate a timer value (constexpr)
+             *
+             * returns the value if it is normalized and not negative (zero:
+             * start with the interval). Fails to compile in a constant
+             * expression, throws std::invalid_argument otherwise.
+             */
+            static constexpr timespec checked_value(const timespec &value)
+            {
+                return (value.tv_sec < 0 || value.tv_nsec < 0 || value.tv_nsec >= NSEC_PER_SECOND) ?
+                        throw std::invalid_argument("BasicITimer: value must be normalized and not negative") :
+                        value;
+            }
+
+            /*! \brief validate an interval (constexpr)
+             *
+             * returns the interval if it is positive and normalized.
+             * Fails to compile in a constant expression, throws
+             * std::invalid_argument otherwise.
+             */
+            static constexpr timespec checked_interval(const timespec &interval)
+            {
+                return (interval.tv_sec < 0 || interval.tv_nsec < 0 || interval.tv_nsec >= NSEC_PER_SECOND ||
+                        (interval.tv_sec == 0 && interval.tv_nsec == 0)) ?
+                        throw std::invalid_argument("BasicITimer: interval must be positive and normalized") :
+                        interval;
+            }
+
+            /*! \brief create interval timer
+             *
+             * attributes:
+             *      interval: Interval at which the timer is triggered
+             *
+             * possible throws:
+             *      std::invalid_argument   invalid interval or value
+             *      std::logic_error        an instance already exists
+             *                              (exclusive backends)
+             *      std::system_error       the timer can not be created
+             */
+            explicit BasicITimer(const timespec &interval);
+
+            /*! \brief create interval timer
+             *
+             * attributes:
+             *      interval: Interval at which the timer is triggered
+             *      value   : Time period after which the timer expires for the
+             *                first time
+             *
+             * possible throws: see BasicITimer(const timespec &interval)
+             */
+            BasicITimer(const timespec &interval, const timespec &value);
+
+            /*! \brief create interval timer
+             *
+             * see BasicITimer(const timespec &interval)
+             */
+            template <typename Rep, typename Period>
+            explicit BasicITimer(const std::chrono::duration<Rep, Period> &interval);
+
+            /*! \brief create interval timer
+             *
+             * see BasicITimer(const timespec &interval, const timespec &value)
+             */
+            template <typename Rep1, typename Period1, typename Rep2, typename Period2>
+            BasicITimer(const std::chrono::duration<Rep1, Period1> &interval,
+                    const std::chrono::duration<Rep2, Period2> &value);
+
+            //! destroy instance (stops the timer)
+            ~BasicITimer();
+
+            //! copying is not possible
+            BasicITimer(const BasicITimer &other) = delete;
+            //! moving is not possible
+            BasicITimer(BasicITimer &&other) = delete;
+            //! copying is not possible
+            BasicITimer& operator=(const BasicITimer &other) = delete;
+            //! moving is not possible
+            BasicITimer& operator=(BasicITimer &&other) = delete;
+
+            /*! \brief start timer
+             *
+             * possible throws:
+             *      std::logic_error    timer already started
+             *      std::runtime_error  speed factor too small
+             *      std::system_error   a system call failed
+             */
+            inline void start();
+
+            /*! \brief start timer with value
+             *
+             * see start()
+             *
+             * possible throws:
+             *      std::invalid_argument   invalid value (see checked_value())
+             */
+            inline void start(const timespec &value);
+
+            /*! \brief stop timer
+             *
+             * possible throws:
+             *      std::runtime_error  timer already stopped
+             *      std::system_error   a system call failed
+             */
+            inline void stop();
+
+            /*! \brief set speed factor (re-arms a running timer)
+             *
+             * possible throws:
+             *      std::invalid_argument   invalid speed factor
+             *      std::runtime_error      speed factor too small
+             *      std::system_error       a system call failed
+             */
+            inline void set_speed_factor(double speed_factor);
+
+            //! set speed factor to 1.0 (see set_speed_factor())
+            inline void set_speed_to_normal();
+
+            //! get speed factor
+            inline double get_speed_factor() const noexcept;
+
+            /*! \brief get timer value (speed factor 1.0)
+             *
+             * calculated from the clock if the clock is predictable,
+             * otherwise read from the kernel.
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            inline timespec get_timer_value() const;
+
+            //! get interval (speed factor 1.0)
+            inline timespec get_interval() const noexcept;
+
+            //! true if the timer is running
+            inline bool is_running() const noexcept;
+
+            //! access the backend (e.g. Backend_TimerFd::get_fd())
+            inline const Backend& get_backend() const noexcept;
+    };
+
+    //! setitimer ITIMER_REAL (see ITimer_Real)
+    typedef BasicITimer<Backend_Setitimer<ITIMER_REAL>> StaticITimer_Real;
+
+    //! setitimer ITIMER_VIRTUAL (see ITimer_Virtual)
+    typedef BasicITimer<Backend_Setitimer<ITIMER_VIRTUAL>> StaticITimer_Virtual;
+
+    //! setitimer ITIMER_PROF (see ITimer_Prof)
+    typedef BasicITimer<Backend_Setitimer<ITIMER_PROF>> StaticITimer_Prof;
+
+    //! POSIX timer CLOCK_MONOTONIC (see PosixTimer_Monotonic, SIGALRM: see Backend_PosixTimer)
+    typedef BasicITimer<Backend_PosixTimer<SIGALRM>, Clock_Monotonic> StaticPosixTimer_Monotonic;
+
+    //! timerfd CLOCK_MONOTONIC (see TimerFd)
+    typedef BasicITimer<Backend_TimerFd, Clock_Monotonic> StaticTimerFd;
+
+    template <typename Backend, typename Clock>
+    constexpr int BasicITimer<Backend, Clock>::signal;
+
+    template <typename Backend, typename Clock>
+    BasicITimer<Backend, Clock>::BasicITimer(const timespec &interval) :
+            BasicITimer(interval, interval)
+    {
+    }
+
+    template <typename Backend, typename Clock>
+    BasicITimer<Backend, Clock>::BasicITimer(const timespec &interval, const timespec &value) :
+            backend(Clock::id),
+            timer_interval(checked_interval(interval)),
+            timer_value(checked_value(value)),
+            speed_factor(1.0),
+            running(false),
+            armed_value{{0, 0}, {0, 0}},
+            armed_since{0, 0}
+    {
+    }
+
+    template <typename Backend, typename Clock>
+    template <typename Rep, typename Period>
+    BasicITimer<Backend, Clock>::BasicITimer(const std::chrono::duration<Rep, Period> &interval) :
+            BasicITimer(detail::chrono_to_timespec(interval))
+    {
+    }
+
+    template <typename Backend, typename Clock>
+    template <typename Rep1, typename Period1, typename Rep2, typename Period2>
+    BasicITimer<Backend, Clock>::BasicITimer(const std::chrono::duration<Rep1, Period1> &interval,
+            const std::chrono::duration<Rep2, Period2> &value) :
+            BasicITimer(detail::chrono_to_timespec(interval), detail::chrono_to_timespec(value))
+    {
+    }
+
+    template <typename Backend, typename Clock>
+    BasicITimer<Backend, Clock>::~BasicITimer()
+    {
+        if(!running) return;
+
+        // disarm before the backend is released, errors can not be handled here
+        itimerspec stop_value{{0, 0}, {0, 0}};
+        try
+        {
+            backend.settime(stop_value, nullptr);
+        }
+        catch(const std::system_error &)
+        {
+        }
+    }
+
+    template <typename Backend, typename Clock>
+    void BasicITimer<Backend, Clock>::arm(const itimerspec &value)
+    {
+        backend.settime(value, nullptr);
+        armed_value = value;
+        if(Clock::predictable) armed_since = now();
+    }
+
+    template <typename Backend, typename Clock>
+    timespec BasicITimer<Backend, Clock>::current_value() const
+    {
+        if(!Clock::predictable)
+        {
+            itimerspec curr_value;
+            backend.gettime(curr_value);
+            return curr_value.it_value;
+        }
+
+        const int128_t elapsed = to_nsec(now()) - to_nsec(armed_since);
+        const int128_t value = to_nsec(armed_value.it_value);
+        if(elapsed < value) return nsec_to_timespec(value - elapsed);
+
+        // expired --> reloaded with interval
+        const int128_t interval = to_nsec(armed_value.it_interval);
+        return nsec_to_timespec(interval - (elapsed - value) % interval);
+    }
+
+    template <typename Backend, typename Clock>
+    inline void BasicITimer<Backend, Clock>::start()
+    {
+        if(running) throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": timer already started");
+
+        itimerspec timer_val;
+        timer_val.it_interval = timespec_div(timer_interval, speed_factor);
+        timer_val.it_value = timespec_div(timespec_is_zero(timer_value) ? timer_interval : timer_value, speed_factor);
+
+        if(timespec_is_zero(timer_val.it_interval))
+            throw std::runtime_error(std::string(__PRETTY_FUNCTION__) +
+                    ": invalid timer values due to to a to small speed factor");
+
+        // zero would disarm the timer
+        if(timespec_is_zero(timer_val.it_value)) timer_val.it_value = {0, 1};
+
+        arm(timer_val);
+        running = true;
+    }
+
+    template <typename Backend, typename Clock>
+    inline void BasicITimer<Backend, Clock>::start(const timespec &value)
+    {
+        if(running) throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": timer already started");
+
+        timer_value = checked_value(value);
+        start();
+    }
+
+    template <typename Backend, typename Clock>
+    inline void BasicITimer<Backend, Clock>::stop()
+    {
+        if(!running) throw std::runtime_error(std::string(__PRETTY_FUNCTION__) + ": timer already stopped");
+
+        itimerspec old_value;
+        backend.settime(itimerspec{{0, 0}, {0, 0}}, &old_value);
+
+        timer_value = timespec_mul(old_value.it_value, speed_factor);
+        if(to_nsec(timer_value) < 0) timer_value = {0, 0};
+
+        running = false;
+    }
+
+    // check for nan and inf --> disable direct float equal check warning
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+    template <typename Backend, typename Clock>
+    inline void BasicITimer<Backend, Clock>::set_speed_factor(double speed_factor)
+    {
+        if(speed_factor <= 0.0)
+            throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": Negative values not allowed!");
+
+        if(std::isinf(speed_factor) || std::isnan(speed_factor))
+            throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": invalid double value!");
+
+        if(running && speed_factor != this->speed_factor)
+        {
+            itimerspec timer_val;
+            timer_val.it_interval = timespec_div(timer_interval, speed_factor);
+            timer_val.it_value = timespec_div(timespec_mul(current_value(), this->speed_factor), speed_factor);
+
+            if(timespec_is_zero(timer_val.it_interval))
+                throw std::runtime_error(std::string(__PRETTY_FUNCTION__) +
+                        ": invalid timer values due to to a to small speed factor");
+
+            // zero would disarm the timer
+            if(timespec_is_zero(timer_val.it_value)) timer_val.it_value = {0, 1};
+
+            arm(timer_val);
+        }
+
+        this->speed_factor = speed_factor;
+    }
+#pragma GCC diagnostic pop
+
+    template <typename Backend, typename Clock>
+    inline void BasicITimer<Backend, Clock>::set_speed_to_normal()
+    {
+        set_speed_factor(1.0);
+    }
+
+    template <typename Backend, typename Clock>
+    inline double BasicITimer<Backend, Clock>::get_speed_factor() const noexcept
+    {
+        return speed_factor;
+    }
+
+    template <typename Backend, typename Clock>
+    inline timespec BasicITimer<Backend, Clock>::get_timer_value() const
+    {
+        return running ? timespec_mul(current_value(), speed_factor) : timer_value;
+    }
+
+    template <typename Backend, typename Clock>
+    inline timespec BasicITimer<Backend, Clock>::get_interval() const noexcept
+    {
+        return timer_interval;
+    }
+
+    template <typename Backend, typename Clock>
+    inline bool BasicITimer<Backend, Clock>::is_running() const noexcept
+    {
+        return running;
+    }
+
+    template <typename Backend, typename Clock>
+    inline const Backend& BasicITimer<Backend, Clock>::get_backend() const noexcept
+    {
+        return backend;
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
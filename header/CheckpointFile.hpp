@@ -0,0 +1,127 @@
+/*
+ * \file CheckpointFile.hpp
+ * \brief Header file de::Koesling::ITimer::CheckpointFile
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    /*! \brief class CheckpointFile
+     *
+     * Memory mapped file for timer checkpoints (see ITimer::save_checkpoint()
+     * and ITimer::load_checkpoint()). The checkpoint is written to and read
+     * from the mapped memory directly, without iostreams and copies.
+     *
+     * A checkpoint is written to memory first. sync() writes it to
+     * "<path>.tmp", flushes it to the disk and renames it to path, so a crash
+     * or a failed write leaves the previous checkpoint intact:
+     *
+     *      CheckpointFile file("timers.ckpt", ITimer::checkpoint_size(count));
+     *      ITimer::save_checkpoint(timers, count, file.writable_data(), file.size());
+     *      file.sync();
+     *
+     *      CheckpointFile file("timers.ckpt");
+     *      ITimer::load_checkpoint(timers, count, file.data(), file.size());
+     */
+    class CheckpointFile
+    {
+        private:
+            //! file name
+            std::string path;
+
+            //! mapped memory
+            void *memory;
+
+            //! size of the mapping
+            std::size_t length;
+
+            //! file opened for writing
+            bool writable;
+
+        public:
+            /*! \brief create writable checkpoint memory for a file
+             *
+             * the file is not touched before sync() is called.
+             *
+             * attributes:
+             *      path: file name
+             *      size: file size (see ITimer::checkpoint_size())
+             *
+             * possible throws:
+             *      std::invalid_argument   size is zero
+             *      std::system_error       a system call failed
+             */
+            CheckpointFile(const std::string &path, std::size_t size);
+
+            /*! \brief map existing checkpoint file read only
+             *
+             * possible throws:
+             *      std::invalid_argument   file is empty
+             *      std::system_error       a system call failed
+             */
+            explicit CheckpointFile(const std::string &path);
+
+            //! unmap file (writable: changes after the last sync() are discarded)
+            ~CheckpointFile();
+
+            //! copying is not possible
+            CheckpointFile(const CheckpointFile &other) = delete;
+            //! moving is not possible
+            CheckpointFile(CheckpointFile &&other) = delete;
+            //! copying is not possible
+            CheckpointFile& operator=(const CheckpointFile &other) = delete;
+            //! moving is not possible
+            CheckpointFile& operator=(CheckpointFile &&other) = delete;
+
+            /*! \brief get mapped memory for writing
+             *
+             * possible throws:
+             *      std::logic_error    file is mapped read only
+             */
+            void* writable_data();
+
+            //! get mapped memory
+            inline const void* data() const noexcept;
+
+            //! size of the mapped file
+            inline std::size_t size() const noexcept;
+
+            /*! \brief replace the file with the written checkpoint
+             *
+             * writes "<path>.tmp", fsyncs it, renames it to path and fsyncs
+             * the directory. On failure the previous file is unchanged.
+             * Nothing is done if the file is mapped read only.
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            void sync();
+    };
+
+    inline const void* CheckpointFile::data() const noexcept
+    {
+        return memory;
+    }
+
+    inline std::size_t CheckpointFile::size() const noexcept
+    {
+        return length;
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -0,0 +1,314 @@
+/*
+ * \file CoalescingGroup.hpp
+ * \brief Header file de::Koesling::ITimer::CoalescingGroup
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include "ITimer.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    class CoalescedTimer;
+
+    /*! \brief class CoalescingGroup
+     *
+     * Logical interval timers (CoalescedTimer) with a slack tolerance that
+     * share the wakeups of one thread.
+     *
+     * Each expiration of a timer may be delayed by up to the slack of the
+     * timer: it fires anywhere in the window [expiration, expiration + slack].
+     * wait() sleeps (clock_nanosleep, CLOCK_MONOTONIC) until the latest point
+     * in time at which all timers that have to fire before the earliest
+     * window ends are due. Then it fires all of them with a single wakeup.
+     *
+     * The remaining part of the window is passed to the kernel as the timer
+     * slack of the waiting thread (prctl(PR_SET_TIMERSLACK)). So the kernel
+     * can also coalesce the wakeup with other wakeups of the system. Timer
+     * slack is ignored for realtime threads (SCHED_FIFO, SCHED_RR).
+     *
+     * Instead of wait(), process() can be called by an event loop. The loop
+     * uses get_next_wakeup() as the poll/epoll timeout.
+     *
+     * The group does not use a signal. The group and its timers are not
+     * thread safe. All CoalescedTimer instances must be destroyed before the
+     * group, and not by a callback.
+     */
+    class CoalescingGroup
+    {
+        public:
+            //! wakeup statistics
+            struct Statistics
+            {
+                std::uint64_t wakeups;          //!< wakeups that fired at least one timer
+                std::uint64_t expirations;      //!< fired expirations
+                std::uint64_t saved_wakeups;    //!< expirations that shared a wakeup with another expiration
+                std::uint64_t overruns;         //!< periods that were skipped (late wakeups)
+            };
+
+            //! intrusive list node (internal use only!)
+            struct Node
+            {
+                Node *prev;
+                Node *next;
+                CoalescedTimer *owner;
+            };
+
+        private:
+            //! armed timers (list head)
+            Node armed_list;
+
+            //! number of armed timers
+            std::size_t armed;
+
+            //! pass the window to the kernel (prctl)
+            bool kernel_slack;
+
+            //! statistics
+            Statistics statistics;
+
+            //! fire all timers whose window has started at now (nanoseconds)
+            std::size_t fire(std::int64_t now);
+
+            //! calculate the wakeup window (false: no timer armed)
+            bool window(std::int64_t &earliest, std::int64_t &latest) const noexcept;
+
+            friend class CoalescedTimer;
+
+        public:
+            /*! \brief create coalescing group
+             *
+             * attributes:
+             *      kernel_slack: wait() sets the timer slack of the calling
+             *                    thread to the remaining window
+             */
+            explicit CoalescingGroup(bool kernel_slack = true) noexcept;
+
+            //! destroy group (all timers must be destroyed before)
+            ~CoalescingGroup() = default;
+
+            //! copying is not possible
+            CoalescingGroup(const CoalescingGroup &other) = delete;
+            //! moving is not possible
+            CoalescingGroup(CoalescingGroup &&other) = delete;
+            //! copying is not possible
+            CoalescingGroup& operator=(const CoalescingGroup &other) = delete;
+            //! moving is not possible
+            CoalescingGroup& operator=(CoalescingGroup &&other) = delete;
+
+            /*! \brief wait for the next wakeup and fire the due timers
+             *
+             * returns false (immediately) if no timer is armed, true after
+             * the callbacks of the due timers have been called.
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             *      any exception of a callback (the due timers that were
+             *                                   not fired yet stay armed
+             *                                   and are fired by the next
+             *                                   call)
+             */
+            bool wait();
+
+            /*! \brief fire the due timers without waiting
+             *
+             * returns the number of fired expirations.
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             *      any exception of a callback (the due timers that were
+             *                                   not fired yet stay armed
+             *                                   and are fired by the next
+             *                                   call)
+             */
+            std::size_t process();
+
+            /*! \brief get the next wakeup window (CLOCK_MONOTONIC)
+             *
+             * a wakeup at any time in [earliest, latest] fires the same
+             * timers. Returns false if no timer is armed.
+             */
+            bool get_next_wakeup(timespec &earliest, timespec &latest) const noexcept;
+
+            //! number of armed timers
+            inline std::size_t size() const noexcept;
+
+            //! get wakeup statistics
+            inline Statistics get_statistics() const noexcept;
+
+            /*! \brief set the timer slack of the calling thread
+             *
+             * (prctl(PR_SET_TIMERSLACK), applies to sleeps, poll/epoll
+             * timeouts, ... of the thread; zero is not allowed: 1 ns is used)
+             *
+             * possible throws:
+             *      std::system_error   prctl failed
+             */
+            static void set_thread_slack(const timespec &slack);
+
+            /*! \brief get the timer slack of the calling thread
+             *
+             * possible throws:
+             *      std::system_error   prctl failed
+             */
+            static timespec get_thread_slack();
+    };
+
+    /*! \brief class CoalescedTimer
+     *
+     * logical interval timer of a CoalescingGroup. Start, stop and speed
+     * adjustment work like any other ITimer. Each expiration may be delayed
+     * by up to the slack of the timer (not scaled by the speed factor).
+     *
+     * The callback is called by CoalescingGroup::wait()/process() at each
+     * expiration. Periods that have passed completely are skipped (overrun).
+     */
+    class CoalescedTimer : public ITimer
+    {
+        public:
+            //! expiration callback
+            typedef void (*Callback)(CoalescedTimer &timer, void *arg);
+
+        private:
+            //! group of this timer
+            CoalescingGroup &group;
+
+            //! group list node
+            CoalescingGroup::Node node;
+
+            //! next expiration in nanoseconds (CLOCK_MONOTONIC)
+            std::int64_t expires;
+
+            //! scaled interval in nanoseconds (0 --> one shot)
+            std::int64_t interval;
+
+            //! slack in nanoseconds
+            std::int64_t slack;
+
+            //! expiration callback
+            Callback callback;
+
+            //! callback argument
+            void *arg;
+
+            //! arm/disarm the timer in the group
+            void settime(const itimerspec &new_value, itimerspec *old_value) override;
+
+            //! get the remaining time until the next expiration
+            void gettime(itimerspec &curr_value) const override;
+
+            //! backend of the timer (checkpoints)
+            TimerBackend backend_kind() const noexcept override;
+
+            //! the timer fires within its slack, not at the reference clock
+            bool value_predictable() const noexcept override;
+
+            //! remove timer from the armed list
+            void unlink() noexcept;
+
+            //! remaining time until the next expiration
+            itimerspec remaining() const;
+
+            friend class CoalescingGroup;
+
+        public:
+            /*! \brief create logical interval timer
+             *
+             * attributes:
+             *      group   : coalescing group
+             *      interval: Interval at which the timer is triggered
+             *      slack   : maximum delay of an expiration
+             *      callback: function that is called at each expiration
+             *      arg     : argument for callback
+             */
+            CoalescedTimer(CoalescingGroup &group, const timespec &interval, const timespec &slack,
+                    Callback callback, void *arg = nullptr) noexcept;
+
+            /*! \brief create logical interval timer
+             *
+             * attributes:
+             *      group   : coalescing group
+             *      interval: Interval at which the timer is triggered
+             *      value   : Time period after which the timer expires for the
+             *                first time
+             *      slack   : maximum delay of an expiration
+             *      callback: function that is called at each expiration
+             *      arg     : argument for callback
+             */
+            CoalescedTimer(CoalescingGroup &group, const timespec &interval, const timespec &value,
+                    const timespec &slack, Callback callback, void *arg = nullptr) noexcept;
+
+            /*! \brief create logical interval timer
+             *
+             * see CoalescedTimer(CoalescingGroup &group, const timespec &interval,
+             *                    const timespec &slack, Callback callback, void *arg)
+             */
+            template <typename Rep1, typename Period1, typename Rep2, typename Period2>
+            CoalescedTimer(CoalescingGroup &group, const std::chrono::duration<Rep1, Period1> &interval,
+                    const std::chrono::duration<Rep2, Period2> &slack, Callback callback,
+                    void *arg = nullptr) noexcept;
+
+            //! destroy instance (see ITimer::~ITimer())
+            virtual ~CoalescedTimer( );
+
+            //! copying is not possible
+            CoalescedTimer(const CoalescedTimer &other) = delete;
+            //! moving is not possible
+            CoalescedTimer(CoalescedTimer &&other) = delete;
+            //! copying is not possible
+            CoalescedTimer& operator=(const CoalescedTimer &other) = delete;
+            //! moving is not possible
+            CoalescedTimer& operator=(CoalescedTimer &&other) = delete;
+
+            //! set the slack (applies from the next expiration)
+            inline void set_slack(const timespec &slack) noexcept;
+
+            //! get the slack
+            inline timespec get_slack() const noexcept;
+    };
+
+    inline std::size_t CoalescingGroup::size() const noexcept
+    {
+        return armed;
+    }
+
+    inline CoalescingGroup::Statistics CoalescingGroup::get_statistics() const noexcept
+    {
+        return statistics;
+    }
+
+    template <typename Rep1, typename Period1, typename Rep2, typename Period2>
+    CoalescedTimer::CoalescedTimer(CoalescingGroup &group, const std::chrono::duration<Rep1, Period1> &interval,
+            const std::chrono::duration<Rep2, Period2> &slack, Callback callback, void *arg) noexcept :
+            CoalescedTimer(group, duration_to_timespec(interval), duration_to_timespec(slack), callback, arg)
+    {
+    }
+
+    inline void CoalescedTimer::set_slack(const timespec &slack) noexcept
+    {
+        const auto nsec = to_nsec(slack);
+        this->slack = nsec > 0 ? static_cast<std::int64_t>(nsec) : 0;
+    }
+
+    inline timespec CoalescedTimer::get_slack() const noexcept
+    {
+        return nsec_to_timespec(slack);
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -0,0 +1,278 @@
+/*
+ * \file DeadlineManager.hpp
+ * \brief Header file de::Koesling::ITimer::DeadlineManager
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include "ITimer.hpp"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    /*! \brief class DeadlineManager
+     *
+     * One shot deadlines (e.g. request timeouts) on top of the single
+     * ITimer_Real of the process. Optimized for deadlines that are cancelled
+     * long before they expire:
+     *
+     *      - the deadlines are nodes of an intrusive pairing heap
+     *        (CLOCK_MONOTONIC) in a pool that is allocated by the constructor.
+     *        arm() and cancel() do not allocate memory.
+     *      - arm() is O(1) (meld with the root)
+     *      - cancel() is O(1): the deadline is only marked. Cancelled nodes are
+     *        released when they reach the root or by a purge of the pool
+     *        (if half of the pool consists of cancelled nodes or the pool
+     *        is exhausted)
+     *      - tickless: the timer is re-armed only if the earliest deadline
+     *        changes. A cancel never re-arms the timer; an expiration of a
+     *        cancelled deadline is skipped by process().
+     *
+     * The manager installs a SIGALRM handler that only marks the expiration.
+     * The expired deadlines are processed (and their callbacks are called) by
+     * process(), which has to be called by the user (e.g. in the main loop).
+     *
+     * The manager is not thread safe.
+     */
+    class DeadlineManager
+    {
+        public:
+            //! expiration callback
+            typedef void (*Callback)(void *arg);
+
+            //! handle of an armed deadline
+            struct Deadline
+            {
+                std::uint32_t index;        //!< pool index
+                std::uint32_t generation;   //!< generation of the pool node (detects reuse)
+            };
+
+        private:
+            //! pool node state
+            enum class NodeState : std::uint8_t
+            {
+                FREE,
+                ARMED,
+                CANCELLED
+            };
+
+            //! pool node (pairing heap node or free list entry)
+            struct Node
+            {
+                std::int64_t expires;       //!< deadline in nanoseconds (CLOCK_MONOTONIC)
+                Callback callback;
+                void *arg;
+                std::uint32_t child;        //!< first child (heap)
+                std::uint32_t sibling;      //!< next sibling (heap) or next free node
+                std::uint32_t generation;
+                NodeState state;
+            };
+
+            //! underlying timer
+            ITimer_Real timer;
+
+            //! node pool
+            std::vector<Node> nodes;
+
+            //! heap root (NIL: empty)
+            std::uint32_t root;
+
+            //! first free node (NIL: pool exhausted)
+            std::uint32_t free_list;
+
+            //! number of armed deadlines
+            std::size_t armed;
+
+            //! number of cancelled deadlines that are still in the heap
+            std::size_t cancelled;
+
+            //! deadline the timer is armed for (0: timer not armed)
+            std::int64_t timer_deadline;
+
+            //! number of re-arms of the timer
+            std::uint64_t rearms;
+
+            //! set by the signal handler
+            std::atomic<bool> expired;
+
+            //! signal action that was active before the manager was created
+            struct sigaction old_action;
+
+            //! instance for signal handler
+            static std::atomic<DeadlineManager*> instance;
+
+            //! SIGALRM handler
+            static void signal_handler(int sig);
+
+            //! meld two heaps, returns the new root
+            std::uint32_t meld(std::uint32_t first, std::uint32_t second) noexcept;
+
+            //! two pass pairing of a sibling list, returns the new root
+            std::uint32_t merge_pairs(std::uint32_t first) noexcept;
+
+            //! remove root from the heap
+            std::uint32_t pop() noexcept;
+
+            //! return node to the pool
+            void release(std::uint32_t index) noexcept;
+
+            //! release all cancelled nodes and rebuild the heap (O(pool size))
+            void purge() noexcept;
+
+            //! arm the timer for the earliest deadline (or stop it)
+            void rearm(std::int64_t now);
+
+        public:
+            //! invalid index (empty heap, end of list)
+            static constexpr std::uint32_t NIL = UINT32_MAX;
+
+            /*! \brief create deadline manager
+             *
+             * attributes:
+             *      capacity: maximum number of armed (and not yet released
+             *                cancelled) deadlines
+             *
+             * possible throws:
+             *      std::invalid_argument   capacity is zero or too large
+             *      std::logic_error        an instance of ITimer_Real already exists
+             *      std::system_error       a system call failed
+             */
+            explicit DeadlineManager(std::size_t capacity);
+
+            /*! \brief destroy deadline manager
+             *
+             * the timer is stopped and the previous SIGALRM handler is
+             * restored. Armed deadlines are dropped.
+             */
+            ~DeadlineManager();
+
+            //! copying is not possible
+            DeadlineManager(const DeadlineManager &other) = delete;
+            //! moving is not possible
+            DeadlineManager(DeadlineManager &&other) = delete;
+            //! copying is not possible
+            DeadlineManager& operator=(const DeadlineManager &other) = delete;
+            //! moving is not possible
+            DeadlineManager& operator=(DeadlineManager &&other) = delete;
+
+            /*! \brief arm deadline
+             *
+             * callback is called by process() once the timeout has elapsed,
+             * unless the deadline is cancelled before.
+             *
+             * possible throws:
+             *      std::length_error   pool exhausted
+             *      std::system_error   a system call failed
+             */
+            Deadline arm(const timespec &timeout, Callback callback, void *arg = nullptr);
+
+            /*! \brief arm deadline
+             *
+             * see arm(const timespec &timeout, Callback callback, void *arg)
+             */
+            template <typename Rep, typename Period>
+            inline Deadline arm(const std::chrono::duration<Rep, Period> &timeout,
+                    Callback callback, void *arg = nullptr);
+
+            /*! \brief cancel deadline
+             *
+             * returns false if the deadline has already expired or was
+             * cancelled before.
+             */
+            bool cancel(const Deadline &deadline) noexcept;
+
+            /*! \brief process expired deadlines
+             *
+             * calls the callbacks of all expired deadlines (earliest first)
+             * and re-arms the timer if the earliest deadline has changed.
+             * Callbacks may arm and cancel deadlines.
+             * returns the number of expired deadlines.
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             *      any exception of a callback (the timer is re-armed for
+             *                                   the remaining deadlines,
+             *                                   the next call processes
+             *                                   them)
+             */
+            std::size_t process();
+
+            /*! \brief mark the expiration of the timer
+             *
+             * async signal safe. Called by the internal SIGALRM handler.
+             */
+            inline void notify() noexcept;
+
+            //! true if the timer has expired since the last process()
+            inline bool is_pending() const noexcept;
+
+            //! true if the deadline is armed (not expired and not cancelled)
+            inline bool is_armed(const Deadline &deadline) const noexcept;
+
+            //! number of armed deadlines
+            inline std::size_t size() const noexcept;
+
+            //! size of the node pool
+            inline std::size_t capacity() const noexcept;
+
+            //! number of re-arms of the timer (system calls)
+            inline std::uint64_t get_rearms() const noexcept;
+    };
+
+    template <typename Rep, typename Period>
+    inline DeadlineManager::Deadline DeadlineManager::arm(const std::chrono::duration<Rep, Period> &timeout,
+            Callback callback, void *arg)
+    {
+        return arm(duration_to_timespec(timeout), callback, arg);
+    }
+
+    inline void DeadlineManager::notify() noexcept
+    {
+        expired.store(true, std::memory_order_relaxed);
+    }
+
+    inline bool DeadlineManager::is_pending() const noexcept
+    {
+        return expired.load(std::memory_order_relaxed);
+    }
+
+    inline bool DeadlineManager::is_armed(const Deadline &deadline) const noexcept
+    {
+        return deadline.index < nodes.size() &&
+               nodes[deadline.index].generation == deadline.generation &&
+               nodes[deadline.index].state == NodeState::ARMED;
+    }
+
+    inline std::size_t DeadlineManager::size() const noexcept
+    {
+        return armed;
+    }
+
+    inline std::size_t DeadlineManager::capacity() const noexcept
+    {
+        return nodes.size();
+    }
+
+    inline std::uint64_t DeadlineManager::get_rearms() const noexcept
+    {
+        return rearms;
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -13,8 +13,20 @@
  */
 #pragma once
 
+#include "SeqLock.hpp"
+#include "TimeArithmetic.hpp"
+#ifdef ITIMER_INSTRUMENTATION
+#include "Instrumentation.hpp"
+#endif
 #include <sys/time.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
 #include <fstream>
+#include <mutex>
+#include <system_error>
 
 #define KOESLINGNI_ITIMER_VERSION 001000000ul    //!< Library version
 
@@ -22,36 +34,280 @@ namespace de {
 namespace Koesling {
 namespace ITimer {
 
+    /*! \brief error codes of the non throwing API (see ITimer::try_start())
+     */
+    enum class TimerErrc
+    {
+        already_started = 1,        //!< start of a running timer
+        already_stopped,            //!< stop of a stopped timer
+        speed_factor_too_small,     //!< the scaled interval would be zero
+        speed_factor_not_positive,  //!< speed factor <= 0
+        speed_factor_not_finite,    //!< speed factor is inf or nan
+        backend_failure             //!< the underlying timer failed with an exception that is not a std::system_error
+    };
+
+    //! error category of TimerErrc
+    const std::error_category& timer_category() noexcept;
+
+    //! create error code from TimerErrc
+    inline std::error_code make_error_code(TimerErrc error) noexcept
+    {
+        return std::error_code(static_cast<int>(error), timer_category());
+    }
+
+    /*! \brief kernel timer or mechanism that drives an ITimer (see checkpoints)
+     */
+    enum class TimerBackend : std::uint32_t
+    {
+        other = 0,                  //!< timer class that does not override ITimer::backend_kind()
+        setitimer,                  //!< ITimer_Real, ITimer_Virtual, ITimer_Prof
+        posix_timer,                //!< PosixTimer
+        timerfd,                    //!< TimerFd
+        wheel,                      //!< WheelTimer
+        simulated,                  //!< SimulatedTimer
+        precision,                  //!< PrecisionTimer
+        coalesced                   //!< CoalescedTimer
+    };
+
     /*! Abstract class ITimer
      *
      * General linux interval timer
+     *
+     * All methods can be called concurrently. start(), stop() and the speed
+     * changes are serialized, the const methods read a consistent snapshot of
+     * the timer state (sequence lock) and never block them.
      */
     class ITimer
     {
         private:
-            //! timer value (speed factor 1.0)
-            timeval timer_value;
+            /*! \brief timer type (REAL/VIRTUAL/PROF see man getitimer)
+             *
+             * -1 if the timer is not based on setitimer (see settime())
+             */
+            int type;
 
-            //! timer interval (speed factor 1.0)
-            timeval timer_interval;
+            //! timer state (internal use only!)
+            struct State
+            {
+                //! timer value (speed factor 1.0)
+                timespec timer_value;
 
-            //! timer type (REAL/VIRTUAL/PROF see man getitimer)
-            int type;
+                //! timer interval (speed factor 1.0)
+                timespec timer_interval;
+
+                /*! \brief speed adjustment factor
+                 *
+                 * - ]0;1[   -->  slower
+                 * - ]1;inf[ -->  faster
+                 * - 1       -->  normal speed
+                 */
+                double speed_factor;
+
+                //! timer running indicator
+                bool running;
+
+                //! scaled time that elapsed until the last start/stop/speed change
+                timespec scaled_time;
 
-            /*! \brief speed adjustment factor
+                //! reference clock time of the last start/speed change
+                timespec scaled_since;
+
+                //! timer value that was set at scaled_since (scaled)
+                itimerspec armed_value;
+
+                /*! \brief correction term for speed changes (speed factor 1.0)
+                 *
+                 * difference between the exact timer value and the value that
+                 * was set by the last speed change. Applied at the next speed
+                 * change or stop().
+                 */
+                timespec drift_pending;
+
+                //! cumulative absolute drift that was corrected (speed factor 1.0)
+                timespec drift_corrected;
+
+                //! number of expirations until scaled_since
+                std::uint64_t expirations;
+            };
+
+            /*! \brief state of the writer (internal use only!)
+             *
+             * only accessed with write_mutex locked. Published to snapshot by
+             * publish() after each modification.
+             */
+            State state;
+
+            //! serializes start/stop/speed changes (internal use only!)
+            std::mutex write_mutex;
+
+            //! published state, read by the const methods without locking
+            SeqLock<State> snapshot;
+
+            /*! \brief arm sequence number (internal use only!)
              *
-             * - ]0;1[   -->  slower
-             * - ]1;inf[ -->  faster
-             * - 1       -->  normal speed
+             * odd from the first modification of the underlying timer until
+             * the new state is published. Readers of the underlying timer
+             * retry if it changed.
              */
-            double speed_factor;
+            std::atomic<std::uint64_t> arm_sequence;
 
-            //! timer running indicator
-            bool running;
+            //! locks write_mutex, publishes the state on destruction (internal use only!)
+            class WriteLock
+            {
+                private:
+                    ITimer &timer;
+                    std::lock_guard<std::mutex> lock;
+
+                public:
+                    explicit inline WriteLock(ITimer &timer);
+                    inline ~WriteLock( );
+
+                    //! copying is not possible
+                    WriteLock(const WriteLock &other) = delete;
+                    //! moving is not possible
+                    WriteLock(WriteLock &&other) = delete;
+                    //! copying is not possible
+                    WriteLock& operator=(const WriteLock &other) = delete;
+                    //! moving is not possible
+                    WriteLock& operator=(WriteLock &&other) = delete;
+            };
+
+#ifdef ITIMER_INSTRUMENTATION
+            //! instrumentation counters (modified by const record_expiration())
+            mutable TimerCounters counters;
+#endif
 
             //! internal use only!
             virtual void adjust_speed(double new_factor);
 
+            /*! \brief set the underlying timer (internal use only!)
+             *
+             * arms (or disarms if new_value.it_value is zero) the timer and
+             * stores the previous value in old_value (if not nullptr).
+             * The default implementation uses setitimer (values are rounded up
+             * to microseconds). Timers that are not based on setitimer have to
+             * override this method and gettime().
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            virtual void settime(const itimerspec &new_value, itimerspec *old_value);
+
+            /*! \brief get the underlying timer (internal use only!)
+             *
+             * The default implementation uses getitimer.
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            virtual void gettime(itimerspec &curr_value) const;
+
+            /*! \brief clock the timer counts against (internal use only!)
+             *
+             * The default implementation returns CLOCK_MONOTONIC for
+             * ITIMER_REAL and timers that are not based on setitimer,
+             * CLOCK_PROCESS_CPUTIME_ID (user and system time) for ITIMER_PROF
+             * and the user cpu time clock of the process for ITIMER_VIRTUAL
+             * (Linux cpu clock id, there is no CLOCK_* constant).
+             */
+            virtual clockid_t reference_clock() const noexcept;
+
+            /*! \brief backend of the timer (internal use only!)
+             *
+             * stored in checkpoints, a checkpoint is only loaded into a timer
+             * with the same backend. The default implementation returns
+             * TimerBackend::setitimer for setitimer based timers and
+             * TimerBackend::other otherwise.
+             */
+            virtual TimerBackend backend_kind() const noexcept;
+
+            /*! \brief timer value can be calculated (internal use only!)
+             *
+             * if true, the value of the running timer is calculated from the
+             * time of the last arm and the reference clock instead of reading
+             * the timer (system call). Requires that the timer counts exactly
+             * against the reference clock.
+             * The default implementation returns true for CLOCK_MONOTONIC and
+             * CLOCK_BOOTTIME (clock_gettime without system call, vDSO).
+             */
+            virtual bool value_predictable() const noexcept;
+
+            /*! \brief read reference clock without exception (internal use only!)
+             *
+             * The default implementation reads reference_clock() with
+             * clock_gettime. Returns false (errno is set) on error.
+             * Has to be async signal safe (used by record_expiration()).
+             */
+            virtual bool read_reference_clock(timespec &now) const noexcept;
+
+            /*! \brief read reference clock (internal use only!)
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            timespec reference_time() const;
+
+            //! add the scaled time since scaled_since to scaled_time (internal use only!)
+            void update_scaled_time(const timespec &now) noexcept;
+
+            /*! \brief predicted timer value (internal use only!)
+             *
+             * current value of the running timer (scaled), calculated from
+             * armed_value and the reference clock time since scaled_since.
+             */
+            static timespec predict_value(const State &state, const timespec &now) noexcept;
+
+            //! predicted number of expirations since scaled_since (internal use only!)
+            static std::uint64_t predict_expirations(const State &state, const timespec &now) noexcept;
+
+            //! apply drift_pending and add it to drift_corrected (internal use only!)
+            timespec apply_drift(const timespec &value) noexcept;
+
+            //! publish state to snapshot (internal use only!)
+            inline void publish() noexcept;
+
+            /*! \brief set the underlying timer from a writer (internal use only!)
+             *
+             * calls settime(), marks the underlying timer as modified until
+             * the next publish().
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            void arm(const itimerspec &new_value, itimerspec *old_value);
+
+            /*! \brief read published state (internal use only!)
+             *
+             * If the timer is running, the reference clock (now, if not
+             * nullptr) and the underlying timer (curr_value, if not nullptr)
+             * are read while the state is valid (retried otherwise).
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            State load_state(timespec *now, itimerspec *curr_value = nullptr) const;
+
+            //! scaled time at reference clock time now (internal use only!)
+            static timespec scaled_time_at(const State &state, const timespec &now) noexcept;
+
+            //! timer value (speed factor 1.0) from the scaled value of the underlying timer (internal use only!)
+            static timespec unscaled_value(const State &state, const timespec &value) noexcept;
+
+            //! start timer, WriteLock required (internal use only!)
+            std::error_code start_locked();
+
+            //! stop timer, WriteLock required (internal use only!)
+            std::error_code stop_locked();
+
+            //! change speed factor, WriteLock required (internal use only!)
+            std::error_code set_speed_locked(double speed_factor);
+
+            //! check speed factor range (internal use only!)
+            static std::error_code check_speed_factor(double speed_factor) noexcept;
+
+            //! throw the exception of the throwing API for error (internal use only!)
+            [[noreturn]] static void throw_error(const std::error_code &error, const char *function);
+
             //! error message stream for "non-throwable" errors
             static std::ostream* error_stream;
 
@@ -61,6 +317,11 @@ namespace ITimer {
             //! internal use only!
             ITimer(int type, const timeval &interval,
                     const timeval &value) noexcept;
+            //! internal use only!
+            ITimer(int type, const timespec &interval) noexcept;
+            //! internal use only!
+            ITimer(int type, const timespec &interval,
+                    const timespec &value) noexcept;
 
             //! copying is not possible
             ITimer(const ITimer &other) = delete;
@@ -89,6 +350,31 @@ namespace ITimer {
              */
             void start();
 
+            /*! \brief set timer value and start timer
+             *
+             * possible throws:
+             *      std::runtime_error  timer is already started
+             *      std::system_error   a system call failed
+             */
+            void start(const timeval &value);
+
+            /*! \brief set timer value and start timer
+             *
+             * possible throws:
+             *      std::runtime_error  timer is already started
+             *      std::system_error   a system call failed
+             */
+            void start(const timespec &value);
+
+            /*! \brief set timer value and start timer
+             *
+             * possible throws:
+             *      std::runtime_error  timer is already started
+             *      std::system_error   a system call failed
+             */
+            template <typename Rep, typename Period>
+            inline void start(const std::chrono::duration<Rep, Period> &value);
+
             /*! \brief stop timer
              *
              * possible throws:
@@ -99,7 +385,11 @@ namespace ITimer {
 
             /*! \brief set speed factor
              *
-             * is applied directly, even if the timer is running
+             * is applied directly, even if the timer is running.
+             * A running timer is re-armed with a single system call; the
+             * difference between the predicted and the actual timer value is
+             * corrected at the next speed change or stop()
+             * (see get_corrected_drift()).
              *
              * possible throws:
              *      std::invalid_argument   speed_factor is out of range
@@ -117,10 +407,48 @@ namespace ITimer {
              */
             void set_speed_to_normal();
 
+            /*! \brief start timer (non throwing)
+             *
+             * same as start(), but errors are returned instead of thrown:
+             *      TimerErrc::already_started
+             *      TimerErrc::speed_factor_too_small
+             *      errno of a failed system call (std::system_category())
+             *
+             * An empty error code indicates success. The expected errors
+             * (TimerErrc) neither throw nor allocate memory.
+             */
+            std::error_code try_start() noexcept;
+
+            //! set timer value and start timer (non throwing, see try_start())
+            std::error_code try_start(const timespec &value) noexcept;
+
+            /*! \brief stop timer (non throwing)
+             *
+             * same as stop(), but errors are returned instead of thrown:
+             *      TimerErrc::already_stopped
+             *      errno of a failed system call (std::system_category())
+             */
+            std::error_code try_stop() noexcept;
+
+            /*! \brief set speed factor (non throwing)
+             *
+             * same as set_speed_factor(), but errors are returned instead of
+             * thrown:
+             *      TimerErrc::speed_factor_not_positive
+             *      TimerErrc::speed_factor_not_finite
+             *      TimerErrc::speed_factor_too_small
+             *      errno of a failed system call (std::system_category())
+             */
+            std::error_code try_set_speed_factor(double speed_factor) noexcept;
+
+            //! set speed to normal (non throwing, see try_set_speed_factor())
+            std::error_code try_set_speed_to_normal() noexcept;
+
             /*! \brief write to binary file stream
              *
              * write interval and value to file stream.
              * type and speed factor is not stored!
+             * (see save_checkpoint() for a complete, ABI independent format)
              *
              */
             void to_fstream(std::ofstream& fstream) const;
@@ -135,15 +463,217 @@ namespace ITimer {
              */
             void from_fstream(std::ifstream& fstream);
 
+            //! checkpoint format version
+            static constexpr std::uint16_t CHECKPOINT_VERSION = 2;
+
+            //! size of the checkpoint header in bytes
+            static constexpr std::size_t CHECKPOINT_HEADER_SIZE = 16;
+
+            //! size of one timer record in a checkpoint in bytes
+            static constexpr std::size_t CHECKPOINT_RECORD_SIZE = 72;
+
+            //! size of a checkpoint of count timers in bytes
+            static constexpr std::size_t checkpoint_size(std::size_t count = 1) noexcept;
+
+            /*! \brief write checkpoint to buffer
+             *
+             * The checkpoint contains type, backend, reference clock,
+             * interval, value (speed factor 1.0), speed factor, running
+             * state, scaled time and number of expirations of the timer. The
+             * value of a running timer is read from the underlying timer.
+             *
+             * Format (little endian, independent of the ABI):
+             *      header (16 bytes):
+             *          "ITCP", version (u16), record size (u16), count (u32),
+             *          reserved (u32)
+             *      record (72 bytes, per timer):
+             *          type (i32), flags (u32, bit 0: running),
+             *          speed factor (IEEE 754 binary64),
+             *          value (i64 seconds, u32 nanoseconds),
+             *          interval (u32 nanoseconds, i64 seconds),
+             *          scaled time (i64 seconds, u32 nanoseconds),
+             *          reference clock (i32), expirations (u64),
+             *          backend (u32, TimerBackend), reserved (u32)
+             *
+             * cpu time clocks of a process or thread are stored without the
+             * process/thread id (the checkpoint can be loaded in another
+             * process or thread).
+             *
+             * returns the number of written bytes (checkpoint_size()).
+             *
+             * possible throws:
+             *      std::length_error   buffer is too small
+             *      std::system_error   a system call failed
+             */
+            std::size_t save_checkpoint(void *buffer, std::size_t size) const;
+
+            /*! \brief restore timer from checkpoint (see save_checkpoint())
+             *
+             * The timer must be stopped. It is started if it was running when
+             * the checkpoint was written. Type, backend and reference clock of
+             * the timer must match the checkpoint. All values are validated
+             * before the timer is modified.
+             *
+             * returns the number of read bytes.
+             *
+             * possible throws:
+             *      std::logic_error        timer is not stopped
+             *      std::invalid_argument   invalid checkpoint, unsupported
+             *                              version, different timer type,
+             *                              backend or reference clock
+             *      std::system_error       a system call failed
+             */
+            std::size_t load_checkpoint(const void *buffer, std::size_t size);
+
+            /*! \brief write checkpoint of multiple timers to buffer
+             *
+             * see save_checkpoint()
+             *
+             * possible throws:
+             *      std::length_error   buffer is too small
+             *      std::system_error   a system call failed
+             */
+            static std::size_t save_checkpoint(const ITimer *const *timers, std::size_t count,
+                    void *buffer, std::size_t size);
+
+            /*! \brief restore multiple timers from checkpoint
+             *
+             * The checkpoint is checked completely before the first timer is
+             * modified. The records are assigned to the timers in order.
+             * If a timer can not be started, the timers that were already
+             * loaded are stopped and get their previous state back (unless
+             * stopping fails) before the exception is thrown.
+             * See load_checkpoint().
+             *
+             * possible throws:
+             *      std::logic_error        a timer is not stopped
+             *      std::invalid_argument   invalid checkpoint, unsupported
+             *                              version, different number of timers
+             *                              or different timer type, backend or
+             *                              reference clock
+             *      std::system_error       a system call failed
+             */
+            static std::size_t load_checkpoint(ITimer *const *timers, std::size_t count,
+                    const void *buffer, std::size_t size);
+
             /*! \brief get timer value (non const objects)
              *
              * stored timer value or actual timer value (if running)
+             * (speed factor 1.0).
+             * The value of a running timer is calculated without system call
+             * if possible. It may differ by a few microseconds from the value
+             * of the underlying timer (see query_timer_value()).
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
              */
             timeval get_timer_value() const;
 
+            /*! \brief get timer value with nanosecond resolution
+             *
+             * see get_timer_value()
+             */
+            timespec get_timer_value_timespec() const;
+
+            /*! \brief get timer value as std::chrono::duration
+             *
+             * see get_timer_value()
+             */
+            template <typename Duration>
+            inline Duration get_timer_value() const;
+
+            /*! \brief read timer value from the timer
+             *
+             * same as get_timer_value_timespec(), but the value of a running
+             * timer is always read from the underlying timer (system call).
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            timespec query_timer_value() const;
+
+            /*! \brief get number of expirations
+             *
+             * number of expirations since the creation of the timer,
+             * calculated from the reference clock (no signals are counted).
+             * The value of the running timer is the index of the current
+             * period.
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            std::uint64_t get_expirations() const;
+
+            //! get timer interval (speed factor 1.0)
+            inline timeval get_interval() const noexcept;
+
+            //! get timer interval (speed factor 1.0) with nanosecond resolution
+            inline timespec get_interval_timespec() const noexcept;
+
+            //! get timer interval (speed factor 1.0) as std::chrono::duration
+            template <typename Duration>
+            inline Duration get_interval() const noexcept;
+
+            /*! \brief get scaled time
+             *
+             * time the timer has been running, scaled with the speed factor
+             * (e.g. 2 seconds per second at speed factor 2.0).
+             * The time is measured with the clock the timer counts against
+             * (wall clock or cpu time).
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            timespec get_scaled_time() const;
+
+            //! get scaled time as std::chrono::duration (see get_scaled_time())
+            template <typename Duration>
+            inline Duration get_scaled_time() const;
+
             // get current timer state
             inline bool is_running() const noexcept;
 
+            /*! \brief get cumulative corrected drift
+             *
+             * sum of the absolute differences between the predicted and the
+             * actual timer value of all speed changes that have been corrected
+             * (speed factor 1.0).
+             */
+            inline timespec get_corrected_drift() const noexcept;
+
+            /*! \brief get the signal that is generated at expiration
+             *
+             * SIGALRM (ITIMER_REAL), SIGVTALRM (ITIMER_VIRTUAL), SIGPROF
+             * (ITIMER_PROF) or 0 if the timer does not generate a signal.
+             */
+            virtual int get_signal() const noexcept;
+
+            /*! \brief record an expiration (instrumentation)
+             *
+             * has to be called at each expiration of the timer (e.g. in the
+             * signal handler). Records the lateness (time since the scheduled
+             * expiration) and counts periods that expired without a recorded
+             * expiration as overruns. Called by SignalDispatcher and
+             * TimerFd::read_expirations().
+             *
+             * Async signal safe. Does nothing if the library is built without
+             * ITIMER_INSTRUMENTATION.
+             */
+#ifdef ITIMER_INSTRUMENTATION
+            void record_expiration() const noexcept;
+
+            //! get instrumentation counters (ITIMER_INSTRUMENTATION only)
+            TimerStatistics get_statistics() const noexcept;
+
+            //! get histogram of the expiration lateness in nanoseconds (ITIMER_INSTRUMENTATION only)
+            inline const LatencyHistogram& get_lateness_histogram() const noexcept;
+
+            //! reset instrumentation counters and histogram (ITIMER_INSTRUMENTATION only)
+            void reset_statistics() noexcept;
+#else
+            inline void record_expiration() const noexcept;
+#endif
+
             /*! \brief get the version of the header file
              *
              * only interesting if used as library.
@@ -172,7 +702,7 @@ namespace ITimer {
     {
         private:
             //! only one instance per process allowed
-            static bool instance_exists;
+            static std::atomic<bool> instance_exists;
 
         public:
             /*! \brief create real time interval timer
@@ -197,6 +727,23 @@ namespace ITimer {
              */
             ITimer_Real(const timeval &interval, const timeval &value);
 
+            /*! \brief create real time interval timer
+             *
+             * see ITimer_Real(const timeval &interval)
+             * (rounded up to microseconds, see duration_to_timeval())
+             */
+            template <typename Rep, typename Period>
+            explicit ITimer_Real(const std::chrono::duration<Rep, Period> &interval);
+
+            /*! \brief create real time interval timer
+             *
+             * see ITimer_Real(const timeval &interval, const timeval &value)
+             * (rounded up to microseconds, see duration_to_timeval())
+             */
+            template <typename Rep1, typename Period1, typename Rep2, typename Period2>
+            ITimer_Real(const std::chrono::duration<Rep1, Period1> &interval,
+                    const std::chrono::duration<Rep2, Period2> &value);
+
             //! destroy instance (see ITimer::~ITimer())
             virtual ~ITimer_Real( );
 
@@ -221,7 +768,7 @@ namespace ITimer {
     {
         private:
             //! only one instance per process allowed
-            static bool instance_exists;
+            static std::atomic<bool> instance_exists;
 
         public:
             /*! \brief create user cpu time interval timer
@@ -246,6 +793,23 @@ namespace ITimer {
              */
             ITimer_Virtual(const timeval &interval, const timeval &value);
 
+            /*! \brief create user cpu time interval timer
+             *
+             * see ITimer_Virtual(const timeval &interval)
+             * (rounded up to microseconds, see duration_to_timeval())
+             */
+            template <typename Rep, typename Period>
+            explicit ITimer_Virtual(const std::chrono::duration<Rep, Period> &interval);
+
+            /*! \brief create user cpu time interval timer
+             *
+             * see ITimer_Virtual(const timeval &interval, const timeval &value)
+             * (rounded up to microseconds, see duration_to_timeval())
+             */
+            template <typename Rep1, typename Period1, typename Rep2, typename Period2>
+            ITimer_Virtual(const std::chrono::duration<Rep1, Period1> &interval,
+                    const std::chrono::duration<Rep2, Period2> &value);
+
             //! destroy instance (see ITimer::~ITimer())
             virtual ~ITimer_Virtual( );
 
@@ -275,7 +839,7 @@ namespace ITimer {
     {
         private:
             //! only one instance per process allowed
-            static bool instance_exists;
+            static std::atomic<bool> instance_exists;
 
         public:
             /*! \brief create cpu time interval timer
@@ -300,6 +864,23 @@ namespace ITimer {
              */
             ITimer_Prof(const timeval &interval, const timeval &value);
 
+            /*! \brief create cpu time interval timer
+             *
+             * see ITimer_Prof(const timeval &interval)
+             * (rounded up to microseconds, see duration_to_timeval())
+             */
+            template <typename Rep, typename Period>
+            explicit ITimer_Prof(const std::chrono::duration<Rep, Period> &interval);
+
+            /*! \brief create cpu time interval timer
+             *
+             * see ITimer_Prof(const timeval &interval, const timeval &value)
+             * (rounded up to microseconds, see duration_to_timeval())
+             */
+            template <typename Rep1, typename Period1, typename Rep2, typename Period2>
+            ITimer_Prof(const std::chrono::duration<Rep1, Period1> &interval,
+                    const std::chrono::duration<Rep2, Period2> &value);
+
             //! destroy instance (see ITimer::~ITimer())
             virtual ~ITimer_Prof( );
 
@@ -343,6 +924,80 @@ namespace ITimer {
     //! convert double (seconds) to timeval
     timeval double_to_timeval(const double time) noexcept;
 
+    //! multiply timespec with double factor
+    timespec& operator *= (timespec& left, double right) noexcept;
+
+    //! multiply each timespec of itimerspec with double factor
+    itimerspec& operator *= (itimerspec& left, double right) noexcept;
+
+    //! multiply timespec with double factor
+    timespec operator * (const timespec& left, double right) noexcept;
+
+    //! multiply each timespec of itimerspec with double factor
+    itimerspec operator * (const itimerspec& left, double right) noexcept;
+
+    //! divide timespec by double factor
+    timespec& operator /= (timespec& left, double right) noexcept;
+
+    //! divide each timespec of itimerspec by double factor
+    itimerspec& operator /= (itimerspec& left, double right) noexcept;
+
+    //! divide timespec by double factor
+    timespec operator / (const timespec& left, double right) noexcept;
+
+    //! divide each timespec of itimerspec by double factor
+    itimerspec operator / (const itimerspec& left, double right) noexcept;
+
+    //! convert timespec to double (seconds)
+    double timespec_to_double(const timespec& time) noexcept;
+
+    //! convert double (seconds) to timespec
+    timespec double_to_timespec(const double time) noexcept;
+
+    //! convert timeval to timespec
+    timespec timeval_to_timespec(const timeval& time) noexcept;
+
+    //! convert timespec to timeval (nanoseconds are truncated)
+    timeval timespec_to_timeval(const timespec& time) noexcept;
+
+    /*! \brief convert std::chrono::duration to timeval
+     *
+     * rounded up to microseconds: a positive duration (even below one
+     * nanosecond) never becomes zero, which would disarm the timer.
+     */
+    template <typename Rep, typename Period>
+    constexpr timeval duration_to_timeval(const std::chrono::duration<Rep, Period> &duration) noexcept
+    {
+        return usec_to_timeval(
+                -detail::floor_div(-static_cast<int128_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()), 1000) +
+                ((duration > std::chrono::duration<Rep, Period>::zero() &&
+                  std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() == 0) ? 1 : 0));
+    }
+
+    //! convert std::chrono::duration to timespec (truncated to nanoseconds)
+    template <typename Rep, typename Period>
+    constexpr timespec duration_to_timespec(const std::chrono::duration<Rep, Period> &duration) noexcept
+    {
+        return nsec_to_timespec(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+    //! convert timeval to std::chrono::duration
+    template <typename Duration>
+    constexpr Duration timeval_to_duration(const timeval &time) noexcept
+    {
+        return std::chrono::duration_cast<Duration>(
+                std::chrono::seconds(time.tv_sec) + std::chrono::microseconds(time.tv_usec));
+    }
+
+    //! convert timespec to std::chrono::duration
+    template <typename Duration>
+    constexpr Duration timespec_to_duration(const timespec &time) noexcept
+    {
+        return std::chrono::duration_cast<Duration>(
+                std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec));
+    }
+
     inline unsigned long ITimer::getHeaderVersion() noexcept
     {
         return KOESLINGNI_ITIMER_VERSION;
@@ -350,7 +1005,37 @@ namespace ITimer {
 
     inline bool ITimer::is_running() const noexcept
     {
-    	return running;
+        return snapshot.load().running;
+    }
+
+    inline timespec ITimer::get_corrected_drift() const noexcept
+    {
+        return snapshot.load().drift_corrected;
+    }
+
+    inline void ITimer::publish() noexcept
+    {
+        snapshot.store(state);
+
+        // underlying timer and state are consistent again
+        if(arm_sequence.load(std::memory_order_relaxed) & 1)
+            arm_sequence.fetch_add(1, std::memory_order_release);
+    }
+
+    inline ITimer::WriteLock::WriteLock(ITimer &timer) :
+            timer(timer),
+            lock(timer.write_mutex)
+    {
+    }
+
+    inline ITimer::WriteLock::~WriteLock( )
+    {
+        timer.publish();
+    }
+
+    constexpr std::size_t ITimer::checkpoint_size(std::size_t count) noexcept
+    {
+        return CHECKPOINT_HEADER_SIZE + count * CHECKPOINT_RECORD_SIZE;
     }
 
     inline void ITimer::set_error_stream(std::ostream& stream) noexcept
@@ -358,6 +1043,100 @@ namespace ITimer {
         error_stream = &stream;
     }
 
+#ifdef ITIMER_INSTRUMENTATION
+    inline const LatencyHistogram& ITimer::get_lateness_histogram() const noexcept
+    {
+        return counters.lateness;
+    }
+#else
+    inline void ITimer::record_expiration() const noexcept
+    {
+    }
+#endif
+
+    template <typename Rep, typename Period>
+    inline void ITimer::start(const std::chrono::duration<Rep, Period> &value)
+    {
+        start(duration_to_timespec(value));
+    }
+
+    template <typename Duration>
+    inline Duration ITimer::get_timer_value() const
+    {
+        return timespec_to_duration<Duration>(get_timer_value_timespec());
+    }
+
+    inline timeval ITimer::get_interval() const noexcept
+    {
+        return timespec_to_timeval(get_interval_timespec());
+    }
+
+    inline timespec ITimer::get_interval_timespec() const noexcept
+    {
+        return snapshot.load().timer_interval;
+    }
+
+    template <typename Duration>
+    inline Duration ITimer::get_interval() const noexcept
+    {
+        return timespec_to_duration<Duration>(get_interval_timespec());
+    }
+
+    template <typename Duration>
+    inline Duration ITimer::get_scaled_time() const
+    {
+        return timespec_to_duration<Duration>(get_scaled_time());
+    }
+
+    template <typename Rep, typename Period>
+    ITimer_Real::ITimer_Real(const std::chrono::duration<Rep, Period> &interval) :
+            ITimer_Real(duration_to_timeval(interval))
+    {
+    }
+
+    template <typename Rep1, typename Period1, typename Rep2, typename Period2>
+    ITimer_Real::ITimer_Real(const std::chrono::duration<Rep1, Period1> &interval,
+            const std::chrono::duration<Rep2, Period2> &value) :
+            ITimer_Real(duration_to_timeval(interval), duration_to_timeval(value))
+    {
+    }
+
+    template <typename Rep, typename Period>
+    ITimer_Virtual::ITimer_Virtual(const std::chrono::duration<Rep, Period> &interval) :
+            ITimer_Virtual(duration_to_timeval(interval))
+    {
+    }
+
+    template <typename Rep1, typename Period1, typename Rep2, typename Period2>
+    ITimer_Virtual::ITimer_Virtual(const std::chrono::duration<Rep1, Period1> &interval,
+            const std::chrono::duration<Rep2, Period2> &value) :
+            ITimer_Virtual(duration_to_timeval(interval), duration_to_timeval(value))
+    {
+    }
+
+    template <typename Rep, typename Period>
+    ITimer_Prof::ITimer_Prof(const std::chrono::duration<Rep, Period> &interval) :
+            ITimer_Prof(duration_to_timeval(interval))
+    {
+    }
+
+    template <typename Rep1, typename Period1, typename Rep2, typename Period2>
+    ITimer_Prof::ITimer_Prof(const std::chrono::duration<Rep1, Period1> &interval,
+            const std::chrono::duration<Rep2, Period2> &value) :
+            ITimer_Prof(duration_to_timeval(interval), duration_to_timeval(value))
+    {
+    }
+
 } /* namespace ITimer */
 } /* namespace Koesling */
 } /* namespace de */
+
+namespace std {
+
+    //! allows comparison of std::error_code with TimerErrc
+    template <>
+    struct is_error_code_enum<de::Koesling::ITimer::TimerErrc> : true_type
+    {
+    };
+
+} /* namespace std */
@@ -0,0 +1,194 @@
+/*
+ * \file Instrumentation.hpp
+ * \brief Header file de::Koesling::ITimer::LatencyHistogram and TimerStatistics
+ *
+ * Only used if the library is built with ITIMER_INSTRUMENTATION
+ * (cmake -DITIMER_INSTRUMENTATION=ON).
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    /*! \brief class LatencyHistogram
+     *
+     * HDR style histogram of nanosecond values.
+     *
+     * Values below SUB_BUCKETS are counted exactly. Above, each power of two
+     * is divided into SUB_BUCKETS buckets (relative error below
+     * 1 / SUB_BUCKETS). The full uint64_t range is covered.
+     *
+     * record() is lock free and can be used in signal handlers, as long as
+     * the std::atomic<std::uint64_t> operations are lock free. All other
+     * methods can be called concurrently to record(), but the results are
+     * not an atomic snapshot.
+     */
+    class LatencyHistogram
+    {
+        public:
+            //! number of bits of the sub bucket index
+            static constexpr unsigned SUB_BUCKET_BITS = 4;
+
+            //! number of sub buckets per power of two
+            static constexpr unsigned SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+
+            //! total number of buckets
+            static constexpr unsigned BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        private:
+            //! bucket counters
+            std::atomic<std::uint64_t> buckets[BUCKETS];
+
+            //! number of recorded values
+            std::atomic<std::uint64_t> count;
+
+            //! sum of recorded values (for the mean value)
+            std::atomic<std::uint64_t> sum;
+
+            //! largest recorded value
+            std::atomic<std::uint64_t> max;
+
+        public:
+            //! bucket index of value
+            static inline unsigned bucket_index(std::uint64_t value) noexcept;
+
+            //! largest value of a bucket
+            static inline std::uint64_t bucket_upper_bound(unsigned index) noexcept;
+
+            //! create empty histogram
+            LatencyHistogram() noexcept;
+
+            //! copying is not possible
+            LatencyHistogram(const LatencyHistogram &other) = delete;
+            //! moving is not possible
+            LatencyHistogram(LatencyHistogram &&other) = delete;
+            //! copying is not possible
+            LatencyHistogram& operator=(const LatencyHistogram &other) = delete;
+            //! moving is not possible
+            LatencyHistogram& operator=(LatencyHistogram &&other) = delete;
+
+            //! add value (async signal safe)
+            inline void record(std::uint64_t value) noexcept;
+
+            //! remove all values
+            void reset() noexcept;
+
+            //! number of recorded values
+            inline std::uint64_t get_count() const noexcept;
+
+            //! largest recorded value
+            inline std::uint64_t get_max() const noexcept;
+
+            //! mean value (0 if empty)
+            double get_mean() const noexcept;
+
+            /*! \brief value at percentile
+             *
+             * largest value of the bucket that contains the percentile,
+             * limited to the largest recorded value (0 if empty).
+             *
+             * attributes:
+             *      percentile: percentile [0;100]
+             */
+            std::uint64_t get_value_at_percentile(double percentile) const noexcept;
+
+            //! number of values in bucket index
+            inline std::uint64_t get_bucket_count(unsigned index) const noexcept;
+    };
+
+    //! timer counters (snapshot)
+    struct TimerStatistics
+    {
+        //! number of recorded expirations
+        std::uint64_t expirations;
+
+        //! number of expired periods without recorded expiration (coalesced signals)
+        std::uint64_t overruns;
+
+        //! number of times the timer was armed (start and speed changes)
+        std::uint64_t rearms;
+
+        //! number of system calls to set or get the timer
+        std::uint64_t syscalls;
+    };
+
+    //! timer counters (internal use only!)
+    struct TimerCounters
+    {
+        std::atomic<std::uint64_t> expirations;
+        std::atomic<std::uint64_t> overruns;
+        std::atomic<std::uint64_t> rearms;
+        std::atomic<std::uint64_t> syscalls;
+
+        //! expiration index of the last recorded expiration
+        std::atomic<std::uint64_t> last_index;
+
+        //! expiration lateness
+        LatencyHistogram lateness;
+
+        TimerCounters() noexcept;
+
+        //! reset all counters and the histogram
+        void reset() noexcept;
+    };
+
+    inline unsigned LatencyHistogram::bucket_index(std::uint64_t value) noexcept
+    {
+        if(value < SUB_BUCKETS) return static_cast<unsigned>(value);
+
+        const unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(value));
+        const unsigned shift = msb - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + static_cast<unsigned>((value >> shift) - SUB_BUCKETS);
+    }
+
+    inline std::uint64_t LatencyHistogram::bucket_upper_bound(unsigned index) noexcept
+    {
+        if(index < SUB_BUCKETS) return index;
+
+        const unsigned shift = index / SUB_BUCKETS - 1;
+        const std::uint64_t lower = static_cast<std::uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+        return lower + ((std::uint64_t(1) << shift) - 1);
+    }
+
+    inline void LatencyHistogram::record(std::uint64_t value) noexcept
+    {
+        buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+
+        std::uint64_t current = max.load(std::memory_order_relaxed);
+        while(current < value && !max.compare_exchange_weak(current, value, std::memory_order_relaxed));
+    }
+
+    inline std::uint64_t LatencyHistogram::get_count() const noexcept
+    {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    inline std::uint64_t LatencyHistogram::get_max() const noexcept
+    {
+        return max.load(std::memory_order_relaxed);
+    }
+
+    inline std::uint64_t LatencyHistogram::get_bucket_count(unsigned index) const noexcept
+    {
+        return index < BUCKETS ? buckets[index].load(std::memory_order_relaxed) : 0;
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
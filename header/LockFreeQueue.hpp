@@ -0,0 +1,202 @@
+/*
+ * \file LockFreeQueue.hpp
+ * \brief Header file de::Koesling::ITimer::LockFreeQueue
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    //! assumed cache line size
+    constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+    /*! \brief class LockFreeQueue
+     *
+     * bounded multi producer multi consumer queue (D. Vyukov).
+     * The memory is allocated in the constructor, push() and pop() are lock
+     * free and do not allocate. Both can be used in signal handlers, as long
+     * as the std::atomic<std::size_t> operations are lock free.
+     *
+     * T must be trivially copyable.
+     */
+    template <typename T>
+    class LockFreeQueue
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+        private:
+            //! queue element
+            struct Cell
+            {
+                std::atomic<std::size_t> sequence;
+                T data;
+            };
+
+            //! ring buffer
+            std::unique_ptr<Cell[]> buffer;
+
+            //! capacity - 1 (capacity is a power of 2)
+            std::size_t mask;
+
+            //! separate producer and consumer position
+            char pad0[CACHE_LINE_SIZE];
+
+            //! next position to write
+            std::atomic<std::size_t> enqueue_pos;
+
+            //! separate producer and consumer position
+            char pad1[CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>)];
+
+            //! next position to read
+            std::atomic<std::size_t> dequeue_pos;
+
+            //! separate consumer position from following data
+            char pad2[CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>)];
+
+            //! round up to power of 2
+            static std::size_t round_up(std::size_t value) noexcept;
+
+        public:
+            /*! \brief create queue
+             *
+             * attributes:
+             *      capacity: maximum number of elements (rounded up to a power of 2)
+             *
+             * possible throws:
+             *      std::invalid_argument   capacity is zero
+             *      std::bad_alloc          allocation failed
+             */
+            explicit LockFreeQueue(std::size_t capacity);
+
+            //! copying is not possible
+            LockFreeQueue(const LockFreeQueue &other) = delete;
+            //! moving is not possible
+            LockFreeQueue(LockFreeQueue &&other) = delete;
+            //! copying is not possible
+            LockFreeQueue& operator=(const LockFreeQueue &other) = delete;
+            //! moving is not possible
+            LockFreeQueue& operator=(LockFreeQueue &&other) = delete;
+
+            /*! \brief add element
+             *
+             * returns false if the queue is full
+             */
+            inline bool push(const T &data) noexcept;
+
+            /*! \brief remove element
+             *
+             * returns false if the queue is empty
+             */
+            inline bool pop(T &data) noexcept;
+
+            //! maximum number of elements
+            inline std::size_t capacity() const noexcept;
+    };
+
+    template <typename T>
+    std::size_t LockFreeQueue<T>::round_up(std::size_t value) noexcept
+    {
+        std::size_t ret_val = 1;
+        while(ret_val < value) ret_val <<= 1;
+        return ret_val;
+    }
+
+    template <typename T>
+    LockFreeQueue<T>::LockFreeQueue(std::size_t capacity) :
+            buffer(),
+            mask(round_up(capacity) - 1),
+            enqueue_pos(0),
+            dequeue_pos(0)
+    {
+        if(capacity == 0)
+            throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": capacity must not be zero!");
+
+        buffer.reset(new Cell[mask + 1]);
+        for(std::size_t i = 0; i <= mask; ++i)
+            buffer[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    template <typename T>
+    inline bool LockFreeQueue<T>::push(const T &data) noexcept
+    {
+        Cell *cell;
+        std::size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            cell = &buffer[pos & mask];
+            const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if(diff == 0)
+            {
+                if(enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if(diff < 0)
+            {
+                return false;   // full
+            }
+            else
+            {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = data;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename T>
+    inline bool LockFreeQueue<T>::pop(T &data) noexcept
+    {
+        Cell *cell;
+        std::size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            cell = &buffer[pos & mask];
+            const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if(diff == 0)
+            {
+                if(dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if(diff < 0)
+            {
+                return false;   // empty
+            }
+            else
+            {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        data = cell->data;
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename T>
+    inline std::size_t LockFreeQueue<T>::capacity() const noexcept
+    {
+        return mask + 1;
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -0,0 +1,426 @@
+/*
+ * \file PeriodicExecutor.hpp
+ * \brief Header file de::Koesling::ITimer::PeriodicExecutor
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *          -pthread
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include "TimerFd.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    /*! \brief class PeriodicExecutor
+     *
+     * Runs periodic jobs on a thread pool. A single TimerFd (the tick timer)
+     * drives the schedule: a scheduler thread waits for its ticks and hands
+     * the due jobs to the worker threads.
+     *
+     * Every worker has its own job queue. The scheduler distributes the jobs
+     * round robin, idle workers steal jobs from the queues of busy workers.
+     * Therefore a slow job only delays the jobs in the queue of its worker
+     * until another worker becomes idle.
+     *
+     * Periods and phases are rounded up to multiples of the tick resolution.
+     * The schedule is kept in ticks of the tick timer, i.e. in scaled time:
+     * set_speed_factor() changes the speed of all jobs. stop() pauses the
+     * schedule, start() resumes it.
+     *
+     * A job never runs concurrently with itself. If a job is due while it is
+     * still queued or running, or if periods were missed because the
+     * scheduler fell behind, the overrun policy of the job decides whether
+     * the missed runs are skipped or executed back to back.
+     *
+     * All methods are thread safe.
+     *
+     * Exceptions do not leave the threads of the executor (they would call
+     * std::terminate). They are counted (see get_errors()) and the first one
+     * is stored (see get_error()):
+     *      - an exception of a callback ends the run, the job stays
+     *        scheduled.
+     *      - any other exception (e.g. a failed system call) ends the thread
+     *        that caught it. If the scheduler thread ends, no more runs are
+     *        dispatched (queued runs are still executed); jobs in the queue
+     *        of an ended worker are stolen by the other workers.
+     */
+    class PeriodicExecutor
+    {
+        public:
+            //! job callback
+            typedef void (*Callback)(void *arg);
+
+            //! job identifier
+            typedef std::uint64_t JobId;
+
+            //! schedule of a job
+            enum class Mode
+            {
+                FIXED_RATE,     //!< runs at phase + n * period
+                FIXED_DELAY     //!< runs period after the end of the previous run
+            };
+
+            //! handling of missed runs
+            enum class Overrun
+            {
+                SKIP,           //!< missed runs are dropped (counted as skipped)
+                CATCH_UP        //!< missed runs are executed back to back
+            };
+
+            //! job statistics
+            struct JobStatistics
+            {
+                std::uint64_t runs;         //!< number of completed runs
+                std::uint64_t skipped;      //!< number of skipped runs
+            };
+
+        private:
+            //! registered job
+            struct Job
+            {
+                JobId id;
+                Callback callback;
+                void *arg;
+
+                //! period in ticks
+                std::uint64_t period;
+
+                Mode mode;
+                Overrun overrun;
+
+                //! tick of the next run (valid if scheduled)
+                std::uint64_t due;
+
+                //! in the schedule
+                bool scheduled;
+
+                //! queued or running in a worker
+                bool running;
+
+                //! job was removed while queued or running
+                bool removed;
+
+                //! missed runs that will be executed (CATCH_UP)
+                std::uint64_t owed;
+
+                JobStatistics statistics;
+            };
+
+            //! job queue of a worker
+            struct WorkQueue
+            {
+                std::mutex mutex;
+                std::deque<Job*> jobs;
+            };
+
+            //! tick timer
+            TimerFd tick_timer;
+
+            //! protects jobs, schedule, ticks and next_id
+            mutable std::mutex mutex;
+
+            //! signals the end of a run to remove()
+            std::condition_variable finished;
+
+            //! registered jobs
+            std::unordered_map<JobId, Job> jobs;
+
+            //! scheduled jobs (tick, id)
+            std::set<std::pair<std::uint64_t, JobId>> schedule;
+
+            //! number of processed ticks
+            std::uint64_t ticks;
+
+            //! identifier of the next job
+            JobId next_id;
+
+            //! worker queues
+            std::vector<std::unique_ptr<WorkQueue>> queues;
+
+            //! worker that receives the next job from the scheduler
+            std::size_t next_queue;
+
+            //! protects the sleeping workers
+            std::mutex idle_mutex;
+
+            //! wakes sleeping workers
+            std::condition_variable idle;
+
+            //! number of queued jobs (all queues)
+            std::atomic<std::size_t> queued;
+
+            //! stop indicator for the worker threads
+            std::atomic<bool> terminate;
+
+            //! eventfd that wakes the scheduler thread
+            int event_fd;
+
+            //! scheduler thread
+            std::thread scheduler;
+
+            //! worker threads
+            std::vector<std::thread> workers;
+
+            //! number of exceptions caught in the threads of the executor
+            std::atomic<std::uint64_t> errors;
+
+            //! protects error
+            mutable std::mutex error_mutex;
+
+            //! first exception caught in the threads of the executor
+            std::exception_ptr error;
+
+            //! count exception and store it if it is the first one
+            void record_error(std::exception_ptr exception) noexcept;
+
+            //! number of ticks (rounded up, at least 1) of a time period
+            std::uint64_t to_ticks(const timespec &time) const noexcept;
+
+            //! insert job into the schedule (mutex must be locked)
+            void schedule_job(Job &job, std::uint64_t due);
+
+            //! hand job to a worker (mutex must be locked)
+            void dispatch(Job &job);
+
+            //! take job out of the worker queues (mutex must be locked, false: taken by a worker)
+            bool unqueue(const Job &job);
+
+            //! process ticks, dispatch due jobs
+            void process(std::uint64_t expirations);
+
+            //! get job from own queue or steal it from another worker
+            Job* take(std::size_t index);
+
+            //! run job until no missed run is left
+            void run(Job &job);
+
+            //! scheduler thread (catches all exceptions)
+            void scheduler_thread();
+
+            //! wait for ticks and dispatch the due jobs
+            void scheduler_loop();
+
+            //! worker thread (catches all exceptions)
+            void worker_thread(std::size_t index);
+
+            //! take and run jobs until the executor is destroyed
+            void worker_loop(std::size_t index);
+
+            //! stop and join all threads
+            void shutdown() noexcept;
+
+            //! get registered job (mutex must be locked)
+            Job& job_of(JobId id);
+
+            //! get registered job (mutex must be locked)
+            const Job& job_of(JobId id) const;
+
+        public:
+            /*! \brief create executor
+             *
+             * attributes:
+             *      resolution: length of one tick
+             *      threads   : number of worker threads (0: one per cpu)
+             *
+             * possible throws:
+             *      std::invalid_argument   resolution is zero
+             *      std::system_error       a system call failed
+             */
+            explicit PeriodicExecutor(const timespec &resolution, unsigned threads = 0);
+
+            /*! \brief destroy executor
+             *
+             * the tick timer is stopped. Runs that have already started are
+             * completed, queued runs are discarded.
+             */
+            ~PeriodicExecutor();
+
+            //! copying is not possible
+            PeriodicExecutor(const PeriodicExecutor &other) = delete;
+            //! moving is not possible
+            PeriodicExecutor(PeriodicExecutor &&other) = delete;
+            //! copying is not possible
+            PeriodicExecutor& operator=(const PeriodicExecutor &other) = delete;
+            //! moving is not possible
+            PeriodicExecutor& operator=(PeriodicExecutor &&other) = delete;
+
+            /*! \brief add periodic job
+             *
+             * attributes:
+             *      period  : time between two runs
+             *      phase   : offset of the runs within the period (FIXED_RATE:
+             *                the runs are due at phase + n * period since the
+             *                creation of the executor; FIXED_DELAY: first run)
+             *      callback: function that is called by a worker thread
+             *      arg     : argument for callback
+             *      mode    : FIXED_RATE or FIXED_DELAY
+             *      overrun : SKIP or CATCH_UP
+             *
+             * returns the identifier of the job
+             *
+             * possible throws:
+             *      std::invalid_argument   period is zero or phase is negative
+             */
+            JobId add(const timespec &period, const timespec &phase, Callback callback,
+                    void *arg = nullptr, Mode mode = Mode::FIXED_RATE, Overrun overrun = Overrun::SKIP);
+
+            /*! \brief add periodic job
+             *
+             * see add(const timespec &period, const timespec &phase, Callback callback, void *arg, Mode mode, Overrun overrun)
+             */
+            template <typename Rep1, typename Period1, typename Rep2, typename Period2>
+            inline JobId add(const std::chrono::duration<Rep1, Period1> &period,
+                    const std::chrono::duration<Rep2, Period2> &phase, Callback callback,
+                    void *arg = nullptr, Mode mode = Mode::FIXED_RATE, Overrun overrun = Overrun::SKIP);
+
+            /*! \brief remove job
+             *
+             * waits until a running instance of the job is completed (unless
+             * called by the job itself). A job that is queued but not taken
+             * by a worker yet is removed without waiting.
+             *
+             * possible throws:
+             *      std::logic_error    job is not registered
+             */
+            void remove(JobId id);
+
+            /*! \brief start the tick timer
+             *
+             * possible throws:
+             *      std::logic_error    executor is already started
+             *      std::system_error   a system call failed
+             */
+            inline void start();
+
+            /*! \brief stop the tick timer (the schedule is paused)
+             *
+             * possible throws:
+             *      std::runtime_error  executor is already stopped
+             *      std::system_error   a system call failed
+             */
+            inline void stop();
+
+            //! get tick timer state
+            inline bool is_running() const noexcept;
+
+            /*! \brief set speed factor of all jobs
+             *
+             * see ITimer::set_speed_factor()
+             *
+             * possible throws:
+             *      std::invalid_argument   speed_factor is out of range
+             *      std::system_error       a system call failed
+             */
+            inline void set_speed_factor(double speed_factor);
+
+            /*! \brief set speed factor to 1.0
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            inline void set_speed_to_normal();
+
+            /*! \brief get statistics of a job
+             *
+             * possible throws:
+             *      std::logic_error    job is not registered
+             */
+            JobStatistics get_statistics(JobId id) const;
+
+            //! number of registered jobs
+            std::size_t size() const noexcept;
+
+            //! number of processed ticks
+            std::uint64_t get_ticks() const noexcept;
+
+            //! number of worker threads
+            inline std::size_t get_threads() const noexcept;
+
+            //! number of exceptions caught in the scheduler and worker threads (including callbacks)
+            inline std::uint64_t get_errors() const noexcept;
+
+            /*! \brief first exception caught in the scheduler and worker threads
+             *
+             * nullptr if no exception was caught. Can be rethrown with
+             * std::rethrow_exception().
+             */
+            std::exception_ptr get_error() const;
+
+            //! get the tick timer (e.g. for instrumentation or checkpoints)
+            inline const TimerFd& get_timer() const noexcept;
+    };
+
+    template <typename Rep1, typename Period1, typename Rep2, typename Period2>
+    inline PeriodicExecutor::JobId PeriodicExecutor::add(const std::chrono::duration<Rep1, Period1> &period,
+            const std::chrono::duration<Rep2, Period2> &phase, Callback callback,
+            void *arg, Mode mode, Overrun overrun)
+    {
+        return add(duration_to_timespec(period), duration_to_timespec(phase), callback, arg, mode, overrun);
+    }
+
+    inline void PeriodicExecutor::start()
+    {
+        tick_timer.start();
+    }
+
+    inline void PeriodicExecutor::stop()
+    {
+        tick_timer.stop();
+    }
+
+    inline bool PeriodicExecutor::is_running() const noexcept
+    {
+        return tick_timer.is_running();
+    }
+
+    inline void PeriodicExecutor::set_speed_factor(double speed_factor)
+    {
+        tick_timer.set_speed_factor(speed_factor);
+    }
+
+    inline void PeriodicExecutor::set_speed_to_normal()
+    {
+        tick_timer.set_speed_to_normal();
+    }
+
+    inline std::size_t PeriodicExecutor::get_threads() const noexcept
+    {
+        return workers.size();
+    }
+
+    inline std::uint64_t PeriodicExecutor::get_errors() const noexcept
+    {
+        return errors.load(std::memory_order_relaxed);
+    }
+
+    inline const TimerFd& PeriodicExecutor::get_timer() const noexcept
+    {
+        return tick_timer;
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -0,0 +1,463 @@
+/*
+ * \file PosixTimer.hpp
+ * \brief Header file de::Koesling::ITimer::PosixTimer
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * required linker options:
+ *          -lrt (glibc < 2.34)
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include "ITimer.hpp"
+#include <atomic>
+#include <csignal>
+#include <ctime>
+#include <sys/types.h>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    /*! \brief Abstract class PosixTimer
+     *
+     * Interval timer based on the POSIX per-process timers (see man
+     * timer_create). In contrast to the setitimer based timers, many instances
+     * are possible (at most MAX_HANDLED_TIMERS with the default sigval) and
+     * the timer values have nanosecond resolution.
+     *
+     * At each expiration, the configured signal is generated. The sigval of the
+     * signal (si_value.sival_ptr) identifies the PosixTimer instance: it
+     * encodes a slot of a lock free registry and the generation of the slot
+     * (see from_sigval()). It is not a pointer and must not be dereferenced.
+     *
+     * Realtime signals (see realtime_signal()) in combination with
+     * signal_handler() deliver the expirations of each timer separately: the
+     * handler looks up the timer in O(1) and calls its signal callback with
+     * the overrun count of the event. Many timers can share one signal.
+     * Signals of destroyed timers (stale generation) are not accepted.
+     */
+    class PosixTimer : public ITimer
+    {
+        public:
+            /*! \brief expiration callback of signal_handler()
+             *
+             * called in the signal handler (has to be async signal safe).
+             * overrun: number of additional expirations since the signal was
+             * generated (see get_overrun()).
+             */
+            typedef void (*SignalCallback)(PosixTimer &timer, int overrun, void *arg);
+
+        private:
+            //! clock of the timer
+            clockid_t clock;
+
+            //! POSIX timer id
+            timer_t timer_id;
+
+            //! signal that is generated at expiration
+            int signal_number;
+
+            //! callback of signal_handler()
+            std::atomic<SignalCallback> signal_callback;
+
+            //! argument of the signal callback
+            std::atomic<void*> signal_callback_arg;
+
+            //! slot in the registry of signal_handler() (-1: not registered)
+            int handler_slot;
+
+            //! arm/disarm the timer (timer_settime)
+            void settime(const itimerspec &new_value, itimerspec *old_value) override;
+
+            //! get the timer (timer_gettime)
+            void gettime(itimerspec &curr_value) const override;
+
+            //! backend of the timer (checkpoints)
+            TimerBackend backend_kind() const noexcept override;
+
+            //! clock of the timer
+            clockid_t reference_clock() const noexcept override;
+
+            //! create the POSIX timer
+            void create(const sigevent *event);
+
+            //! remove the timer from the registry of signal_handler() (waits for running handlers)
+            void unregister_handler() noexcept;
+
+        protected:
+            /*! \brief create POSIX interval timer (internal use only!)
+             *
+             * the timer generates signal_number at each expiration.
+             *
+             * possible throws:
+             *      std::system_error   a system call failed (EAGAIN: more
+             *                          than MAX_HANDLED_TIMERS timers)
+             */
+            PosixTimer(clockid_t clock, const timespec &interval,
+                    const timespec &value, int signal_number);
+
+            /*! \brief create POSIX interval timer (internal use only!)
+             *
+             * the timer is created with the given sigevent.
+             * event.sigev_value.sival_ptr is replaced with the encoded registry
+             * slot of this instance if it is nullptr (and the timer generates
+             * a signal). A custom sigval is passed unchanged, the timer is
+             * then not known to signal_handler() and from_sigval().
+             *
+             * possible throws:
+             *      std::system_error   a system call failed (EAGAIN: more
+             *                          than MAX_HANDLED_TIMERS timers)
+             */
+            PosixTimer(clockid_t clock, const timespec &interval,
+                    const timespec &value, const sigevent &event);
+
+            //! copying is not possible
+            PosixTimer(const PosixTimer &other) = delete;
+            //! moving is not possible
+            PosixTimer(PosixTimer &&other) = delete;
+            //! copying is not possible
+            PosixTimer& operator=(const PosixTimer &other) = delete;
+            //! moving is not possible
+            PosixTimer& operator=(PosixTimer &&other) = delete;
+
+        public:
+            //! maximum number of timers that are handled by signal_handler() at the same time
+            static constexpr std::size_t MAX_HANDLED_TIMERS = 4096;
+
+            //! destroy instance (see ITimer::~ITimer())
+            virtual ~PosixTimer( );
+
+            /*! \brief get the overrun count of the last expiration
+             *
+             * number of additional expirations that occurred between the
+             * generation and the delivery of the last signal.
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            int get_overrun() const;
+
+            //! get the POSIX timer id
+            inline timer_t get_id() const noexcept;
+
+            //! get the clock of the timer
+            inline clockid_t get_clock() const noexcept;
+
+            //! get the signal that is generated at expiration
+            int get_signal() const noexcept override;
+
+            /*! \brief set the callback of signal_handler()
+             *
+             * callback: called in the signal handler at each expiration
+             *           (nullptr: none)
+             * Should be set while the timer is stopped.
+             */
+            void set_signal_callback(SignalCallback callback, void *arg = nullptr) noexcept;
+
+            /*! \brief signal handler for POSIX timers (SA_SIGINFO)
+             *
+             * looks up the timer of si_value (O(1), see from_sigval()), records
+             * the expiration and calls the signal callback of the timer with
+             * si_overrun. Only timers that were created with the default
+             * sigval and are not destroyed yet are accepted. All other signals
+             * (e.g. not generated by a timer, sival_ptr of a custom sigevent,
+             * pending signal of a destroyed timer) are passed to the action
+             * that was replaced by install_signal_handler() (ignored if it is
+             * SIG_DFL or SIG_IGN).
+             */
+            static void signal_handler(int sig, siginfo_t *info, void *context);
+
+            /*! \brief timer of the sigval of a signal (async signal safe)
+             *
+             * returns nullptr if the sigval was not generated by a registered
+             * timer or the timer was destroyed. The timer is not protected
+             * against concurrent destruction: use the result as lookup key
+             * unless the lifetime of the timer is guaranteed otherwise.
+             */
+            static PosixTimer* from_sigval(const sigval &value) noexcept;
+
+            /*! \brief install signal_handler() for a signal
+             *
+             * the previous action is stored in old_action (if not nullptr) and
+             * is called by signal_handler() for foreign signals.
+             *
+             * possible throws:
+             *      std::invalid_argument   invalid signal
+             *      std::system_error       a system call failed
+             */
+            static void install_signal_handler(int signal_number, struct sigaction *old_action = nullptr);
+    };
+
+    /*! \brief realtime signal SIGRTMIN + n
+     *
+     * Realtime signals are not coalesced with the signals of other timers.
+     * A timer has at most one pending signal, further expirations are
+     * reported as overrun (si_overrun, PosixTimer::get_overrun()).
+     *
+     * possible throws:
+     *      std::invalid_argument   SIGRTMIN + n is not a realtime signal
+     */
+    int realtime_signal(int n);
+
+    /*! \brief class PosixTimer_Monotonic
+     *
+     * counts down in monotonic wall clock time (CLOCK_MONOTONIC).
+     * Not affected by changes of the system time. Does not count while the
+     * system is suspended.
+     * At each expiration, a SIGALRM signal (or the given signal) is generated.
+     */
+    class PosixTimer_Monotonic : public PosixTimer
+    {
+        public:
+            /*! \brief create monotonic interval timer
+             *
+             * attributes:
+             *      interval     : Interval at which the timer is triggered
+             *      signal_number: signal that is generated at expiration
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            explicit PosixTimer_Monotonic(const timespec &interval, int signal_number = SIGALRM);
+
+            /*! \brief create monotonic interval timer
+             *
+             * attributes:
+             *      interval     : Interval at which the timer is triggered
+             *      value        : Time period after which the timer expires
+             *                     for the first time
+             *      signal_number: signal that is generated at expiration
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            PosixTimer_Monotonic(const timespec &interval, const timespec &value,
+                    int signal_number = SIGALRM);
+
+            //! create monotonic interval timer (see ITimer_Real::ITimer_Real())
+            explicit PosixTimer_Monotonic(const timeval &interval);
+
+            //! create monotonic interval timer (see ITimer_Real::ITimer_Real())
+            PosixTimer_Monotonic(const timeval &interval, const timeval &value);
+
+            //! destroy instance (see ITimer::~ITimer())
+            virtual ~PosixTimer_Monotonic( ) = default;
+    };
+
+    /*! \brief class PosixTimer_Realtime
+     *
+     * counts down in wall clock time (CLOCK_REALTIME).
+     * At each expiration, a SIGALRM signal (or the given signal) is generated.
+     */
+    class PosixTimer_Realtime : public PosixTimer
+    {
+        public:
+            /*! \brief create real time interval timer
+             *
+             * attributes:
+             *      interval     : Interval at which the timer is triggered
+             *      signal_number: signal that is generated at expiration
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            explicit PosixTimer_Realtime(const timespec &interval, int signal_number = SIGALRM);
+
+            /*! \brief create real time interval timer
+             *
+             * attributes:
+             *      interval     : Interval at which the timer is triggered
+             *      value        : Time period after which the timer expires
+             *                     for the first time
+             *      signal_number: signal that is generated at expiration
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            PosixTimer_Realtime(const timespec &interval, const timespec &value,
+                    int signal_number = SIGALRM);
+
+            //! create real time interval timer (see ITimer_Real::ITimer_Real())
+            explicit PosixTimer_Realtime(const timeval &interval);
+
+            //! create real time interval timer (see ITimer_Real::ITimer_Real())
+            PosixTimer_Realtime(const timeval &interval, const timeval &value);
+
+            //! destroy instance (see ITimer::~ITimer())
+            virtual ~PosixTimer_Realtime( ) = default;
+    };
+
+    /*! \brief class PosixTimer_Process
+     *
+     * counts down against the total (user and system) CPU time consumed by
+     * the process (CLOCK_PROCESS_CPUTIME_ID).
+     * At each expiration, a SIGPROF signal (or the given signal) is generated.
+     */
+    class PosixTimer_Process : public PosixTimer
+    {
+        public:
+            /*! \brief create cpu time interval timer
+             *
+             * attributes:
+             *      interval     : Interval at which the timer is triggered
+             *      signal_number: signal that is generated at expiration
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            explicit PosixTimer_Process(const timespec &interval, int signal_number = SIGPROF);
+
+            /*! \brief create cpu time interval timer
+             *
+             * attributes:
+             *      interval     : Interval at which the timer is triggered
+             *      value        : Time period after which the timer expires
+             *                     for the first time
+             *      signal_number: signal that is generated at expiration
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            PosixTimer_Process(const timespec &interval, const timespec &value,
+                    int signal_number = SIGPROF);
+
+            //! create cpu time interval timer (see ITimer_Prof::ITimer_Prof())
+            explicit PosixTimer_Process(const timeval &interval);
+
+            //! create cpu time interval timer (see ITimer_Prof::ITimer_Prof())
+            PosixTimer_Process(const timeval &interval, const timeval &value);
+
+            //! destroy instance (see ITimer::~ITimer())
+            virtual ~PosixTimer_Process( ) = default;
+    };
+
+    /*! \brief class PosixTimer_Boottime
+     *
+     * counts down in monotonic wall clock time including the time the system
+     * is suspended (CLOCK_BOOTTIME).
+     * At each expiration, a SIGALRM signal (or the given signal) is generated.
+     */
+    class PosixTimer_Boottime : public PosixTimer
+    {
+        public:
+            /*! \brief create boot time interval timer
+             *
+             * attributes:
+             *      interval     : Interval at which the timer is triggered
+             *      signal_number: signal that is generated at expiration
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            explicit PosixTimer_Boottime(const timespec &interval, int signal_number = SIGALRM);
+
+            /*! \brief create boot time interval timer
+             *
+             * attributes:
+             *      interval     : Interval at which the timer is triggered
+             *      value        : Time period after which the timer expires
+             *                     for the first time
+             *      signal_number: signal that is generated at expiration
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            PosixTimer_Boottime(const timespec &interval, const timespec &value,
+                    int signal_number = SIGALRM);
+
+            //! create boot time interval timer (see ITimer_Real::ITimer_Real())
+            explicit PosixTimer_Boottime(const timeval &interval);
+
+            //! create boot time interval timer (see ITimer_Real::ITimer_Real())
+            PosixTimer_Boottime(const timeval &interval, const timeval &value);
+
+            //! destroy instance (see ITimer::~ITimer())
+            virtual ~PosixTimer_Boottime( ) = default;
+    };
+
+    /*! \brief class PosixTimer_Thread
+     *
+     * counts down against the CPU time consumed by one thread
+     * (pthread_getcpuclockid). The thread is the thread that creates the
+     * timer.
+     * At each expiration, a SIGPROF signal (or the given signal) is generated
+     * and delivered to this thread (SIGEV_THREAD_ID).
+     *
+     * In contrast to ITimer_Virtual, ITimer_Prof and PosixTimer_Process, the
+     * CPU time of other threads is not counted. This allows to measure and
+     * limit the CPU time of each thread of a thread pool.
+     *
+     * The timer can be controlled from any thread, but must not be used after
+     * the thread has terminated.
+     */
+    class PosixTimer_Thread : public PosixTimer
+    {
+        private:
+            //! kernel thread id of the thread
+            pid_t thread_id;
+
+        public:
+            /*! \brief create thread cpu time interval timer
+             *
+             * attributes:
+             *      interval     : Interval at which the timer is triggered
+             *      signal_number: signal that is generated at expiration
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            explicit PosixTimer_Thread(const timespec &interval, int signal_number = SIGPROF);
+
+            /*! \brief create thread cpu time interval timer
+             *
+             * attributes:
+             *      interval     : Interval at which the timer is triggered
+             *      value        : Time period after which the timer expires
+             *                     for the first time
+             *      signal_number: signal that is generated at expiration
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            PosixTimer_Thread(const timespec &interval, const timespec &value,
+                    int signal_number = SIGPROF);
+
+            //! create thread cpu time interval timer (see ITimer_Prof::ITimer_Prof())
+            explicit PosixTimer_Thread(const timeval &interval);
+
+            //! create thread cpu time interval timer (see ITimer_Prof::ITimer_Prof())
+            PosixTimer_Thread(const timeval &interval, const timeval &value);
+
+            //! destroy instance (see ITimer::~ITimer())
+            virtual ~PosixTimer_Thread( ) = default;
+
+            //! get the kernel thread id (gettid) of the thread
+            inline pid_t get_thread_id() const noexcept;
+    };
+
+    inline timer_t PosixTimer::get_id() const noexcept
+    {
+        return timer_id;
+    }
+
+    inline clockid_t PosixTimer::get_clock() const noexcept
+    {
+        return clock;
+    }
+
+    inline pid_t PosixTimer_Thread::get_thread_id() const noexcept
+    {
+        return thread_id;
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -0,0 +1,189 @@
+/*
+ * \file PrecisionTimer.hpp
+ * \brief Header file de::Koesling::ITimer::PrecisionTimer
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include "ITimer.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    /*! \brief class PrecisionTimer
+     *
+     * One shot timer (CLOCK_MONOTONIC) for deadlines that require an accuracy
+     * of a few microseconds. The deadline is reached by wait():
+     *
+     *      1. the thread sleeps (clock_nanosleep) until the deadline minus a
+     *         safety margin
+     *      2. the remaining time is spent in a busy loop that reads the clock
+     *         (vDSO, no system call) with a cpu pause instruction
+     *
+     * The margin calibrates itself from the measured wakeup latency of the
+     * sleep (mean + 4 * mean deviation). It is limited by the burn cap, the
+     * maximum cpu time that is spent in the busy loop per deadline.
+     *
+     * The interval of the timer is the duration of the one shot: start()
+     * arms the timer with the remaining value or, if the timer has expired,
+     * with the interval. wait() stops the timer at the deadline. Speed
+     * factors work like for any other ITimer.
+     *
+     * The timer does not generate a signal. Only one thread may wait at a
+     * time.
+     */
+    class PrecisionTimer : public ITimer
+    {
+        public:
+            //! wait statistics
+            struct Statistics
+            {
+                std::uint64_t waits;        //!< number of reached deadlines
+                std::uint64_t missed;       //!< wakeups after the deadline (sleep too long)
+                timespec spin_time;         //!< cpu time spent in the busy loop
+                timespec max_lateness;      //!< largest time between deadline and return of wait()
+            };
+
+        private:
+            //! absolute deadline in nanoseconds (CLOCK_MONOTONIC, 0: not armed)
+            std::atomic<std::int64_t> deadline;
+
+            //! armed one shot duration in nanoseconds (scaled)
+            std::atomic<std::int64_t> armed_interval;
+
+            //! maximum busy loop time per deadline in nanoseconds
+            std::atomic<std::int64_t> burn_cap;
+
+            //! estimated wakeup latency in nanoseconds (mean)
+            std::atomic<std::int64_t> latency_mean;
+
+            //! estimated wakeup latency in nanoseconds (mean deviation)
+            std::atomic<std::int64_t> latency_deviation;
+
+            //! statistics (written by the waiting thread only)
+            std::atomic<std::uint64_t> waits;
+            std::atomic<std::uint64_t> missed;
+            std::atomic<std::int64_t> spin_time;
+            std::atomic<std::int64_t> max_lateness;
+
+            //! arm/disarm the deadline
+            void settime(const itimerspec &new_value, itimerspec *old_value) override;
+
+            //! get the remaining time until the deadline
+            void gettime(itimerspec &curr_value) const override;
+
+            //! backend of the timer (checkpoints)
+            TimerBackend backend_kind() const noexcept override;
+
+            //! the value is read from the deadline (expired timers are not reloaded)
+            bool value_predictable() const noexcept override;
+
+            //! remaining time until the deadline (never negative)
+            itimerspec remaining() const noexcept;
+
+            //! update the wakeup latency estimation
+            void calibrate(std::int64_t latency) noexcept;
+
+        public:
+            /*! \brief create precision one shot timer
+             *
+             * attributes:
+             *      value    : time until the deadline (interval of the timer)
+             *      burn_cap : maximum busy loop time per deadline
+             */
+            explicit PrecisionTimer(const timespec &value, const timespec &burn_cap = {0, 200000}) noexcept;
+
+            /*! \brief create precision one shot timer
+             *
+             * see PrecisionTimer(const timespec &value, const timespec &burn_cap)
+             */
+            explicit PrecisionTimer(const timeval &value, const timespec &burn_cap = {0, 200000}) noexcept;
+
+            /*! \brief create precision one shot timer
+             *
+             * see PrecisionTimer(const timespec &value, const timespec &burn_cap)
+             */
+            template <typename Rep, typename Period>
+            explicit PrecisionTimer(const std::chrono::duration<Rep, Period> &value,
+                    const timespec &burn_cap = {0, 200000}) noexcept;
+
+            //! destroy instance (see ITimer::~ITimer())
+            virtual ~PrecisionTimer( );
+
+            //! copying is not possible
+            PrecisionTimer(const PrecisionTimer &other) = delete;
+            //! moving is not possible
+            PrecisionTimer(PrecisionTimer &&other) = delete;
+            //! copying is not possible
+            PrecisionTimer& operator=(const PrecisionTimer &other) = delete;
+            //! moving is not possible
+            PrecisionTimer& operator=(PrecisionTimer &&other) = delete;
+
+            /*! \brief wait for the deadline
+             *
+             * sleeps until the deadline minus the margin, then spins until
+             * the deadline and stops the timer.
+             * Returns false if the timer is not running or was stopped by
+             * another thread during the wait. Speed changes during the wait
+             * move the deadline.
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            bool wait();
+
+            //! set the maximum busy loop time per deadline
+            inline void set_burn_cap(const timespec &burn_cap) noexcept;
+
+            //! get the maximum busy loop time per deadline
+            inline timespec get_burn_cap() const noexcept;
+
+            //! current margin (time before the deadline at which the thread wakes up)
+            timespec get_margin() const noexcept;
+
+            //! estimated wakeup latency of the sleep
+            inline timespec get_wakeup_latency() const noexcept;
+
+            //! get wait statistics
+            Statistics get_statistics() const noexcept;
+    };
+
+    template <typename Rep, typename Period>
+    PrecisionTimer::PrecisionTimer(const std::chrono::duration<Rep, Period> &value,
+            const timespec &burn_cap) noexcept :
+            PrecisionTimer(duration_to_timespec(value), burn_cap)
+    {
+    }
+
+    inline void PrecisionTimer::set_burn_cap(const timespec &burn_cap) noexcept
+    {
+        const auto cap = to_nsec(burn_cap);
+        this->burn_cap.store(cap > 0 ? static_cast<std::int64_t>(cap) : 0, std::memory_order_relaxed);
+    }
+
+    inline timespec PrecisionTimer::get_burn_cap() const noexcept
+    {
+        return nsec_to_timespec(burn_cap.load(std::memory_order_relaxed));
+    }
+
+    inline timespec PrecisionTimer::get_wakeup_latency() const noexcept
+    {
+        return nsec_to_timespec(latency_mean.load(std::memory_order_relaxed));
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
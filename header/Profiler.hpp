@@ -0,0 +1,256 @@
+/*
+ * \file Profiler.hpp
+ * \brief Header file de::Koesling::ITimer::Profiler
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *          -pthread
+ *
+ * recommended compiler options:
+ *          -O2
+ *          -rdynamic (function names in folded output)
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include "ITimer.hpp"
+#include "LockFreeQueue.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    /*! \brief class Profiler
+     *
+     * Sampling CPU profiler based on ITimer_Prof.
+     *
+     * At each SIGPROF the signal handler captures the call stack of the
+     * interrupted thread (backtrace()) into a preallocated lock free buffer of
+     * that thread. The handler does not allocate and does not lock. A
+     * background thread drains the buffers periodically and aggregates the
+     * samples.
+     *
+     * Only threads that called register_thread() are sampled (the thread that
+     * creates the profiler is registered automatically). Samples of other
+     * threads and samples that do not fit into a full buffer are dropped
+     * (see get_dropped()).
+     *
+     * The sampling rate is the speed factor divided by the interval
+     * (e.g. 200 Hz for an interval of 10ms and a speed factor of 2.0). The
+     * kernel checks ITIMER_PROF only at scheduler ticks, therefore rates above
+     * CONFIG_HZ are not possible. The signal is generated for the process;
+     * the kernel usually delivers it to the main thread if that thread does
+     * not block SIGPROF.
+     *
+     * The profile can be written as folded stacks (flame graphs) or in the
+     * legacy CPU profile format of gperftools, which can be read by pprof.
+     *
+     * Only one instance per process is possible (ITimer_Prof).
+     */
+    class Profiler
+    {
+        public:
+            //! maximum number of stack frames per sample
+            static constexpr std::size_t MAX_FRAMES = 64;
+
+            //! stack sample (internal use only!)
+            struct Sample
+            {
+                std::size_t depth;
+                void *frames[MAX_FRAMES];
+            };
+
+        private:
+            //! sample buffer of one thread
+            typedef LockFreeQueue<Sample> ThreadBuffer;
+
+            //! sampling timer
+            ITimer_Prof timer;
+
+            //! current speed factor of the sampling timer (read by write_pprof())
+            std::atomic<double> speed_factor;
+
+            //! unique id of this profiler (thread registration)
+            std::uint64_t id;
+
+            //! capacity of each thread buffer
+            std::size_t buffer_size;
+
+            //! time between two drain operations
+            timeval drain_period;
+
+            //! protects buffers, profile and samples
+            std::mutex mutex;
+
+            //! buffers of all registered threads
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+            //! aggregated samples (key: stack, leaf first)
+            std::map<std::vector<void*>, std::uint64_t> profile;
+
+            //! number of aggregated samples
+            std::uint64_t samples;
+
+            //! number of dropped samples
+            std::atomic<std::uint64_t> dropped;
+
+            //! drain thread wakeup
+            std::condition_variable condition;
+
+            //! stop indicator for the drain thread
+            bool terminate;
+
+            //! drain thread
+            std::thread drain_thread;
+
+            //! signal action before installation of the handler
+            struct sigaction old_action;
+
+            //! active profiler (signal handler)
+            static std::atomic<Profiler*> instance;
+
+            //! id of the next profiler (ids are not reused, unlike addresses)
+            static std::atomic<std::uint64_t> next_id;
+
+            //! id of the profiler that owns the buffer of the current thread (0: none)
+            static thread_local std::uint64_t thread_owner;
+
+            //! buffer of the current thread
+            static thread_local ThreadBuffer *thread_buffer;
+
+            //! SIGPROF handler
+            static void signal_handler(int sig, siginfo_t *info, void *context);
+
+            //! drain thread
+            void drain_loop();
+
+            //! move all buffered samples to the profile (mutex must be locked)
+            void drain();
+
+        public:
+            /*! \brief create profiler
+             *
+             * The profiler is created stopped.
+             *
+             * attributes:
+             *      interval    : sampling interval (CPU time)
+             *      buffer_size : maximum number of buffered samples per thread
+             *      drain_period: time between two drain operations
+             *
+             * possible throws:
+             *      std::invalid_argument   interval, buffer_size or drain_period is zero
+             *      std::logic_error        an instance of ITimer_Prof already exists
+             *      std::system_error       a system call failed
+             */
+            explicit Profiler(const timeval &interval = {0, 10000},
+                              std::size_t buffer_size = 256,
+                              const timeval &drain_period = {0, 100000});
+
+            /*! \brief destroy profiler
+             *
+             * the sampling timer is stopped and the previous SIGPROF handler
+             * is restored
+             */
+            ~Profiler();
+
+            //! copying is not possible
+            Profiler(const Profiler &other) = delete;
+            //! moving is not possible
+            Profiler(Profiler &&other) = delete;
+            //! copying is not possible
+            Profiler& operator=(const Profiler &other) = delete;
+            //! moving is not possible
+            Profiler& operator=(Profiler &&other) = delete;
+
+            /*! \brief enable sampling of the calling thread
+             *
+             * Has no effect if the thread is already registered. The buffer
+             * of the thread is kept until the profiler is destroyed.
+             *
+             * possible throws:
+             *      std::bad_alloc  allocation failed
+             */
+            void register_thread();
+
+            /*! \brief start sampling
+             *
+             * possible throws:
+             *      std::logic_error    already started
+             *      std::system_error   a system call failed
+             */
+            void start();
+
+            /*! \brief stop sampling
+             *
+             * possible throws:
+             *      std::logic_error    not started
+             *      std::system_error   a system call failed
+             */
+            void stop();
+
+            /*! \brief set speed factor of the sampling timer
+             *
+             * see ITimer::set_speed_factor()
+             */
+            void set_speed_factor(double speed_factor);
+
+            /*! \brief set speed of the sampling timer to normal
+             *
+             * see ITimer::set_speed_to_normal()
+             */
+            void set_speed_to_normal();
+
+            //! discard all samples
+            void reset();
+
+            /*! \brief write profile as folded stacks
+             *
+             * one line per stack: "root;...;leaf count"
+             * Function names are resolved with dladdr(), unresolved frames are
+             * written as module name ("[libm.so.6]") or address.
+             */
+            void write_folded(std::ostream &stream);
+
+            /*! \brief write profile in the legacy gperftools CPU profile format
+             *
+             * The output can be read by pprof (e.g. pprof -top <binary> <file>).
+             * The stream must be opened in binary mode.
+             */
+            void write_pprof(std::ostream &stream);
+
+            //! number of aggregated samples
+            std::uint64_t get_samples();
+
+            //! number of dropped samples
+            inline std::uint64_t get_dropped() const noexcept;
+
+            //! check if sampling is active
+            inline bool is_running() const noexcept;
+    };
+
+    inline std::uint64_t Profiler::get_dropped() const noexcept
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+    inline bool Profiler::is_running() const noexcept
+    {
+        return timer.is_running();
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -0,0 +1,269 @@
+/*
+ * \file RateLimiter.hpp
+ * \brief Header file de::Koesling::ITimer::RateLimiter, TokenBucket, LeakyBucket
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include "ITimer.hpp"
+#include "LockFreeQueue.hpp"
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    /*! \brief class RateLimiter
+     *
+     * Lock free rate limiter (generic cell rate algorithm). The budget is not
+     * refilled by a tick, it is calculated from the scaled time of an ITimer
+     * (see ITimer::get_scaled_time()) at each request. Therefore:
+     *
+     *      - any number of limiters can share one timer (readers of the
+     *        timer do not block each other)
+     *      - the rate follows the speed factor of the timer: speed factor 2.0
+     *        doubles the rate. A stopped timer pauses the refill.
+     *      - a request is a single compare and swap on the state of one shard
+     *
+     * The state of a limiter can be split into shards (each on its own cache
+     * line), with rate and budget split evenly between them. A thread uses
+     * the shard of its cpu. If that shard rejects a request, the other shards
+     * are tried, so the total rate is kept. Threads on different cpus then
+     * do not share a cache line as long as their shard has budget.
+     *
+     * Base class of TokenBucket and LeakyBucket.
+     */
+    class RateLimiter
+    {
+        private:
+            //! state of one shard
+            struct Shard
+            {
+                //! theoretical arrival time (scaled time in nanoseconds)
+                std::atomic<std::int64_t> tat;
+
+                //! one shard per cache line
+                char pad[CACHE_LINE_SIZE - sizeof(std::atomic<std::int64_t>)];
+            };
+
+            //! timer that provides the scaled time
+            const ITimer &timer;
+
+            //! number of shards
+            unsigned shard_count;
+
+            //! shards
+            std::unique_ptr<Shard[]> shards;
+
+            //! rate in tokens per second (scaled time)
+            double rate;
+
+            //! scaled time in nanoseconds per token and shard
+            double emission_interval;
+
+            //! maximum distance of the theoretical arrival time from now in nanoseconds
+            std::int64_t tolerance;
+
+            //! reserve tokens in one shard
+            bool reserve_shard(Shard &shard, std::uint32_t tokens, std::int64_t now,
+                    std::int64_t &start) noexcept;
+
+        protected:
+            /*! \brief create rate limiter (internal use only!)
+             *
+             * attributes:
+             *      timer : timer that provides the scaled time
+             *      rate  : tokens per second (scaled time)
+             *      budget: tokens that may be reserved in advance (total of
+             *              all shards)
+             *      shards: number of shards (0: one per cpu)
+             *
+             * possible throws:
+             *      std::invalid_argument   invalid rate or budget
+             */
+            RateLimiter(const ITimer &timer, double rate, double budget, unsigned shards);
+
+            /*! \brief reserve tokens (internal use only!)
+             *
+             * start: scaled time at which the reservation starts (>= now)
+             * returns false if the budget of all shards is exhausted.
+             */
+            bool reserve(std::uint32_t tokens, std::int64_t now, std::int64_t &start) noexcept;
+
+        public:
+            //! destroy rate limiter
+            virtual ~RateLimiter() = default;
+
+            //! copying is not possible
+            RateLimiter(const RateLimiter &other) = delete;
+            //! moving is not possible
+            RateLimiter(RateLimiter &&other) = delete;
+            //! copying is not possible
+            RateLimiter& operator=(const RateLimiter &other) = delete;
+            //! moving is not possible
+            RateLimiter& operator=(RateLimiter &&other) = delete;
+
+            /*! \brief current scaled time of the timer
+             *
+             * can be passed to the requests of many limiters that share the
+             * timer (one clock read for all).
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            inline timespec now() const;
+
+            //! rate in tokens per second (scaled time, speed factor 1.0)
+            inline double get_rate() const noexcept;
+
+            //! number of shards
+            inline unsigned get_shards() const noexcept;
+
+            //! timer that provides the scaled time
+            inline const ITimer& get_timer() const noexcept;
+    };
+
+    /*! \brief class TokenBucket
+     *
+     * Token bucket: up to burst tokens can be taken at once, the bucket is
+     * refilled with rate tokens per second (scaled time of the timer).
+     *
+     * With multiple shards, a single request can take at most burst / shards
+     * tokens.
+     */
+    class TokenBucket : public RateLimiter
+    {
+        public:
+            /*! \brief create token bucket (initially full)
+             *
+             * attributes:
+             *      timer : timer that provides the scaled time
+             *      rate  : tokens per second (scaled time)
+             *      burst : capacity of the bucket (tokens)
+             *      shards: number of shards (0: one per cpu)
+             *
+             * possible throws:
+             *      std::invalid_argument   invalid rate or burst
+             */
+            TokenBucket(const ITimer &timer, double rate, double burst, unsigned shards = 1);
+
+            /*! \brief take tokens
+             *
+             * returns false (no tokens are taken) if not enough tokens are
+             * available.
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            inline bool try_acquire(std::uint32_t tokens = 1);
+
+            /*! \brief take tokens at scaled time now (see RateLimiter::now())
+             *
+             * returns false (no tokens are taken) if not enough tokens are
+             * available.
+             */
+            inline bool try_acquire(std::uint32_t tokens, const timespec &now) noexcept;
+    };
+
+    /*! \brief class LeakyBucket
+     *
+     * Leaky bucket (shaper): requests leave the bucket with a constant rate of
+     * rate tokens per second (scaled time of the timer). A request is accepted
+     * if it fits into the bucket (capacity tokens) and gets the delay after
+     * which it may be sent.
+     */
+    class LeakyBucket : public RateLimiter
+    {
+        public:
+            /*! \brief create leaky bucket (initially empty)
+             *
+             * attributes:
+             *      timer   : timer that provides the scaled time
+             *      rate    : tokens per second (scaled time)
+             *      capacity: maximum number of queued tokens
+             *      shards  : number of shards (0: one per cpu)
+             *
+             * possible throws:
+             *      std::invalid_argument   invalid rate or capacity
+             */
+            LeakyBucket(const ITimer &timer, double rate, double capacity, unsigned shards = 1);
+
+            /*! \brief add tokens to the bucket
+             *
+             * delay: time until the request may be sent (scaled time, divide
+             *        by the speed factor for real time)
+             * returns false if the bucket is full.
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            inline bool try_enqueue(std::uint32_t tokens, timespec &delay);
+
+            /*! \brief add tokens to the bucket at scaled time now (see RateLimiter::now())
+             *
+             * see try_enqueue(std::uint32_t tokens, timespec &delay)
+             */
+            inline bool try_enqueue(std::uint32_t tokens, timespec &delay, const timespec &now) noexcept;
+    };
+
+    inline timespec RateLimiter::now() const
+    {
+        return timer.get_scaled_time();
+    }
+
+    inline double RateLimiter::get_rate() const noexcept
+    {
+        return rate;
+    }
+
+    inline unsigned RateLimiter::get_shards() const noexcept
+    {
+        return shard_count;
+    }
+
+    inline const ITimer& RateLimiter::get_timer() const noexcept
+    {
+        return timer;
+    }
+
+    inline bool TokenBucket::try_acquire(std::uint32_t tokens)
+    {
+        return try_acquire(tokens, now());
+    }
+
+    inline bool TokenBucket::try_acquire(std::uint32_t tokens, const timespec &now) noexcept
+    {
+        std::int64_t start;
+        return reserve(tokens, static_cast<std::int64_t>(to_nsec(now)), start);
+    }
+
+    inline bool LeakyBucket::try_enqueue(std::uint32_t tokens, timespec &delay)
+    {
+        return try_enqueue(tokens, delay, now());
+    }
+
+    inline bool LeakyBucket::try_enqueue(std::uint32_t tokens, timespec &delay, const timespec &now) noexcept
+    {
+        const std::int64_t current = static_cast<std::int64_t>(to_nsec(now));
+
+        std::int64_t start;
+        if(!reserve(tokens, current, start)) return false;
+
+        delay = nsec_to_timespec(start - current);
+        return true;
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -0,0 +1,90 @@
+/*
+ * \file ScaledClock.hpp
+ * \brief Header file de::Koesling::ITimer::ScaledClock
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include "ITimer.hpp"
+#include <atomic>
+#include <chrono>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    /*! \brief class ScaledClock
+     *
+     * std::chrono compatible clock (TrivialClock) that reports the scaled time
+     * of an ITimer (see ITimer::get_scaled_time()).
+     * The epoch is the creation of the timer. The clock is not steady, as the
+     * rate changes with the speed factor of the timer.
+     *
+     * A clock is attached to one timer at a time. Use different Tag types to
+     * create independent clocks for multiple timers:
+     *
+     *      struct MyTag;
+     *      typedef ScaledClock<MyTag> MyClock;
+     *      MyClock::attach(&timer);
+     *      MyClock::time_point t = MyClock::now();
+     */
+    template <typename Tag = void>
+    class ScaledClock
+    {
+        private:
+            //! attached timer
+            static std::atomic<const ITimer*> timer;
+
+        public:
+            typedef std::chrono::nanoseconds duration;
+            typedef duration::rep rep;
+            typedef duration::period period;
+            typedef std::chrono::time_point<ScaledClock> time_point;
+
+            static constexpr bool is_steady = false;
+
+            //! attach timer (nullptr: detach)
+            inline static void attach(const ITimer *timer) noexcept;
+
+            /*! \brief get current scaled time of the attached timer
+             *
+             * returns the epoch if no timer is attached.
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            inline static time_point now();
+    };
+
+    template <typename Tag>
+    std::atomic<const ITimer*> ScaledClock<Tag>::timer(nullptr);
+
+    template <typename Tag>
+    constexpr bool ScaledClock<Tag>::is_steady;
+
+    template <typename Tag>
+    inline void ScaledClock<Tag>::attach(const ITimer *timer) noexcept
+    {
+        ScaledClock::timer.store(timer);
+    }
+
+    template <typename Tag>
+    inline typename ScaledClock<Tag>::time_point ScaledClock<Tag>::now()
+    {
+        const ITimer *attached = timer.load();
+        if(!attached) return time_point();
+
+        return time_point(attached->get_scaled_time<duration>());
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
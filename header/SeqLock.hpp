@@ -0,0 +1,167 @@
+/*
+ * \file SeqLock.hpp
+ * \brief Header file de::Koesling::ITimer::SeqLock
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    /*! \brief class SeqLock
+     *
+     * sequence lock: one writer publishes a value, any number of readers copy
+     * it without blocking the writer. A reader retries if the value was
+     * modified during the copy.
+     *
+     * The value is stored as atomic words, therefore concurrent accesses are
+     * no data race (H. Boehm, "Can seqlocks get along with programming
+     * language memory models?"). The words are written with release and read
+     * with acquire semantics instead of fences (not supported by
+     * ThreadSanitizer).
+     *
+     * store() must not be called concurrently (serialize the writers).
+     * try_load() is lock free and can be used in signal handlers, as long as
+     * the std::atomic<std::uint64_t> operations are lock free.
+     *
+     * T must be trivially copyable.
+     */
+    template <typename T>
+    class SeqLock
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+        private:
+            //! number of words of T
+            static constexpr std::size_t WORDS = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+            //! sequence number (odd: write in progress)
+            std::atomic<std::uint64_t> sequence;
+
+            //! value
+            std::atomic<std::uint64_t> data[WORDS];
+
+        public:
+            //! create sequence lock with initial value
+            explicit SeqLock(const T &value) noexcept;
+
+            //! copying is not possible
+            SeqLock(const SeqLock &other) = delete;
+            //! moving is not possible
+            SeqLock(SeqLock &&other) = delete;
+            //! copying is not possible
+            SeqLock& operator=(const SeqLock &other) = delete;
+            //! moving is not possible
+            SeqLock& operator=(SeqLock &&other) = delete;
+
+            //! publish value (single writer)
+            inline void store(const T &value) noexcept;
+
+            /*! \brief copy value (single attempt, async signal safe)
+             *
+             * returns false if a write is in progress or the value was modified
+             * during the copy (value is not modified).
+             */
+            inline bool try_load(T &value) const noexcept;
+
+            //! copy value (retries until the copy is consistent)
+            inline T load() const noexcept;
+
+            /*! \brief begin a read section
+             *
+             * waits until no write is in progress and returns the sequence
+             * number. Use with read_retry() to validate operations that depend
+             * on the published value (e.g. a system call).
+             */
+            inline std::uint64_t read_begin() const noexcept;
+
+            /*! \brief true if the value was modified since read_begin() returned sequence
+             *
+             * only the value itself (try_load()) is ordered before this check.
+             */
+            inline bool read_retry(std::uint64_t sequence) const noexcept;
+    };
+
+    template <typename T>
+    constexpr std::size_t SeqLock<T>::WORDS;
+
+    template <typename T>
+    SeqLock<T>::SeqLock(const T &value) noexcept :
+            sequence(0)
+    {
+        std::uint64_t words[WORDS] = { };
+        std::memcpy(words, &value, sizeof(T));
+        for(std::size_t i = 0; i < WORDS; ++i) data[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    template <typename T>
+    inline void SeqLock<T>::store(const T &value) noexcept
+    {
+        std::uint64_t words[WORDS] = { };
+        std::memcpy(words, &value, sizeof(T));
+
+        const std::uint64_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+
+        // a reader that sees a new word also sees the odd sequence number
+        for(std::size_t i = 0; i < WORDS; ++i) data[i].store(words[i], std::memory_order_release);
+
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    template <typename T>
+    inline bool SeqLock<T>::try_load(T &value) const noexcept
+    {
+        const std::uint64_t seq = sequence.load(std::memory_order_acquire);
+        if(seq & 1) return false;
+
+        std::uint64_t words[WORDS];
+        for(std::size_t i = 0; i < WORDS; ++i) words[i] = data[i].load(std::memory_order_acquire);
+
+        if(read_retry(seq)) return false;
+
+        std::memcpy(&value, words, sizeof(T));
+        return true;
+    }
+
+    template <typename T>
+    inline T SeqLock<T>::load() const noexcept
+    {
+        T value;
+        while(!try_load(value)) std::this_thread::yield();
+        return value;
+    }
+
+    template <typename T>
+    inline std::uint64_t SeqLock<T>::read_begin() const noexcept
+    {
+        std::uint64_t seq;
+        while((seq = sequence.load(std::memory_order_acquire)) & 1) std::this_thread::yield();
+        return seq;
+    }
+
+    template <typename T>
+    inline bool SeqLock<T>::read_retry(std::uint64_t sequence) const noexcept
+    {
+        return this->sequence.load(std::memory_order_acquire) != sequence;
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
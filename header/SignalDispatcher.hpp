@@ -0,0 +1,232 @@
+/*
+ * \file SignalDispatcher.hpp
+ * \brief Header file de::Koesling::ITimer::SignalDispatcher
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *          -pthread
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include "ITimer.hpp"
+#include "LockFreeQueue.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <semaphore.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    /*! \brief class SignalDispatcher
+     *
+     * Runs callbacks for timer expirations in worker threads instead of the
+     * signal handler.
+     *
+     * The dispatcher installs a minimal signal handler for the signals of the
+     * registered timers. The handler only pushes an expiration record into a
+     * preallocated lock free queue and wakes a worker thread (sem_post). It
+     * does not allocate, does not lock and does not access the timer. The
+     * worker threads look up the registration, record the expiration (see
+     * ITimer::record_expiration()) and call the registered callbacks.
+     *
+     * Works with every timer that generates a signal (ITimer_Real,
+     * ITimer_Virtual, ITimer_Prof and PosixTimer). Setitimer based timers are
+     * identified by their signal, POSIX timers by their sigval (see
+     * PosixTimer::from_sigval(), POSIX timers with a custom sigval are not
+     * found). Signals of timers that are not registered (e.g. other POSIX
+     * timers with the same signal) and expirations that were received before
+     * the timer was registered are discarded.
+     *
+     * Exceptions of callbacks do not leave the worker threads (they would
+     * call std::terminate). They are counted (see get_errors()), the first
+     * one is stored (see get_error()) and the worker continues.
+     *
+     * Only one instance per process is allowed. If the queue is full,
+     * expirations are dropped (see get_dropped()). With more than one worker
+     * thread, callbacks of the same timer may run concurrently.
+     */
+    class SignalDispatcher
+    {
+        public:
+            //! expiration record
+            struct Expiration
+            {
+                const ITimer *timer;        //!< expired timer
+                int signal;                 //!< received signal
+                int overrun;                //!< timer overrun count (POSIX timers only)
+                timespec time;              //!< time of signal reception (CLOCK_MONOTONIC)
+                std::uint64_t generation;   //!< registration counter at signal reception (internal use only!)
+            };
+
+            //! expiration callback
+            typedef void (*Callback)(const Expiration &expiration, void *arg);
+
+        private:
+            //! registered callback
+            struct Registration
+            {
+                Callback callback;
+                void *arg;
+                std::uint64_t generation;   //!< value of generation after the registration
+                unsigned active;            //!< number of running callbacks
+                bool removed;               //!< remove() waits for the running callbacks
+            };
+
+            //! expiration queue
+            LockFreeQueue<Expiration> queue;
+
+            //! number of dropped expirations (queue full)
+            std::atomic<std::uint64_t> dropped;
+
+            //! worker wakeup
+            sem_t semaphore;
+
+            //! stop indicator for workers
+            std::atomic<bool> terminate;
+
+            //! worker threads
+            std::vector<std::thread> workers;
+
+            //! protects registrations and handler installation
+            std::mutex mutex;
+
+            //! signaled if the last running callback of a removed timer returns
+            std::condition_variable idle;
+
+            //! registration counter (expirations from before a registration are discarded)
+            std::atomic<std::uint64_t> generation;
+
+            //! registered callbacks (key: timer)
+            std::unordered_map<const ITimer*, Registration> registrations;
+
+            //! setitimer based timer per signal (signal handler lookup)
+            std::atomic<const ITimer*> signal_timer[NSIG];
+
+            //! number of registered timers per signal
+            unsigned signal_users[NSIG];
+
+            //! signal action before installation of the handler
+            struct sigaction old_action[NSIG];
+
+            //! number of exceptions of callbacks
+            std::atomic<std::uint64_t> errors;
+
+            //! protects error
+            mutable std::mutex error_mutex;
+
+            //! first exception of a callback
+            std::exception_ptr error;
+
+            //! active dispatcher (signal handler)
+            static std::atomic<SignalDispatcher*> instance;
+
+            //! number of running signal handlers (the destructor waits for them)
+            static std::atomic<unsigned> handlers;
+
+            //! count exception and store it if it is the first one
+            void record_error(std::exception_ptr exception) noexcept;
+
+            //! signal handler
+            static void signal_handler(int sig, siginfo_t *info, void *context);
+
+            //! worker thread
+            void worker();
+
+        public:
+            /*! \brief create dispatcher
+             *
+             * attributes:
+             *      queue_capacity: maximum number of pending expirations
+             *      threads       : number of worker threads
+             *
+             * possible throws:
+             *      std::invalid_argument   queue_capacity or threads is zero
+             *      std::logic_error        an instance already exists
+             *      std::system_error       a system call failed
+             */
+            explicit SignalDispatcher(std::size_t queue_capacity = 1024, unsigned threads = 1);
+
+            /*! \brief destroy dispatcher
+             *
+             * the previous signal handlers are restored, pending expirations
+             * are discarded.
+             */
+            ~SignalDispatcher();
+
+            //! copying is not possible
+            SignalDispatcher(const SignalDispatcher &other) = delete;
+            //! moving is not possible
+            SignalDispatcher(SignalDispatcher &&other) = delete;
+            //! copying is not possible
+            SignalDispatcher& operator=(const SignalDispatcher &other) = delete;
+            //! moving is not possible
+            SignalDispatcher& operator=(SignalDispatcher &&other) = delete;
+
+            /*! \brief register timer
+             *
+             * callback is called by a worker thread at each expiration of the
+             * timer. The timer must not be destroyed before it is removed.
+             *
+             * possible throws:
+             *      std::invalid_argument   timer does not generate a signal
+             *      std::logic_error        timer is already registered or
+             *                              another timer with the same signal
+             *                              is registered (setitimer based timers)
+             *      std::system_error       a system call failed
+             */
+            void add(const ITimer &timer, Callback callback, void *arg = nullptr);
+
+            /*! \brief remove timer
+             *
+             * the signal handler is uninstalled if no other timer uses the
+             * signal. Waits until all running callbacks of the timer have
+             * returned (except for the callback that calls remove()), no
+             * callback of the timer is started afterwards. Therefore, the timer
+             * and arg can be destroyed after remove() has returned.
+             *
+             * possible throws:
+             *      std::logic_error    timer is not registered
+             */
+            void remove(const ITimer &timer);
+
+            //! number of expirations that were dropped because the queue was full
+            inline std::uint64_t get_dropped() const noexcept;
+
+            //! number of exceptions thrown by callbacks
+            inline std::uint64_t get_errors() const noexcept;
+
+            /*! \brief first exception thrown by a callback
+             *
+             * nullptr if no exception was caught. Can be rethrown with
+             * std::rethrow_exception().
+             */
+            std::exception_ptr get_error() const;
+    };
+
+    inline std::uint64_t SignalDispatcher::get_dropped() const noexcept
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+    inline std::uint64_t SignalDispatcher::get_errors() const noexcept
+    {
+        return errors.load(std::memory_order_relaxed);
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
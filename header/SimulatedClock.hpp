@@ -0,0 +1,315 @@
+/*
+ * \file SimulatedClock.hpp
+ * \brief Header file de::Koesling::ITimer::SimulatedClock and SimulatedTimer
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include "ITimer.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <limits>
+#include <mutex>
+#include <set>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    class SimulatedTimer;
+
+    /*! \brief class SimulatedClock
+     *
+     * Virtual time for SimulatedTimer instances (discrete event simulation).
+     * The time only changes if it is advanced explicitly (advance(),
+     * advance_to()) or jumps from expiration to expiration (step(), run()).
+     * No signals are generated and nothing waits for the system clock.
+     *
+     * Expired timers are processed in the order of their expiration time.
+     * Timers that expire at the same time are processed in the order in
+     * which they were armed. Therefore the order of the callbacks is
+     * deterministic. A periodic timer is re-armed before its callback is
+     * called.
+     *
+     * The callbacks are called by the thread that advances the clock, without
+     * internal lock. Callbacks may start, stop and change the speed of timers.
+     * Only one thread may advance the clock at a time. All SimulatedTimer
+     * instances must be destroyed before the clock.
+     */
+    class SimulatedClock
+    {
+        private:
+            //! scheduled expiration
+            struct Event
+            {
+                timespec expires;
+                std::uint64_t sequence;
+                SimulatedTimer *timer;
+
+                //! order of the expirations
+                bool operator<(const Event &other) const noexcept;
+            };
+
+            //! protects now, next_sequence, events and the timer events
+            mutable std::mutex mutex;
+
+            //! current simulated time
+            timespec now;
+
+            //! sequence number of the next armed timer
+            std::uint64_t next_sequence;
+
+            //! scheduled expirations
+            std::set<Event> events;
+
+            //! number of processed expirations
+            std::uint64_t expirations;
+
+            //! schedule timer (mutex must be locked)
+            void schedule(SimulatedTimer &timer, const timespec &expires);
+
+            //! remove timer from the schedule (mutex must be locked)
+            void cancel(SimulatedTimer &timer) noexcept;
+
+            /*! \brief process the next expiration not later than limit
+             *
+             * returns false if there is none.
+             */
+            bool process_next(const timespec &limit);
+
+            friend class SimulatedTimer;
+
+        public:
+            /*! \brief create simulated clock
+             *
+             * attributes:
+             *      start: initial time of the clock
+             */
+            explicit SimulatedClock(const timespec &start = {0, 0}) noexcept;
+
+            //! destroy clock
+            ~SimulatedClock() = default;
+
+            //! copying is not possible
+            SimulatedClock(const SimulatedClock &other) = delete;
+            //! moving is not possible
+            SimulatedClock(SimulatedClock &&other) = delete;
+            //! copying is not possible
+            SimulatedClock& operator=(const SimulatedClock &other) = delete;
+            //! moving is not possible
+            SimulatedClock& operator=(SimulatedClock &&other) = delete;
+
+            //! current simulated time
+            timespec get_time() const noexcept;
+
+            //! current simulated time as std::chrono::duration
+            template <typename Duration>
+            inline Duration get_time() const noexcept;
+
+            /*! \brief advance the clock
+             *
+             * processes all expirations until the current time + duration and
+             * sets the clock to this time.
+             * returns the number of processed expirations.
+             *
+             * possible throws:
+             *      std::invalid_argument   duration is negative
+             *      any exception of a callback
+             */
+            std::size_t advance(const timespec &duration);
+
+            /*! \brief advance the clock
+             *
+             * see advance(const timespec &duration)
+             */
+            template <typename Rep, typename Period>
+            inline std::size_t advance(const std::chrono::duration<Rep, Period> &duration);
+
+            /*! \brief advance the clock to time
+             *
+             * processes all expirations until time and sets the clock to time.
+             * returns the number of processed expirations.
+             *
+             * possible throws:
+             *      std::invalid_argument   time is in the past
+             *      any exception of a callback
+             */
+            std::size_t advance_to(const timespec &time);
+
+            /*! \brief jump to the next expiration and process it
+             *
+             * returns false if no timer is armed.
+             *
+             * possible throws:
+             *      any exception of a callback
+             */
+            bool step();
+
+            /*! \brief process expirations as fast as possible
+             *
+             * jumps from expiration to expiration until no timer is armed or
+             * max_expirations expirations have been processed (periodic timers
+             * never end).
+             * returns the number of processed expirations.
+             *
+             * possible throws:
+             *      any exception of a callback
+             */
+            std::size_t run(std::size_t max_expirations = std::numeric_limits<std::size_t>::max());
+
+            //! number of armed timers
+            std::size_t size() const noexcept;
+
+            /*! \brief time of the next expiration
+             *
+             * returns false if no timer is armed.
+             */
+            bool get_next_expiration(timespec &time) const noexcept;
+
+            //! number of processed expirations since the creation of the clock
+            std::uint64_t get_expirations() const noexcept;
+    };
+
+    /*! \brief class SimulatedTimer
+     *
+     * interval timer that counts down in the virtual time of a
+     * SimulatedClock. Start, stop and speed adjustment work like any other
+     * ITimer, the timer values are exact (nanoseconds).
+     *
+     * The callback is called by the thread that advances the clock at each
+     * expiration.
+     */
+    class SimulatedTimer : public ITimer
+    {
+        public:
+            //! expiration callback
+            typedef void (*Callback)(SimulatedTimer &timer, void *arg);
+
+        private:
+            //! clock of this timer
+            SimulatedClock &clock;
+
+            //! scheduled expiration (valid if armed)
+            SimulatedClock::Event event;
+
+            //! timer is scheduled
+            bool armed;
+
+            //! interval of the underlying timer (scaled)
+            timespec armed_interval;
+
+            //! expiration callback
+            Callback callback;
+
+            //! callback argument
+            void *arg;
+
+            //! arm/disarm the timer in the clock
+            void settime(const itimerspec &new_value, itimerspec *old_value) override;
+
+            //! get the remaining time until the next expiration
+            void gettime(itimerspec &curr_value) const override;
+
+            //! backend of the timer (checkpoints)
+            TimerBackend backend_kind() const noexcept override;
+
+            //! the reference clock is the simulated clock
+            bool read_reference_clock(timespec &now) const noexcept override;
+
+            //! the timer counts exactly against the simulated clock
+            bool value_predictable() const noexcept override;
+
+            //! remaining time until the next expiration (clock mutex must be locked)
+            itimerspec remaining() const noexcept;
+
+            friend class SimulatedClock;
+
+        public:
+            /*! \brief create simulated interval timer
+             *
+             * attributes:
+             *      clock   : simulated clock
+             *      interval: Interval at which the timer is triggered
+             *      callback: function that is called at each expiration
+             *                (nullptr: no callback)
+             *      arg     : argument for callback
+             */
+            SimulatedTimer(SimulatedClock &clock, const timespec &interval,
+                    Callback callback = nullptr, void *arg = nullptr) noexcept;
+
+            /*! \brief create simulated interval timer
+             *
+             * attributes:
+             *      clock   : simulated clock
+             *      interval: Interval at which the timer is triggered
+             *      value   : Time period after which the timer expires for the
+             *                first time
+             *      callback: function that is called at each expiration
+             *                (nullptr: no callback)
+             *      arg     : argument for callback
+             */
+            SimulatedTimer(SimulatedClock &clock, const timespec &interval,
+                    const timespec &value, Callback callback = nullptr,
+                    void *arg = nullptr) noexcept;
+
+            /*! \brief create simulated interval timer
+             *
+             * see SimulatedTimer(SimulatedClock &clock, const timespec &interval, Callback callback, void *arg)
+             */
+            template <typename Rep, typename Period>
+            SimulatedTimer(SimulatedClock &clock, const std::chrono::duration<Rep, Period> &interval,
+                    Callback callback = nullptr, void *arg = nullptr) noexcept;
+
+            //! destroy instance (see ITimer::~ITimer())
+            virtual ~SimulatedTimer( );
+
+            //! copying is not possible
+            SimulatedTimer(const SimulatedTimer &other) = delete;
+            //! moving is not possible
+            SimulatedTimer(SimulatedTimer &&other) = delete;
+            //! copying is not possible
+            SimulatedTimer& operator=(const SimulatedTimer &other) = delete;
+            //! moving is not possible
+            SimulatedTimer& operator=(SimulatedTimer &&other) = delete;
+
+            //! get the clock of the timer
+            inline SimulatedClock& get_clock() const noexcept;
+    };
+
+    template <typename Duration>
+    inline Duration SimulatedClock::get_time() const noexcept
+    {
+        return timespec_to_duration<Duration>(get_time());
+    }
+
+    template <typename Rep, typename Period>
+    inline std::size_t SimulatedClock::advance(const std::chrono::duration<Rep, Period> &duration)
+    {
+        return advance(duration_to_timespec(duration));
+    }
+
+    template <typename Rep, typename Period>
+    SimulatedTimer::SimulatedTimer(SimulatedClock &clock, const std::chrono::duration<Rep, Period> &interval,
+            Callback callback, void *arg) noexcept :
+            SimulatedTimer(clock, duration_to_timespec(interval), callback, arg)
+    {
+    }
+
+    inline SimulatedClock& SimulatedTimer::get_clock() const noexcept
+    {
+        return clock;
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
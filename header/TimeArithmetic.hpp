@@ -0,0 +1,368 @@
+/*
+ * \file TimeArithmetic.hpp
+ * \brief Integer arithmetic for timeval, timespec, itimerval and itimerspec
+ *
+ * All calculations are done with (up to 192 bit) integer intermediates and are
+ * exact: scaled results are truncated towards zero to the microsecond
+ * (timeval) or nanosecond (timespec). Negative values are supported, results
+ * are normalized (0 <= tv_usec < 10^6, 0 <= tv_nsec < 10^9). Results that
+ * exceed the range of time_t are saturated.
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *          GNU compatible compiler (__int128)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include <sys/time.h>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <limits>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    //! signed 128 bit integer
+    __extension__ typedef __int128 int128_t;
+
+    //! unsigned 128 bit integer
+    __extension__ typedef unsigned __int128 uint128_t;
+
+    //! nanoseconds per second
+    constexpr std::int64_t NSEC_PER_SECOND = 1000000000;
+
+    //! microseconds per second
+    constexpr std::int64_t USEC_PER_SECOND = 1000000;
+
+    //! nanoseconds per microsecond
+    constexpr std::int64_t NSEC_PER_MICROSECOND = 1000;
+
+    namespace detail {
+
+        //! integer division that rounds towards negative infinity
+        constexpr int128_t floor_div(int128_t a, int128_t b) noexcept
+        {
+            return a / b - ((a % b != 0 && ((a < 0) != (b < 0))) ? 1 : 0);
+        }
+
+        //! largest time value (in units) that can be stored
+        constexpr uint128_t max_units(std::int64_t units_per_sec) noexcept
+        {
+            return static_cast<uint128_t>(std::numeric_limits<time_t>::max()) *
+                    static_cast<uint128_t>(units_per_sec) + static_cast<uint128_t>(units_per_sec - 1);
+        }
+
+        /*! \brief double as integer: value = (-1)^negative * mantissa * 2^exponent
+         *
+         * exact representation of a (finite) double value.
+         */
+        struct Factor
+        {
+            std::uint64_t mantissa;
+            int exponent;
+            bool negative;
+            bool finite;    //!< false: inf or nan (nan: mantissa != 0)
+        };
+
+        //! decompose double (exact)
+        inline Factor decompose(double value) noexcept
+        {
+            std::uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+
+            Factor factor;
+            factor.negative = (bits >> 63) != 0;
+            const int exponent = static_cast<int>((bits >> 52) & 0x7ff);
+            const std::uint64_t fraction = bits & ((std::uint64_t(1) << 52) - 1);
+
+            if(exponent == 0x7ff)
+            {
+                factor.mantissa = fraction;
+                factor.exponent = 0;
+                factor.finite = false;
+            }
+            else if(exponent == 0)  // subnormal
+            {
+                factor.mantissa = fraction;
+                factor.exponent = -1074;
+                factor.finite = true;
+            }
+            else
+            {
+                factor.mantissa = fraction | (std::uint64_t(1) << 52);
+                factor.exponent = exponent - 1075;
+                factor.finite = true;
+            }
+
+            return factor;
+        }
+
+        //! 192 bit unsigned integer: value = hi * 2^64 + lo
+        struct Wide
+        {
+            uint128_t hi;
+            std::uint64_t lo;
+        };
+
+        //! 128 x 64 bit multiplication
+        inline Wide multiply(uint128_t value, std::uint64_t factor) noexcept
+        {
+            const uint128_t low = static_cast<uint128_t>(static_cast<std::uint64_t>(value)) * factor;
+            const uint128_t high = (value >> 64) * factor;
+
+            Wide ret_val;
+            ret_val.lo = static_cast<std::uint64_t>(low);
+            ret_val.hi = high + (low >> 64);
+            return ret_val;
+        }
+
+        //! value * 2^shift (saturated: hi = max)
+        inline Wide shift_left(uint128_t value, unsigned shift) noexcept
+        {
+            Wide ret_val;
+            if(value == 0)
+            {
+                ret_val.hi = 0;
+                ret_val.lo = 0;
+            }
+            else if(shift == 0)
+            {
+                ret_val.hi = value >> 64;
+                ret_val.lo = static_cast<std::uint64_t>(value);
+            }
+            else if(shift < 64)
+            {
+                ret_val.hi = value >> (64 - shift);
+                ret_val.lo = static_cast<std::uint64_t>(value << shift);
+            }
+            else if(shift == 64 || (shift < 192 && (value >> (192 - shift)) == 0))
+            {
+                ret_val.hi = value << (shift - 64);
+                ret_val.lo = 0;
+            }
+            else
+            {
+                ret_val.hi = ~uint128_t(0);
+                ret_val.lo = ~std::uint64_t(0);
+            }
+            return ret_val;
+        }
+
+        //! value / 2^shift (saturated if the result exceeds 128 bit)
+        inline uint128_t shift_right(const Wide &value, unsigned shift) noexcept
+        {
+            if(shift >= 192) return 0;
+            if(shift >= 64) return value.hi >> (shift - 64);
+            if(shift == 0)
+                return (value.hi >> 64) ? ~uint128_t(0) : (value.hi << 64) | value.lo;
+            if(value.hi >> (64 + shift)) return ~uint128_t(0);
+            return (value.hi << (64 - shift)) | (value.lo >> shift);
+        }
+
+        //! value / divisor (saturated if the result exceeds 128 bit)
+        inline uint128_t divide(const Wide &value, std::uint64_t divisor) noexcept
+        {
+            const uint128_t q_hi = value.hi / divisor;
+            if(q_hi >> 64) return ~uint128_t(0);
+
+            const uint128_t rest = ((value.hi % divisor) << 64) | value.lo;
+            return (q_hi << 64) + rest / divisor;
+        }
+
+        //! magnitude * factor (truncated)
+        inline uint128_t scale_mul(uint128_t magnitude, const Factor &factor) noexcept
+        {
+            if(!factor.finite) return (factor.mantissa || magnitude == 0) ? 0 : ~uint128_t(0);
+
+            if(factor.exponent >= 0)
+            {
+                const Wide product = multiply(magnitude, factor.mantissa);
+                if(product.hi >> 64) return ~uint128_t(0);
+                const Wide shifted = shift_left((product.hi << 64) | product.lo,
+                        static_cast<unsigned>(factor.exponent));
+                return shift_right(shifted, 0);
+            }
+
+            return shift_right(multiply(magnitude, factor.mantissa), static_cast<unsigned>(-factor.exponent));
+        }
+
+        //! magnitude / factor (truncated)
+        inline uint128_t scale_div(uint128_t magnitude, const Factor &factor) noexcept
+        {
+            if(!factor.finite) return 0;    // x / inf = 0, x / nan --> 0
+            if(magnitude == 0) return 0;
+            if(factor.mantissa == 0) return ~uint128_t(0);
+
+            if(factor.exponent >= 0)
+            {
+                const uint128_t quotient = magnitude / factor.mantissa;
+                return factor.exponent >= 128 ? 0 : quotient >> factor.exponent;
+            }
+
+            return divide(shift_left(magnitude, static_cast<unsigned>(-factor.exponent)), factor.mantissa);
+        }
+
+        //! signed time value (in units) * or / factor
+        inline int128_t scale(int128_t value, double right, bool division,
+                std::int64_t units_per_sec) noexcept
+        {
+            const Factor factor = decompose(right);
+            const bool negative = (value < 0) != factor.negative;
+            const uint128_t magnitude = value < 0 ? static_cast<uint128_t>(-value) : static_cast<uint128_t>(value);
+
+            uint128_t result = division ? scale_div(magnitude, factor) : scale_mul(magnitude, factor);
+
+            // saturate
+            const uint128_t max = max_units(units_per_sec);
+            if(result > max) result = negative ? max + 1 : max;
+
+            return negative ? -static_cast<int128_t>(result) : static_cast<int128_t>(result);
+        }
+
+    } /* namespace detail */
+
+    //! convert timespec to nanoseconds
+    constexpr int128_t to_nsec(const timespec &time) noexcept
+    {
+        return static_cast<int128_t>(time.tv_sec) * NSEC_PER_SECOND + time.tv_nsec;
+    }
+
+    //! convert timeval to microseconds
+    constexpr int128_t to_usec(const timeval &time) noexcept
+    {
+        return static_cast<int128_t>(time.tv_sec) * USEC_PER_SECOND + time.tv_usec;
+    }
+
+    //! convert nanoseconds to (normalized) timespec
+    constexpr timespec nsec_to_timespec(int128_t nsec) noexcept
+    {
+        return timespec{static_cast<time_t>(detail::floor_div(nsec, NSEC_PER_SECOND)),
+                        static_cast<long>(nsec - detail::floor_div(nsec, NSEC_PER_SECOND) * NSEC_PER_SECOND)};
+    }
+
+    //! convert microseconds to (normalized) timeval
+    constexpr timeval usec_to_timeval(int128_t usec) noexcept
+    {
+        return timeval{static_cast<time_t>(detail::floor_div(usec, USEC_PER_SECOND)),
+                       static_cast<suseconds_t>(usec - detail::floor_div(usec, USEC_PER_SECOND) * USEC_PER_SECOND)};
+    }
+
+    //! normalize timespec (0 <= tv_nsec < 10^9)
+    constexpr timespec timespec_normalize(const timespec &time) noexcept
+    {
+        return nsec_to_timespec(to_nsec(time));
+    }
+
+    //! normalize timeval (0 <= tv_usec < 10^6)
+    constexpr timeval timeval_normalize(const timeval &time) noexcept
+    {
+        return usec_to_timeval(to_usec(time));
+    }
+
+    //! left + right
+    constexpr timespec timespec_add(const timespec &left, const timespec &right) noexcept
+    {
+        return nsec_to_timespec(to_nsec(left) + to_nsec(right));
+    }
+
+    //! left - right
+    constexpr timespec timespec_sub(const timespec &left, const timespec &right) noexcept
+    {
+        return nsec_to_timespec(to_nsec(left) - to_nsec(right));
+    }
+
+    //! left + right
+    constexpr timeval timeval_add(const timeval &left, const timeval &right) noexcept
+    {
+        return usec_to_timeval(to_usec(left) + to_usec(right));
+    }
+
+    //! left - right
+    constexpr timeval timeval_sub(const timeval &left, const timeval &right) noexcept
+    {
+        return usec_to_timeval(to_usec(left) - to_usec(right));
+    }
+
+    //! compare timespecs (-1: left < right, 0: equal, 1: left > right)
+    constexpr int timespec_compare(const timespec &left, const timespec &right) noexcept
+    {
+        return to_nsec(left) < to_nsec(right) ? -1 : (to_nsec(left) > to_nsec(right) ? 1 : 0);
+    }
+
+    //! compare timevals (-1: left < right, 0: equal, 1: left > right)
+    constexpr int timeval_compare(const timeval &left, const timeval &right) noexcept
+    {
+        return to_usec(left) < to_usec(right) ? -1 : (to_usec(left) > to_usec(right) ? 1 : 0);
+    }
+
+    //! true if time is zero
+    constexpr bool timespec_is_zero(const timespec &time) noexcept
+    {
+        return time.tv_sec == 0 && time.tv_nsec == 0;
+    }
+
+    //! true if time is zero
+    constexpr bool timeval_is_zero(const timeval &time) noexcept
+    {
+        return time.tv_sec == 0 && time.tv_usec == 0;
+    }
+
+    //! time * factor (exact, truncated to nanoseconds)
+    inline timespec timespec_mul(const timespec &time, double factor) noexcept
+    {
+        return nsec_to_timespec(detail::scale(to_nsec(time), factor, false, NSEC_PER_SECOND));
+    }
+
+    //! time / factor (exact, truncated to nanoseconds)
+    inline timespec timespec_div(const timespec &time, double factor) noexcept
+    {
+        return nsec_to_timespec(detail::scale(to_nsec(time), factor, true, NSEC_PER_SECOND));
+    }
+
+    //! time * factor (exact, truncated to microseconds)
+    inline timeval timeval_mul(const timeval &time, double factor) noexcept
+    {
+        return usec_to_timeval(detail::scale(to_usec(time), factor, false, USEC_PER_SECOND));
+    }
+
+    //! time / factor (exact, truncated to microseconds)
+    inline timeval timeval_div(const timeval &time, double factor) noexcept
+    {
+        return usec_to_timeval(detail::scale(to_usec(time), factor, true, USEC_PER_SECOND));
+    }
+
+    //! each timespec of time * factor
+    inline itimerspec itimerspec_mul(const itimerspec &time, double factor) noexcept
+    {
+        return itimerspec{timespec_mul(time.it_interval, factor), timespec_mul(time.it_value, factor)};
+    }
+
+    //! each timespec of time / factor
+    inline itimerspec itimerspec_div(const itimerspec &time, double factor) noexcept
+    {
+        return itimerspec{timespec_div(time.it_interval, factor), timespec_div(time.it_value, factor)};
+    }
+
+    //! each timeval of time * factor
+    inline itimerval itimerval_mul(const itimerval &time, double factor) noexcept
+    {
+        return itimerval{timeval_mul(time.it_interval, factor), timeval_mul(time.it_value, factor)};
+    }
+
+    //! each timeval of time / factor
+    inline itimerval itimerval_div(const itimerval &time, double factor) noexcept
+    {
+        return itimerval{timeval_div(time.it_interval, factor), timeval_div(time.it_value, factor)};
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -0,0 +1,133 @@
+/*
+ * \file TimerFd.hpp
+ * \brief Header file de::Koesling::ITimer::TimerFd
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include "ITimer.hpp"
+#include <cstdint>
+#include <ctime>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    /*! \brief class TimerFd
+     *
+     * Interval timer based on timerfd (see man timerfd_create).
+     * No signal is generated at expiration. Instead, the file descriptor
+     * (get_fd()) becomes readable and can be used with poll/select/epoll (see
+     * TimerReactor). There is no limit on the number of instances.
+     */
+    class TimerFd : public ITimer
+    {
+        private:
+            //! clock of the timer
+            clockid_t clock;
+
+            //! timer file descriptor
+            int fd;
+
+            //! arm/disarm the timer (timerfd_settime)
+            void settime(const itimerspec &new_value, itimerspec *old_value) override;
+
+            //! get the timer (timerfd_gettime)
+            void gettime(itimerspec &curr_value) const override;
+
+            //! backend of the timer (checkpoints)
+            TimerBackend backend_kind() const noexcept override;
+
+            //! clock of the timer
+            clockid_t reference_clock() const noexcept override;
+
+            //! create the timer file descriptor
+            void create();
+
+        public:
+            /*! \brief create timerfd interval timer
+             *
+             * attributes:
+             *      interval: Interval at which the timer is triggered
+             *      clock   : CLOCK_MONOTONIC, CLOCK_REALTIME or CLOCK_BOOTTIME
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            explicit TimerFd(const timespec &interval, clockid_t clock = CLOCK_MONOTONIC);
+
+            /*! \brief create timerfd interval timer
+             *
+             * attributes:
+             *      interval: Interval at which the timer is triggered
+             *      value   : Time period after which the timer expires for the
+             *                first time
+             *      clock   : CLOCK_MONOTONIC, CLOCK_REALTIME or CLOCK_BOOTTIME
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            TimerFd(const timespec &interval, const timespec &value,
+                    clockid_t clock = CLOCK_MONOTONIC);
+
+            //! create timerfd interval timer (see TimerFd::TimerFd())
+            explicit TimerFd(const timeval &interval, clockid_t clock = CLOCK_MONOTONIC);
+
+            //! create timerfd interval timer (see TimerFd::TimerFd())
+            TimerFd(const timeval &interval, const timeval &value,
+                    clockid_t clock = CLOCK_MONOTONIC);
+
+            /*! \brief destroy instance (see ITimer::~ITimer())
+             *
+             * a TimerReactor is not notified: remove the timer from the
+             * reactor first (see TimerReactor::remove()).
+             */
+            virtual ~TimerFd( );
+
+            //! copying is not possible
+            TimerFd(const TimerFd &other) = delete;
+            //! moving is not possible
+            TimerFd(TimerFd &&other) = delete;
+            //! copying is not possible
+            TimerFd& operator=(const TimerFd &other) = delete;
+            //! moving is not possible
+            TimerFd& operator=(TimerFd &&other) = delete;
+
+            /*! \brief read the number of expirations
+             *
+             * returns the number of expirations since the last call (0 if the
+             * timer has not expired). Does not block.
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            std::uint64_t read_expirations();
+
+            //! get the pollable file descriptor
+            inline int get_fd() const noexcept;
+
+            //! get the clock of the timer
+            inline clockid_t get_clock() const noexcept;
+    };
+
+    inline int TimerFd::get_fd() const noexcept
+    {
+        return fd;
+    }
+
+    inline clockid_t TimerFd::get_clock() const noexcept
+    {
+        return clock;
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
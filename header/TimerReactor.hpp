@@ -0,0 +1,167 @@
+/*
+ * \file TimerReactor.hpp
+ * \brief Header file de::Koesling::ITimer::TimerReactor
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include "TimerFd.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <sys/epoll.h>
+#include <unordered_map>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    /*! \brief class TimerReactor
+     *
+     * epoll based event loop for TimerFd timers and arbitrary file
+     * descriptors. All registered timers and file descriptors are waited for
+     * with one epoll_wait call.
+     *
+     * The reactor is not thread safe. Callbacks may add and remove timers and
+     * file descriptors.
+     *
+     * Registered timers and file descriptors must be removed before they are
+     * destroyed or closed. The reactor does not notice a destroyed TimerFd
+     * (its callback would be called with a dangling timer) and a new file
+     * descriptor with the same number would be mistaken for the old one.
+     */
+    class TimerReactor
+    {
+        public:
+            /*! \brief timer callback
+             *
+             * expirations: number of expirations since the last call
+             */
+            typedef void (*TimerCallback)(TimerFd &timer, std::uint64_t expirations, void *arg);
+
+            /*! \brief file descriptor callback
+             *
+             * events: epoll events (EPOLLIN, EPOLLOUT, ...)
+             */
+            typedef void (*FdCallback)(int fd, std::uint32_t events, void *arg);
+
+            //! maximum number of events that are handled by one wait() call
+            static constexpr int MAX_EVENTS = 64;
+
+        private:
+            //! registration of a timer or file descriptor
+            struct Registration
+            {
+                TimerFd *timer;             //!< nullptr --> user fd
+                TimerCallback timer_callback;
+                FdCallback fd_callback;
+                void *arg;
+            };
+
+            //! epoll file descriptor
+            int epoll_fd;
+
+            //! registrations (key: file descriptor)
+            std::unordered_map<int, Registration> registrations;
+
+            //! event buffer
+            epoll_event events[MAX_EVENTS];
+
+            //! register file descriptor
+            void add(int fd, std::uint32_t events, const Registration &registration);
+
+        public:
+            /*! \brief create reactor
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            TimerReactor();
+
+            //! destroy reactor (registered timers and fds are not closed)
+            ~TimerReactor();
+
+            //! copying is not possible
+            TimerReactor(const TimerReactor &other) = delete;
+            //! moving is not possible
+            TimerReactor(TimerReactor &&other) = delete;
+            //! copying is not possible
+            TimerReactor& operator=(const TimerReactor &other) = delete;
+            //! moving is not possible
+            TimerReactor& operator=(TimerReactor &&other) = delete;
+
+            /*! \brief add timer
+             *
+             * callback is called by wait() when the timer has expired.
+             *
+             * possible throws:
+             *      std::logic_error    timer is already registered
+             *      std::system_error   a system call failed
+             */
+            void add(TimerFd &timer, TimerCallback callback, void *arg = nullptr);
+
+            /*! \brief add file descriptor
+             *
+             * callback is called by wait() when one of the requested events
+             * occurred.
+             *
+             * possible throws:
+             *      std::logic_error    fd is already registered
+             *      std::system_error   a system call failed
+             */
+            void add(int fd, std::uint32_t events, FdCallback callback, void *arg = nullptr);
+
+            /*! \brief remove timer
+             *
+             * must be called before the timer is destroyed. The timer stays
+             * registered if a system call fails.
+             *
+             * possible throws:
+             *      std::logic_error    timer is not registered
+             *      std::system_error   a system call failed
+             */
+            void remove(TimerFd &timer);
+
+            /*! \brief remove file descriptor
+             *
+             * must be called before the fd is closed. The fd stays
+             * registered if a system call fails.
+             *
+             * possible throws:
+             *      std::logic_error    fd is not registered
+             *      std::system_error   a system call failed
+             */
+            void remove(int fd);
+
+            /*! \brief wait for events and call the callbacks
+             *
+             * attributes:
+             *      timeout: maximum time to wait in milliseconds (-1: infinite)
+             *
+             * returns the number of handled events (0 on timeout or if
+             * interrupted by a signal)
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            std::size_t wait(int timeout = -1);
+
+            //! number of registered timers and file descriptors
+            inline std::size_t size() const noexcept;
+    };
+
+    inline std::size_t TimerReactor::size() const noexcept
+    {
+        return registrations.size();
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
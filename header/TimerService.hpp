@@ -0,0 +1,295 @@
+/*
+ * \file TimerService.hpp
+ * \brief Header file de::Koesling::ITimer::TimerService
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *          -pthread
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include "ITimer.hpp"
+#include "SignalDispatcher.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <exception>
+#include <initializer_list>
+#include <mutex>
+#include <pthread.h>
+#include <sys/types.h>
+#include <thread>
+#include <unordered_map>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    /*! \brief class TimerService
+     *
+     * Consumes the timer signals in one dedicated thread, so that they do not
+     * interrupt other threads (EINTR, cache pollution).
+     *
+     * The service blocks its signals (default: SIGALRM, SIGVTALRM, SIGPROF)
+     * in the thread that creates it. Threads that are created afterwards
+     * inherit the signal mask. Therefore the service has to be created
+     * before the other threads of the process are started (e.g. at the
+     * beginning of main()); threads that already exist have to block the
+     * signals themselves (see block_signals()).
+     *
+     * The service thread waits for the blocked signals with sigwaitinfo()
+     * and calls the callback of the expired timer. It can be pinned to a cpu
+     * and run with SCHED_FIFO priority. The service either spawns the thread
+     * or adopts a thread of the application (see run()).
+     *
+     * Works with ITimer_Real, ITimer_Virtual and ITimer_Prof (identified by
+     * their signal) and PosixTimer (identified by their sigval, e.g. on
+     * a realtime signal). The callbacks are compatible with SignalDispatcher.
+     * A signal that reaches a thread that does not block it calls an empty
+     * handler (the expiration is lost, the process is not terminated).
+     *
+     * Exceptions in a spawned service thread do not leave the thread (they
+     * would call std::terminate). They are counted (see get_errors()) and the
+     * first one is stored (see get_error()): an exception of a callback is
+     * recorded and the service continues, any other exception (e.g. a failed
+     * system call) ends the service thread. In an adopted thread, all
+     * exceptions are thrown by run().
+     *
+     * Only one instance per process is allowed. Must not be combined with a
+     * SignalDispatcher for the same signals.
+     */
+    class TimerService
+    {
+        public:
+            //! expiration record
+            typedef SignalDispatcher::Expiration Expiration;
+
+            //! expiration callback
+            typedef SignalDispatcher::Callback Callback;
+
+            //! thread settings
+            struct Config
+            {
+                int cpu;            //!< cpu of the service thread (-1: not pinned)
+                int priority;       //!< SCHED_FIFO priority (0: default scheduling)
+            };
+
+        private:
+            //! registered callback
+            struct Registration
+            {
+                Callback callback;
+                void *arg;
+            };
+
+            //! thread settings
+            Config config;
+
+            //! signals of the service
+            sigset_t signals;
+
+            //! signal actions before the creation of the service
+            struct sigaction old_action[NSIG];
+
+            //! protects registrations and signal_timer
+            std::mutex mutex;
+
+            //! registered callbacks (key: timer)
+            std::unordered_map<const ITimer*, Registration> registrations;
+
+            //! setitimer based timer per signal
+            const ITimer *signal_timer[NSIG];
+
+            //! timer whose callback is running (protected by mutex)
+            const ITimer *dispatching;
+
+            //! signaled if a callback has returned (remove() waits for it)
+            std::condition_variable idle;
+
+            //! spawned service thread
+            std::thread thread;
+
+            //! thread that runs the service
+            std::atomic<pthread_t> service_thread;
+
+            //! kernel thread id of the service thread (0: not running)
+            std::atomic<pid_t> thread_id;
+
+            //! stop indicator
+            std::atomic<bool> terminate;
+
+            //! number of processed expirations
+            std::atomic<std::uint64_t> expirations;
+
+            //! the service runs in a spawned thread (exceptions are recorded)
+            const bool spawned;
+
+            //! number of exceptions caught in the spawned service thread
+            std::atomic<std::uint64_t> errors;
+
+            //! protects error
+            mutable std::mutex error_mutex;
+
+            //! first exception caught in the spawned service thread
+            std::exception_ptr error;
+
+            //! active service
+            static std::atomic<TimerService*> instance;
+
+            //! empty handler for signals that reach another thread
+            static void stray_handler(int sig);
+
+            //! apply cpu and priority to the service thread
+            void configure_thread();
+
+            //! send a service signal to the service thread (returns pthread_kill error)
+            int wake() noexcept;
+
+            //! spawned service thread (catches all exceptions)
+            void spawned_thread();
+
+            //! sigwaitinfo loop
+            void service_loop();
+
+            //! count exception and store it if it is the first one
+            void record_error(std::exception_ptr exception) noexcept;
+
+            //! call the callback of an expired timer
+            void dispatch(const siginfo_t &info);
+
+        public:
+            /*! \brief create timer service
+             *
+             * attributes:
+             *      config : cpu and priority of the service thread
+             *      spawn  : true : start a service thread
+             *               false: the service runs in the thread that calls
+             *                      run() (adopted thread)
+             *      signals: signals of the service
+             *
+             * possible throws:
+             *      std::invalid_argument   signal is invalid
+             *      std::logic_error        an instance already exists
+             *      std::system_error       a system call failed (e.g. EPERM
+             *                              for SCHED_FIFO, EINVAL for cpu)
+             */
+            explicit TimerService(const Config &config = {-1, 0}, bool spawn = true,
+                    std::initializer_list<int> signals = {SIGALRM, SIGVTALRM, SIGPROF});
+
+            /*! \brief destroy service
+             *
+             * the service thread is stopped (an adopted thread returns from
+             * run()), the previous signal actions are restored. The signals
+             * stay blocked.
+             */
+            ~TimerService();
+
+            //! copying is not possible
+            TimerService(const TimerService &other) = delete;
+            //! moving is not possible
+            TimerService(TimerService &&other) = delete;
+            //! copying is not possible
+            TimerService& operator=(const TimerService &other) = delete;
+            //! moving is not possible
+            TimerService& operator=(TimerService &&other) = delete;
+
+            /*! \brief register timer
+             *
+             * callback is called by the service thread at each expiration of
+             * the timer. The timer must not be destroyed before it is removed.
+             *
+             * possible throws:
+             *      std::invalid_argument   the signal of the timer is not a
+             *                              signal of the service
+             *      std::logic_error        timer is already registered or
+             *                              another timer with the same signal
+             *                              is registered (setitimer based timers)
+             */
+            void add(const ITimer &timer, Callback callback, void *arg = nullptr);
+
+            /*! \brief remove timer
+             *
+             * waits until a running callback of the timer has returned
+             * (unless called in the service thread, e.g. by a callback), no
+             * callback of the timer is started afterwards. Therefore, the
+             * timer and arg can be destroyed after remove() has returned.
+             *
+             * possible throws:
+             *      std::logic_error    timer is not registered
+             */
+            void remove(const ITimer &timer);
+
+            /*! \brief run the service in the calling thread (adopted thread)
+             *
+             * applies cpu and priority to the calling thread and processes
+             * expirations until the service is destroyed or stop() is called.
+             *
+             * possible throws:
+             *      std::logic_error    the service has spawned a thread or
+             *                          is already running
+             *      std::system_error   a system call failed
+             *      any exception of a callback
+             */
+            void run();
+
+            /*! \brief stop an adopted thread (run() returns)
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            void stop();
+
+            /*! \brief block the signals of the service in the calling thread
+             *
+             * for threads that were created before the service.
+             *
+             * possible throws:
+             *      std::system_error   a system call failed
+             */
+            void block_signals() const;
+
+            /*! \brief kernel thread id of the service thread
+             *
+             * 0 if the service is not running. Can be used for thread
+             * directed POSIX timers (SIGEV_THREAD_ID).
+             */
+            inline pid_t get_thread_id() const noexcept;
+
+            //! number of processed expirations
+            inline std::uint64_t get_expirations() const noexcept;
+
+            //! number of exceptions caught in the spawned service thread (including callbacks)
+            inline std::uint64_t get_errors() const noexcept;
+
+            /*! \brief first exception caught in the spawned service thread
+             *
+             * nullptr if no exception was caught. Can be rethrown with
+             * std::rethrow_exception().
+             */
+            std::exception_ptr get_error() const;
+    };
+
+    inline pid_t TimerService::get_thread_id() const noexcept
+    {
+        return thread_id.load();
+    }
+
+    inline std::uint64_t TimerService::get_expirations() const noexcept
+    {
+        return expirations.load(std::memory_order_relaxed);
+    }
+
+    inline std::uint64_t TimerService::get_errors() const noexcept
+    {
+        return errors.load(std::memory_order_relaxed);
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
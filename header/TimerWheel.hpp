@@ -0,0 +1,304 @@
+/*
+ * \file TimerWheel.hpp
+ * \brief Header file de::Koesling::ITimer::TimerWheel
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+#pragma once
+
+#include "ITimer.hpp"
+#include <atomic>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+    class WheelTimer;
+
+    /*! \brief class TimerWheel
+     *
+     * Hierarchical timing wheel that multiplexes any number of logical timers
+     * (WheelTimer) over the single ITimer_Real of the process.
+     *
+     * The wheel consists of LEVELS levels with SLOTS slots each. Level 0 has
+     * the resolution of one tick, every further level covers SLOTS times the
+     * range of the level below. Insert, cancel and expire are O(1).
+     *
+     * The wheel installs a SIGALRM handler that only counts the pending ticks.
+     * The expired timers are processed (and their callbacks are called) by
+     * process(), which has to be called by the user (e.g. in the main loop).
+     *
+     * The wheel and its timers are not thread safe. All WheelTimer instances
+     * must be destroyed before the wheel.
+     */
+    class TimerWheel
+    {
+        public:
+            //! number of bits per level
+            static constexpr unsigned SLOT_BITS = 8;
+
+            //! number of slots per level
+            static constexpr unsigned SLOTS = 1u << SLOT_BITS;
+
+            //! number of levels (range: 2^(SLOT_BITS * LEVELS) ticks)
+            static constexpr unsigned LEVELS = 4;
+
+            //! intrusive list node (internal use only!)
+            struct Node
+            {
+                Node *prev;
+                Node *next;
+                WheelTimer *owner;
+            };
+
+        private:
+            //! underlying tick timer
+            ITimer_Real tick_timer;
+
+            //! length of one tick
+            timeval resolution;
+
+            //! next tick to process
+            std::uint64_t next_tick;
+
+            //! ticks received by the signal handler but not processed yet
+            std::atomic<unsigned long> pending_ticks;
+
+            //! slot list heads
+            Node slots[LEVELS][SLOTS];
+
+            //! number of armed timers
+            std::size_t armed;
+
+            //! signal action that was active before the wheel was created
+            struct sigaction old_action;
+
+            //! instance for signal handler
+            static std::atomic<TimerWheel*> instance;
+
+            //! SIGALRM handler
+            static void signal_handler(int sig);
+
+            //! insert node into the wheel (node->owner->expires must be set)
+            void insert(Node *node) noexcept;
+
+            //! move all timers of a slot to the lower levels
+            unsigned cascade(unsigned level, unsigned index) noexcept;
+
+            //! process one tick
+            std::size_t run_tick();
+
+            friend class WheelTimer;
+
+        public:
+            /*! \brief create timer wheel
+             *
+             * attributes:
+             *      resolution: length of one tick
+             *
+             * possible throws:
+             *      std::invalid_argument   resolution is zero
+             *      std::logic_error        an instance of ITimer_Real already exists
+             *      std::system_error       a system call failed
+             */
+            explicit TimerWheel(const timeval &resolution);
+
+            /*! \brief destroy timer wheel
+             *
+             * the tick timer is stopped and the previous SIGALRM handler is
+             * restored
+             */
+            ~TimerWheel();
+
+            //! copying is not possible
+            TimerWheel(const TimerWheel &other) = delete;
+            //! moving is not possible
+            TimerWheel(TimerWheel &&other) = delete;
+            //! copying is not possible
+            TimerWheel& operator=(const TimerWheel &other) = delete;
+            //! moving is not possible
+            TimerWheel& operator=(TimerWheel &&other) = delete;
+
+            /*! \brief start the tick timer
+             *
+             * possible throws:
+             *      std::logic_error    tick timer is already started
+             *      std::system_error   a system call failed
+             */
+            inline void start();
+
+            /*! \brief stop the tick timer
+             *
+             * possible throws:
+             *      std::runtime_error  tick timer is already stopped
+             *      std::system_error   a system call failed
+             */
+            inline void stop();
+
+            //! get tick timer state
+            inline bool is_running() const noexcept;
+
+            /*! \brief count one tick
+             *
+             * async signal safe. Called by the internal SIGALRM handler, may be
+             * called manually to advance the wheel without the tick timer.
+             */
+            inline void tick() noexcept;
+
+            /*! \brief process all pending ticks
+             *
+             * calls the callbacks of all expired timers.
+             * returns the number of expired timers.
+             */
+            std::size_t process();
+
+            //! number of ticks that have been processed
+            inline std::uint64_t get_ticks() const noexcept;
+
+            //! length of one tick
+            inline timeval get_resolution() const noexcept;
+
+            //! number of armed (running) timers
+            inline std::size_t size() const noexcept;
+    };
+
+    /*! \brief class WheelTimer
+     *
+     * logical interval timer of a TimerWheel.
+     * Start, stop and speed adjustment work like any other ITimer.
+     * Timer values are rounded up to multiples of the wheel resolution.
+     *
+     * The callback is called by TimerWheel::process() at each expiration.
+     */
+    class WheelTimer : public ITimer
+    {
+        public:
+            //! expiration callback
+            typedef void (*Callback)(WheelTimer &timer, void *arg);
+
+        private:
+            //! wheel of this timer
+            TimerWheel &wheel;
+
+            //! wheel list node
+            TimerWheel::Node node;
+
+            //! tick of next expiration
+            std::uint64_t expires;
+
+            //! interval in ticks (0 --> one shot)
+            std::uint64_t interval_ticks;
+
+            //! expiration callback
+            Callback callback;
+
+            //! callback argument
+            void *arg;
+
+            //! arm/disarm the timer in the wheel
+            void settime(const itimerspec &new_value, itimerspec *old_value) override;
+
+            //! get the remaining time until the next expiration
+            void gettime(itimerspec &curr_value) const override;
+
+            //! backend of the timer (checkpoints)
+            TimerBackend backend_kind() const noexcept override;
+
+            //! the timer expires at ticks, not at the reference clock
+            bool value_predictable() const noexcept override;
+
+            //! remove timer from wheel
+            void unlink() noexcept;
+
+            //! remaining timer value
+            timespec remaining() const noexcept;
+
+            friend class TimerWheel;
+
+        public:
+            /*! \brief create logical interval timer
+             *
+             * attributes:
+             *      wheel   : timer wheel
+             *      interval: Interval at which the timer is triggered
+             *      callback: function that is called at each expiration
+             *      arg     : argument for callback
+             */
+            WheelTimer(TimerWheel &wheel, const timeval &interval,
+                    Callback callback, void *arg = nullptr) noexcept;
+
+            /*! \brief create logical interval timer
+             *
+             * attributes:
+             *      wheel   : timer wheel
+             *      interval: Interval at which the timer is triggered
+             *      value   : Time period after which the timer expires for the
+             *                first time
+             *      callback: function that is called at each expiration
+             *      arg     : argument for callback
+             */
+            WheelTimer(TimerWheel &wheel, const timeval &interval,
+                    const timeval &value, Callback callback,
+                    void *arg = nullptr) noexcept;
+
+            //! destroy instance (see ITimer::~ITimer())
+            virtual ~WheelTimer( );
+
+            //! copying is not possible
+            WheelTimer(const WheelTimer &other) = delete;
+            //! moving is not possible
+            WheelTimer(WheelTimer &&other) = delete;
+            //! copying is not possible
+            WheelTimer& operator=(const WheelTimer &other) = delete;
+            //! moving is not possible
+            WheelTimer& operator=(WheelTimer &&other) = delete;
+    };
+
+    inline void TimerWheel::start()
+    {
+        tick_timer.start();
+    }
+
+    inline void TimerWheel::stop()
+    {
+        tick_timer.stop();
+    }
+
+    inline bool TimerWheel::is_running() const noexcept
+    {
+        return tick_timer.is_running();
+    }
+
+    inline void TimerWheel::tick() noexcept
+    {
+        pending_ticks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline std::uint64_t TimerWheel::get_ticks() const noexcept
+    {
+        return next_tick;
+    }
+
+    inline timeval TimerWheel::get_resolution() const noexcept
+    {
+        return resolution;
+    }
+
+    inline std::size_t TimerWheel::size() const noexcept
+    {
+        return armed;
+    }
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -0,0 +1,159 @@
+/*
+ * \file CheckpointFile.cpp
+ * \brief Source file de::Koesling::ITimer::CheckpointFile
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "CheckpointFile.hpp"
+#include "sysexcept.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//! write the whole buffer (returns errno, 0: success)
+static int write_all(int fd, const void *data, std::size_t size) noexcept
+{
+    const char *position = static_cast<const char*>(data);
+    while(size)
+    {
+        const ssize_t written = write(fd, position, size);
+        if(written < 0)
+        {
+            if(errno == EINTR) continue;
+            return errno;
+        }
+
+        position += written;
+        size -= static_cast<std::size_t>(written);
+    }
+
+    return 0;
+}
+
+//! write the directory entries of the directory that contains path to the disk
+static void sync_directory(const std::string &path)
+{
+    const std::string::size_type separator = path.rfind('/');
+    const std::string directory = separator == std::string::npos ? "." :
+                                  (separator == 0 ? "/" : path.substr(0, separator));
+
+    int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    sysexcept(fd < 0, "open", errno);
+
+    int error = fsync(fd) < 0 ? errno : 0;
+    close(fd);
+    sysexcept(error != 0, "fsync", error);
+}
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+CheckpointFile::CheckpointFile(const std::string &path, std::size_t size) :
+        path(path),
+        memory(nullptr),
+        length(size),
+        writable(true)
+{
+    if(size == 0)
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": size must not be zero!");
+
+    // the file is only replaced by sync() --> the previous checkpoint stays valid until then
+    memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    sysexcept(memory == MAP_FAILED, "mmap", errno);
+}
+
+CheckpointFile::CheckpointFile(const std::string &path) :
+        path(path),
+        memory(nullptr),
+        length(0),
+        writable(false)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    sysexcept(fd < 0, "open", errno);
+
+    struct stat status;
+    if(fstat(fd, &status) < 0)
+    {
+        int error = errno;
+        close(fd);
+        sysexcept(true, "fstat", error);
+    }
+
+    if(status.st_size <= 0)
+    {
+        close(fd);
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": file is empty");
+    }
+    length = static_cast<std::size_t>(status.st_size);
+
+    memory = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    int error = errno;
+    close(fd);
+    sysexcept(memory == MAP_FAILED, "mmap", error);
+}
+
+CheckpointFile::~CheckpointFile()
+{
+    munmap(memory, length);
+}
+
+void* CheckpointFile::writable_data()
+{
+    if(!writable)
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": file is mapped read only");
+    return memory;
+}
+
+void CheckpointFile::sync()
+{
+    if(!writable) return;
+
+    // write a temporary file and replace the checkpoint atomically
+    const std::string temporary = path + ".tmp";
+
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    sysexcept(fd < 0, "open", errno);
+
+    int error = write_all(fd, memory, length);
+    const char *call = "write";
+    if(!error && fsync(fd) < 0)
+    {
+        error = errno;
+        call = "fsync";
+    }
+    if(close(fd) < 0 && !error)
+    {
+        error = errno;
+        call = "close";
+    }
+    if(!error && rename(temporary.c_str(), path.c_str()) < 0)
+    {
+        error = errno;
+        call = "rename";
+    }
+
+    if(error)
+    {
+        unlink(temporary.c_str());
+        sysexcept(true, call, error);
+    }
+
+    sync_directory(path);
+}
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -0,0 +1,307 @@
+/*
+ * \file CoalescingGroup.cpp
+ * \brief Source file de::Koesling::ITimer::CoalescingGroup
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "CoalescingGroup.hpp"
+#include "sysexcept.hpp"
+#include <cerrno>
+#include <sys/prctl.h>
+
+//! current time of CLOCK_MONOTONIC in nanoseconds
+static std::int64_t monotonic_now()
+{
+    timespec now;
+    sysexcept(clock_gettime(CLOCK_MONOTONIC, &now) < 0, "clock_gettime", errno);
+    return static_cast<std::int64_t>(de::Koesling::ITimer::to_nsec(now));
+}
+
+//! timer slack that wait() has set for this thread (0: unknown)
+static thread_local std::int64_t thread_slack = 0;
+
+//! initialize list head
+static void list_init(de::Koesling::ITimer::CoalescingGroup::Node *head) noexcept
+{
+    head->prev = head;
+    head->next = head;
+    head->owner = nullptr;
+}
+
+//! append node to list
+static void list_append(de::Koesling::ITimer::CoalescingGroup::Node *head,
+        de::Koesling::ITimer::CoalescingGroup::Node *node) noexcept
+{
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+//! remove node from its list
+static void list_remove(de::Koesling::ITimer::CoalescingGroup::Node *node) noexcept
+{
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = nullptr;
+    node->next = nullptr;
+}
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+CoalescingGroup::CoalescingGroup(bool kernel_slack) noexcept :
+        armed(0),
+        kernel_slack(kernel_slack),
+        statistics{0, 0, 0, 0}
+{
+    list_init(&armed_list);
+}
+
+bool CoalescingGroup::window(std::int64_t &earliest, std::int64_t &latest) const noexcept
+{
+    if(armed_list.next == &armed_list) return false;
+
+    // the window of the group ends with the first window of a timer
+    latest = INT64_MAX;
+    for(const Node *node = armed_list.next; node != &armed_list; node = node->next)
+    {
+        const CoalescedTimer *timer = node->owner;
+        if(timer->expires + timer->slack < latest) latest = timer->expires + timer->slack;
+    }
+
+    // ... and starts when the last timer that has to fire before its end is due
+    earliest = INT64_MIN;
+    for(const Node *node = armed_list.next; node != &armed_list; node = node->next)
+    {
+        const std::int64_t expires = node->owner->expires;
+        if(expires <= latest && expires > earliest) earliest = expires;
+    }
+
+    return true;
+}
+
+bool CoalescingGroup::get_next_wakeup(timespec &earliest, timespec &latest) const noexcept
+{
+    std::int64_t window_start, window_end;
+    if(!window(window_start, window_end)) return false;
+
+    earliest = nsec_to_timespec(window_start);
+    latest = nsec_to_timespec(window_end);
+    return true;
+}
+
+std::size_t CoalescingGroup::fire(std::int64_t now)
+{
+    // due timers are moved to a local list --> callbacks may start/stop any timer
+    Node work;
+    list_init(&work);
+
+    for(Node *node = armed_list.next; node != &armed_list;)
+    {
+        Node *next = node->next;
+        if(node->owner->expires <= now)
+        {
+            list_remove(node);
+            list_append(&work, node);
+        }
+        node = next;
+    }
+
+    std::size_t count = 0;
+    const auto account = [this, &count]
+    {
+        if(!count) return;
+        ++statistics.wakeups;
+        statistics.expirations += count;
+        statistics.saved_wakeups += count - 1;
+    };
+
+    try
+    {
+        while(work.next != &work)
+        {
+            Node *node = work.next;
+            list_remove(node);
+
+            CoalescedTimer *timer = node->owner;
+            if(timer->interval > 0)
+            {
+                // skip the periods that have passed completely
+                const std::int64_t periods = 1 + (now - timer->expires) / timer->interval;
+                statistics.overruns += static_cast<std::uint64_t>(periods - 1);
+                timer->expires += periods * timer->interval;
+                list_append(&armed_list, node);
+            }
+            else
+            {
+                --armed;
+            }
+
+            ++count;
+            timer->record_expiration();
+            timer->callback(*timer, timer->arg);
+        }
+    }
+    catch(...)
+    {
+        // work is a local list: the timers that were not fired stay due (next call)
+        while(work.next != &work)
+        {
+            Node *node = work.next;
+            list_remove(node);
+            list_append(&armed_list, node);
+        }
+
+        account();
+        throw;
+    }
+
+    account();
+    return count;
+}
+
+bool CoalescingGroup::wait()
+{
+    for(;;)
+    {
+        std::int64_t earliest, latest;
+        if(!window(earliest, latest)) return false;
+
+        const std::int64_t now = monotonic_now();
+        if(now >= earliest)
+        {
+            fire(now);
+            return true;
+        }
+
+        // the kernel may delay the wakeup until the end of the window
+        if(kernel_slack)
+        {
+            const std::int64_t slack = latest > earliest ? latest - earliest : 1;
+            if(slack != thread_slack)
+            {
+                sysexcept(prctl(PR_SET_TIMERSLACK, static_cast<unsigned long>(slack), 0, 0, 0) < 0,
+                        "prctl", errno);
+                thread_slack = slack;
+            }
+        }
+
+        const timespec target = nsec_to_timespec(earliest);
+        const int error = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &target, nullptr);
+        sysexcept(error != 0 && error != EINTR, "clock_nanosleep", error);
+    }
+}
+
+std::size_t CoalescingGroup::process()
+{
+    return fire(monotonic_now());
+}
+
+void CoalescingGroup::set_thread_slack(const timespec &slack)
+{
+    const auto nsec = to_nsec(slack);
+    const std::int64_t value = nsec > 0 ? static_cast<std::int64_t>(nsec) : 1;
+
+    sysexcept(prctl(PR_SET_TIMERSLACK, static_cast<unsigned long>(value), 0, 0, 0) < 0, "prctl", errno);
+    thread_slack = value;
+}
+
+timespec CoalescingGroup::get_thread_slack()
+{
+    const int slack = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+    sysexcept(slack < 0, "prctl", errno);
+    return nsec_to_timespec(slack);
+}
+
+CoalescedTimer::CoalescedTimer(CoalescingGroup &group, const timespec &interval, const timespec &slack,
+        Callback callback, void *arg) noexcept :
+        CoalescedTimer(group, interval, interval, slack, callback, arg)
+{
+}
+
+CoalescedTimer::CoalescedTimer(CoalescingGroup &group, const timespec &interval, const timespec &value,
+        const timespec &slack, Callback callback, void *arg) noexcept :
+        ITimer(-1, interval, value),
+        group(group),
+        expires(0),
+        interval(0),
+        slack(0),
+        callback(callback),
+        arg(arg)
+{
+    node.prev = nullptr;
+    node.next = nullptr;
+    node.owner = this;
+    set_slack(slack);
+}
+
+CoalescedTimer::~CoalescedTimer( )
+{
+    // stop here, ITimer::~ITimer() can not call the overridden settime()
+    if(is_running()) stop();
+}
+
+void CoalescedTimer::unlink() noexcept
+{
+    if(!node.next) return;
+
+    list_remove(&node);
+    --group.armed;
+}
+
+itimerspec CoalescedTimer::remaining() const
+{
+    itimerspec ret_val;
+    ret_val.it_interval = nsec_to_timespec(interval);
+    ret_val.it_value = {0, 0};
+    if(!node.next) return ret_val;
+
+    // due, but not fired yet (within the slack) --> smallest value that does not disarm the timer
+    const std::int64_t value = expires - monotonic_now();
+    ret_val.it_value = nsec_to_timespec(value > 0 ? value : 1);
+    return ret_val;
+}
+
+void CoalescedTimer::settime(const itimerspec &new_value, itimerspec *old_value)
+{
+    if(old_value) *old_value = remaining();
+
+    unlink();
+
+    const auto value = to_nsec(new_value.it_value);
+    if(value <= 0) return;
+
+    interval = static_cast<std::int64_t>(to_nsec(new_value.it_interval));
+    expires = monotonic_now() + static_cast<std::int64_t>(value);
+    list_append(&group.armed_list, &node);
+    ++group.armed;
+}
+
+void CoalescedTimer::gettime(itimerspec &curr_value) const
+{
+    curr_value = remaining();
+}
+
+TimerBackend CoalescedTimer::backend_kind() const noexcept
+{
+    return TimerBackend::coalesced;
+}
+
+bool CoalescedTimer::value_predictable() const noexcept
+{
+    return false;
+}
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -0,0 +1,324 @@
+/*
+ * \file DeadlineManager.cpp
+ * \brief Source file de::Koesling::ITimer::DeadlineManager
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "DeadlineManager.hpp"
+#include "sysexcept.hpp"
+#include "destructor_exception.hpp"
+#include <cerrno>
+#include <iostream>
+#include <stdexcept>
+#include <sysexits.h>
+#include <utility>
+
+//! interval of the underlying timer (only relevant if process() is not called after an expiration)
+static constexpr timeval FALLBACK_INTERVAL = {3600, 0};
+
+//! current time of CLOCK_MONOTONIC in nanoseconds
+static std::int64_t monotonic_now()
+{
+    timespec now;
+    sysexcept(clock_gettime(CLOCK_MONOTONIC, &now) < 0, "clock_gettime", errno);
+    return static_cast<std::int64_t>(de::Koesling::ITimer::to_nsec(now));
+}
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+constexpr std::uint32_t DeadlineManager::NIL;
+
+std::atomic<DeadlineManager*> DeadlineManager::instance(nullptr);
+
+void DeadlineManager::signal_handler(int sig)
+{
+    static_cast<void>(sig);
+
+    DeadlineManager *manager = instance.load(std::memory_order_relaxed);
+    if(manager) manager->notify();
+}
+
+DeadlineManager::DeadlineManager(std::size_t capacity) :
+        timer(FALLBACK_INTERVAL),
+        root(NIL),
+        free_list(NIL),
+        armed(0),
+        cancelled(0),
+        timer_deadline(0),
+        rearms(0),
+        expired(false)
+{
+    if(capacity == 0 || capacity >= NIL)
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": invalid capacity");
+
+    nodes.resize(capacity);
+    for(std::size_t i = capacity; i-- > 0;)
+    {
+        nodes[i].state = NodeState::FREE;
+        nodes[i].generation = 0;
+        nodes[i].child = NIL;
+        nodes[i].sibling = free_list;
+        free_list = static_cast<std::uint32_t>(i);
+    }
+
+    // install signal handler
+    struct sigaction action;
+    action.sa_handler = signal_handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+
+    instance.store(this);
+    if(sigaction(SIGALRM, &action, &old_action) < 0)
+    {
+        int error = errno;
+        instance.store(nullptr);
+        sysexcept(true, "sigaction", error);
+    }
+}
+
+DeadlineManager::~DeadlineManager()
+{
+    // timer must be stopped before the signal handler is restored
+    if(timer.is_running())
+    {
+        try
+        {
+            timer.stop();
+        }
+        catch (const std::system_error& e)
+        {
+            destructor_exception_terminate(e, std::cerr, EX_OSERR);
+        }
+    }
+
+    sigaction(SIGALRM, &old_action, nullptr);
+    instance.store(nullptr);
+}
+
+std::uint32_t DeadlineManager::meld(std::uint32_t first, std::uint32_t second) noexcept
+{
+    if(first == NIL) return second;
+    if(second == NIL) return first;
+
+    if(nodes[second].expires < nodes[first].expires) std::swap(first, second);
+
+    // second becomes the first child of first
+    nodes[second].sibling = nodes[first].child;
+    nodes[first].child = second;
+    return first;
+}
+
+std::uint32_t DeadlineManager::merge_pairs(std::uint32_t first) noexcept
+{
+    // first pass: meld pairs from left to right (results are stacked via sibling)
+    std::uint32_t pairs = NIL;
+    while(first != NIL)
+    {
+        const std::uint32_t a = first;
+        const std::uint32_t b = nodes[a].sibling;
+        if(b == NIL)
+        {
+            nodes[a].sibling = pairs;
+            pairs = a;
+            break;
+        }
+
+        first = nodes[b].sibling;
+        nodes[a].sibling = NIL;
+        nodes[b].sibling = NIL;
+
+        const std::uint32_t melded = meld(a, b);
+        nodes[melded].sibling = pairs;
+        pairs = melded;
+    }
+
+    // second pass: meld from right to left
+    std::uint32_t result = NIL;
+    while(pairs != NIL)
+    {
+        const std::uint32_t next = nodes[pairs].sibling;
+        nodes[pairs].sibling = NIL;
+        result = meld(result, pairs);
+        pairs = next;
+    }
+
+    return result;
+}
+
+std::uint32_t DeadlineManager::pop() noexcept
+{
+    const std::uint32_t index = root;
+    root = merge_pairs(nodes[index].child);
+    nodes[index].child = NIL;
+    return index;
+}
+
+void DeadlineManager::release(std::uint32_t index) noexcept
+{
+    Node &node = nodes[index];
+    node.state = NodeState::FREE;
+    ++node.generation;
+    node.child = NIL;
+    node.sibling = free_list;
+    free_list = index;
+}
+
+void DeadlineManager::purge() noexcept
+{
+    root = NIL;
+    for(std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        const std::uint32_t index = static_cast<std::uint32_t>(i);
+        switch(nodes[i].state)
+        {
+            case NodeState::ARMED:
+                nodes[i].child = NIL;
+                nodes[i].sibling = NIL;
+                root = meld(root, index);
+                break;
+            case NodeState::CANCELLED:
+                release(index);
+                break;
+            case NodeState::FREE:
+            default:
+                break;
+        }
+    }
+
+    cancelled = 0;
+}
+
+void DeadlineManager::rearm(std::int64_t now)
+{
+    if(root == NIL)
+    {
+        if(timer.is_running()) timer.stop();
+        timer_deadline = 0;
+        return;
+    }
+
+    const std::int64_t deadline = nodes[root].expires;
+    if(deadline == timer_deadline) return;
+
+    if(timer.is_running()) timer.stop();
+    timer.start(nsec_to_timespec(deadline > now ? deadline - now : 1));
+    timer_deadline = deadline;
+    ++rearms;
+}
+
+DeadlineManager::Deadline DeadlineManager::arm(const timespec &timeout, Callback callback, void *arg)
+{
+    if(free_list == NIL && cancelled) purge();
+    if(free_list == NIL) throw std::length_error(std::string(__PRETTY_FUNCTION__) + ": pool exhausted");
+
+    const std::int64_t now = monotonic_now();
+
+    const std::uint32_t index = free_list;
+    Node &node = nodes[index];
+    free_list = node.sibling;
+
+    node.expires = now + static_cast<std::int64_t>(to_nsec(timeout));
+    node.callback = callback;
+    node.arg = arg;
+    node.child = NIL;
+    node.sibling = NIL;
+    node.state = NodeState::ARMED;
+
+    root = meld(root, index);
+    ++armed;
+
+    // tickless: only an earlier deadline re-arms the timer
+    if(root == index)
+    {
+        try
+        {
+            rearm(now);
+        }
+        catch(...)
+        {
+            // the deadline stays in the heap, but is not returned
+            node.state = NodeState::CANCELLED;
+            --armed;
+            ++cancelled;
+            throw;
+        }
+    }
+
+    return Deadline{index, node.generation};
+}
+
+bool DeadlineManager::cancel(const Deadline &deadline) noexcept
+{
+    if(!is_armed(deadline)) return false;
+
+    nodes[deadline.index].state = NodeState::CANCELLED;
+    --armed;
+    ++cancelled;
+
+    // amortized O(1): at least nodes.size() / 2 cancels since the last purge
+    if(cancelled >= nodes.size() / 2 && cancelled > armed) purge();
+
+    return true;
+}
+
+std::size_t DeadlineManager::process()
+{
+    // the timer has expired --> it is no longer armed for a deadline
+    if(expired.exchange(false, std::memory_order_relaxed)) timer_deadline = 0;
+
+    std::size_t count = 0;
+    std::int64_t now = monotonic_now();
+
+    while(root != NIL)
+    {
+        Node &node = nodes[root];
+
+        if(node.state == NodeState::CANCELLED)
+        {
+            release(pop());
+            --cancelled;
+            continue;
+        }
+
+        if(node.expires > now)
+        {
+            // callbacks may take a while
+            now = monotonic_now();
+            if(node.expires > now) break;
+        }
+
+        const Callback callback = node.callback;
+        void *const arg = node.arg;
+        release(pop());
+        --armed;
+        ++count;
+
+        try
+        {
+            callback(arg);
+        }
+        catch(...)
+        {
+            // the remaining deadlines must not stay unarmed
+            rearm(monotonic_now());
+            throw;
+        }
+    }
+
+    rearm(now);
+    return count;
+}
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
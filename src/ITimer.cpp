@@ -13,68 +13,340 @@
  */
 
 #include "ITimer.hpp"
+#include "TimeArithmetic.hpp"
 #include "sysexcept.hpp"
 #include "destructor_exception.hpp"
 #include <cmath>
+#include <csignal>
+#include <cstring>
 #include <limits>
+#include <new>
+#include <stdexcept>
+#include <system_error>
 #include <iostream>
 #include <sysexits.h>
+#include <thread>
+#include <vector>
 
-//! timeval to stop timer
-static constexpr itimerval STOP_TIMER = {{0, 0}, {0, 0}};
+//! timespec to stop timer
+static constexpr itimerspec STOP_TIMER = {{0, 0}, {0, 0}};
+
+//! smallest timer value that does not disarm the timer
+static constexpr timespec MIN_TIMER_VALUE = {0, 1};
+
+//! user cpu time of the process (Linux cpu clock id of pid 0 with CPUCLOCK_VIRT, counts like ITIMER_VIRTUAL)
+static constexpr clockid_t CLOCK_PROCESS_USERTIME = -7;
 
 static constexpr auto _inf = std::numeric_limits<double>::infinity();
-static constexpr auto _nan = std::numeric_limits<double>::quiet_NaN();
 
 #define USEC_PER_SEC 1000000
+#define NSEC_PER_SEC 1000000000
+#define NSEC_PER_USEC 1000
+
+#ifdef ITIMER_INSTRUMENTATION
+#define ITIMER_COUNT(counter) counters.counter.fetch_add(1, std::memory_order_relaxed)
+#else
+#define ITIMER_COUNT(counter) static_cast<void>(0)
+#endif
+
+//! convert timespec to timeval (nanoseconds are rounded up)
+static timeval timespec_to_timeval_ceil(const timespec &time) noexcept
+{
+    timeval ret_val;
+    ret_val.tv_sec = time.tv_sec;
+    ret_val.tv_usec = (time.tv_nsec + NSEC_PER_USEC - 1) / NSEC_PER_USEC;
+    if(ret_val.tv_usec >= USEC_PER_SEC)
+    {
+        ret_val.tv_sec += 1;
+        ret_val.tv_usec -= USEC_PER_SEC;
+    }
+    return ret_val;
+}
+
+//! checkpoint magic
+static constexpr char CHECKPOINT_MAGIC[4] = {'I', 'T', 'C', 'P'};
+
+//! checkpoint record flag: timer was running
+static constexpr std::uint32_t CHECKPOINT_RUNNING = 1;
+
+//! store little endian integer
+template <typename T>
+static void store_le(unsigned char *buffer, T value) noexcept
+{
+    for(std::size_t i = 0; i < sizeof(T); ++i)
+        buffer[i] = static_cast<unsigned char>(static_cast<std::uint64_t>(value) >> (8 * i));
+}
+
+//! load little endian integer
+template <typename T>
+static T load_le(const unsigned char *buffer) noexcept
+{
+    std::uint64_t value = 0;
+    for(std::size_t i = 0; i < sizeof(T); ++i)
+        value |= static_cast<std::uint64_t>(buffer[i]) << (8 * i);
+    return static_cast<T>(value);
+}
+
+//! clock id without the process/thread id of a cpu time clock (Linux: ~pid << 3 | clock type)
+static constexpr clockid_t checkpoint_clock(clockid_t clock) noexcept
+{
+    return clock < 0 ? (-8 | (clock & 7)) : clock;
+}
+
+//! load timespec from checkpoint record (false: negative or not normalized)
+static bool load_timespec(const unsigned char *sec, const unsigned char *nsec, timespec &time) noexcept
+{
+    const auto seconds = load_le<std::int64_t>(sec);
+    const auto nanoseconds = load_le<std::uint32_t>(nsec);
+    if(seconds < 0 || nanoseconds >= NSEC_PER_SEC) return false;
+
+    time.tv_sec = static_cast<time_t>(seconds);
+    time.tv_nsec = static_cast<long>(nanoseconds);
+    return true;
+}
 
 namespace de {
 namespace Koesling {
 namespace ITimer {
 
+constexpr std::uint16_t ITimer::CHECKPOINT_VERSION;
+constexpr std::size_t ITimer::CHECKPOINT_HEADER_SIZE;
+constexpr std::size_t ITimer::CHECKPOINT_RECORD_SIZE;
+
+//! write checkpoint header
+static void store_checkpoint_header(unsigned char *buffer, std::size_t count) noexcept
+{
+    std::memcpy(buffer, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    store_le<std::uint16_t>(buffer + 4, ITimer::CHECKPOINT_VERSION);
+    store_le<std::uint16_t>(buffer + 6, ITimer::CHECKPOINT_RECORD_SIZE);
+    store_le<std::uint32_t>(buffer + 8, static_cast<std::uint32_t>(count));
+    store_le<std::uint32_t>(buffer + 12, 0);
+}
+
+//! check checkpoint header, returns number of records
+static std::size_t load_checkpoint_header(const unsigned char *buffer, std::size_t size, const char *function)
+{
+    if(size < ITimer::CHECKPOINT_HEADER_SIZE || std::memcmp(buffer, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0)
+        throw std::invalid_argument(std::string(function) + ": not a timer checkpoint");
+
+    if(load_le<std::uint16_t>(buffer + 4) != ITimer::CHECKPOINT_VERSION ||
+       load_le<std::uint16_t>(buffer + 6) != ITimer::CHECKPOINT_RECORD_SIZE)
+        throw std::invalid_argument(std::string(function) + ": unsupported checkpoint version");
+
+    const std::size_t count = load_le<std::uint32_t>(buffer + 8);
+    if(size < ITimer::checkpoint_size(count))
+        throw std::invalid_argument(std::string(function) + ": checkpoint is truncated");
+
+    return count;
+}
+
 std::ostream* ITimer::error_stream = &std::cerr;
 
-bool ITimer_Real::instance_exists = false;
-bool ITimer_Virtual::instance_exists = false;
-bool ITimer_Prof::instance_exists = false;
+std::atomic<bool> ITimer_Real::instance_exists(false);
+std::atomic<bool> ITimer_Virtual::instance_exists(false);
+std::atomic<bool> ITimer_Prof::instance_exists(false);
 
 void ITimer::adjust_speed(double new_factor)
 {
     // not running? --> no time adjustment possible
-    if(!running) throw std::runtime_error(std::string(__PRETTY_FUNCTION__) + ": timer not running!");
+    if(!state.running) throw std::runtime_error(std::string(__PRETTY_FUNCTION__) + ": timer not running!");
+
+    const timespec now = reference_time();
+
+    // predicted current timer value (speed factor 1.0)
+    const timespec predicted = timespec_add(predict_value(state, now) * state.speed_factor, state.drift_pending);
+
+    itimerspec val;
+    val.it_interval = state.timer_interval / new_factor;
+    val.it_value = predicted / new_factor;
+
+    if(timespec_is_zero(val.it_interval))
+        throw std::runtime_error(std::string(__PRETTY_FUNCTION__) +
+                ": invalid timer values due to to a to small speed factor");
+
+    // zero would disarm the timer
+    if(timespec_compare(val.it_value, MIN_TIMER_VALUE) < 0) val.it_value = MIN_TIMER_VALUE;
+
+    // re-arm timer with a single system call
+    itimerspec old;
+    arm(val, &old);
+    ITIMER_COUNT(syscalls);
+    ITIMER_COUNT(rearms);
+
+    // correct the difference between predicted and actual value later
+    const timespec actual = apply_drift(old.it_value * state.speed_factor);
+    state.drift_pending = timespec_sub(actual, val.it_value * new_factor);
+
+    state.expirations += predict_expirations(state, now);
+    update_scaled_time(now);
+    state.armed_value = val;
+}
+
+void ITimer::arm(const itimerspec &new_value, itimerspec *old_value)
+{
+    const bool published = (arm_sequence.load(std::memory_order_relaxed) & 1) == 0;
+    if(published) arm_sequence.fetch_add(1, std::memory_order_seq_cst);
 
-    // read current timer value
+    try
+    {
+        settime(new_value, old_value);
+    }
+    catch(...)
+    {
+        // underlying timer not modified
+        if(published) arm_sequence.fetch_add(1, std::memory_order_release);
+        throw;
+    }
+}
+
+void ITimer::settime(const itimerspec &new_value, itimerspec *old_value)
+{
+    itimerval new_val;
+    new_val.it_interval = timespec_to_timeval_ceil(new_value.it_interval);
+    new_val.it_value = timespec_to_timeval_ceil(new_value.it_value);
+
+    itimerval old_val;
+    sysexcept(setitimer(type, &new_val, &old_val) < 0, "setitimer", errno);
+
+    if(old_value)
+    {
+        old_value->it_interval = timeval_to_timespec(old_val.it_interval);
+        old_value->it_value = timeval_to_timespec(old_val.it_value);
+    }
+}
+
+void ITimer::gettime(itimerspec &curr_value) const
+{
     itimerval val;
-    sysexcept(setitimer(type, &STOP_TIMER, &val) < 0, "setitimer", errno);
+    sysexcept(getitimer(type, &val) < 0, "getitimer", errno);
+
+    curr_value.it_interval = timeval_to_timespec(val.it_interval);
+    curr_value.it_value = timeval_to_timespec(val.it_value);
+}
+
+clockid_t ITimer::reference_clock() const noexcept
+{
+    switch(type)
+    {
+        case ITIMER_VIRTUAL:
+            return CLOCK_PROCESS_USERTIME;
+        case ITIMER_PROF:
+            return CLOCK_PROCESS_CPUTIME_ID;
+        default:
+            return CLOCK_MONOTONIC;
+    }
+}
+
+TimerBackend ITimer::backend_kind() const noexcept
+{
+    return type >= 0 ? TimerBackend::setitimer : TimerBackend::other;
+}
+
+bool ITimer::value_predictable() const noexcept
+{
+    const clockid_t clock = reference_clock();
+    return clock == CLOCK_MONOTONIC || clock == CLOCK_BOOTTIME;
+}
+
+int ITimer::get_signal() const noexcept
+{
+    switch(type)
+    {
+        case ITIMER_REAL:
+            return SIGALRM;
+        case ITIMER_VIRTUAL:
+            return SIGVTALRM;
+        case ITIMER_PROF:
+            return SIGPROF;
+        default:
+            return 0;
+    }
+}
+
+bool ITimer::read_reference_clock(timespec &now) const noexcept
+{
+    return clock_gettime(reference_clock(), &now) == 0;
+}
+
+timespec ITimer::reference_time() const
+{
+    timespec now;
+    sysexcept(!read_reference_clock(now), "clock_gettime", errno);
+    return now;
+}
+
+void ITimer::update_scaled_time(const timespec &now) noexcept
+{
+    state.scaled_time = timespec_add(state.scaled_time,
+            timespec_mul(timespec_sub(now, state.scaled_since), state.speed_factor));
+    state.scaled_since = now;
+}
+
+timespec ITimer::predict_value(const State &state, const timespec &now) noexcept
+{
+    const int128_t elapsed = to_nsec(now) - to_nsec(state.scaled_since);
+    const int128_t value = to_nsec(state.armed_value.it_value);
+    if(elapsed < value) return nsec_to_timespec(value - elapsed);
+
+    // expired --> reloaded with interval
+    const int128_t interval = to_nsec(state.armed_value.it_interval);
+    if(interval <= 0) return {0, 0};
+    return nsec_to_timespec(interval - (elapsed - value) % interval);
+}
+
+std::uint64_t ITimer::predict_expirations(const State &state, const timespec &now) noexcept
+{
+    const int128_t elapsed = to_nsec(now) - to_nsec(state.scaled_since);
+    const int128_t value = to_nsec(state.armed_value.it_value);
+    if(elapsed < value) return 0;
 
-    // set timer interval
-    val.it_interval = timer_interval / new_factor;
+    const int128_t interval = to_nsec(state.armed_value.it_interval);
+    if(interval <= 0) return 1;
+    return static_cast<std::uint64_t>(1 + (elapsed - value) / interval);
+}
 
-    // scale timer value
-    val.it_value *= speed_factor / new_factor;
+timespec ITimer::apply_drift(const timespec &value) noexcept
+{
+    const timespec abs_drift = to_nsec(state.drift_pending) < 0 ?
+            timespec_sub({0, 0}, state.drift_pending) : state.drift_pending;
+    state.drift_corrected = timespec_add(state.drift_corrected, abs_drift);
 
-    // set new timer value
-    sysexcept(setitimer(type, &val, nullptr), "setitimer", errno);
+    const timespec ret_val = timespec_add(value, state.drift_pending);
+    state.drift_pending = {0, 0};
+    return ret_val;
 }
 
 ITimer::ITimer(int type, const timeval &interval) noexcept :
-        timer_value(interval), timer_interval(interval), type(type),
-        speed_factor(1.0),  // normal speed
-        running(false)      // not running
+        ITimer(type, timeval_to_timespec(interval))
 {
 }
 
 ITimer::ITimer(int type, const timeval &interval,
         const timeval &value) noexcept :
-        timer_value(value), timer_interval(interval), type(type),
-        speed_factor(1.0),  // normal speed
-        running(false)      // not running
+        ITimer(type, timeval_to_timespec(interval), timeval_to_timespec(value))
+{
+}
+
+ITimer::ITimer(int type, const timespec &interval) noexcept :
+        ITimer(type, interval, interval)
+{
+}
+
+ITimer::ITimer(int type, const timespec &interval,
+        const timespec &value) noexcept :
+        type(type),
+        state({value, interval,
+               1.0,     // normal speed
+               false,   // not running
+               {0, 0}, {0, 0}, STOP_TIMER, {0, 0}, {0, 0}, 0}),
+        snapshot(state),
+        arm_sequence(0)
 {
 }
 
 ITimer::~ITimer( )
 {
-    if(running) // stop timer if running
+    if(is_running()) // stop timer if running
     {
         try
         {
@@ -87,83 +359,266 @@ ITimer::~ITimer( )
     }
 }
 
+//! error category of TimerErrc
+class TimerCategory : public std::error_category
+{
+    public:
+        const char* name() const noexcept override
+        {
+            return "ITimer";
+        }
+
+        std::string message(int error) const override
+        {
+            switch(static_cast<TimerErrc>(error))
+            {
+                case TimerErrc::already_started:
+                    return "timer already started";
+                case TimerErrc::already_stopped:
+                    return "timer already stopped";
+                case TimerErrc::speed_factor_too_small:
+                    return "invalid timer values due to to a to small speed factor";
+                case TimerErrc::speed_factor_not_positive:
+                    return "Negative values not allowed!";
+                case TimerErrc::speed_factor_not_finite:
+                    return "invalid double value!";
+                case TimerErrc::backend_failure:
+                    return "underlying timer failed";
+                default:
+                    return "unknown error";
+            }
+        }
+};
+
+const std::error_category& timer_category() noexcept
+{
+    static const TimerCategory category;
+    return category;
+}
+
+void ITimer::throw_error(const std::error_code &error, const char *function)
+{
+    const std::string what = std::string(function) + ": " + error.message();
+
+    if(error.category() != timer_category()) throw std::system_error(error, function);
+
+    switch(static_cast<TimerErrc>(error.value()))
+    {
+        case TimerErrc::already_started:
+            throw std::logic_error(what);
+        case TimerErrc::speed_factor_not_positive:
+        case TimerErrc::speed_factor_not_finite:
+            throw std::invalid_argument(what);
+        case TimerErrc::already_stopped:
+        case TimerErrc::speed_factor_too_small:
+        case TimerErrc::backend_failure:
+        default:
+            throw std::runtime_error(what);
+    }
+}
+
+//! call function, convert exceptions (system errors of the underlying timer) to error codes
+template <typename Function>
+static std::error_code no_throw(Function function) noexcept
+{
+    try
+    {
+        return function();
+    }
+    catch(const std::system_error &e)
+    {
+        return e.code();
+    }
+    catch(const std::bad_alloc &)
+    {
+        return std::make_error_code(std::errc::not_enough_memory);
+    }
+    catch(...)
+    {
+        return make_error_code(TimerErrc::backend_failure);
+    }
+}
+
 void ITimer::start( )
 {
-    if(running) throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": timer already started");
+    WriteLock lock(*this);
+    const std::error_code error = start_locked();
+    if(error) throw_error(error, __PRETTY_FUNCTION__);
+}
+
+std::error_code ITimer::start_locked( )
+{
+    if(state.running) return make_error_code(TimerErrc::already_started);
 
     // create scaled timer value
-    itimerval timer_val;
-    timer_val.it_interval = timer_interval / speed_factor;
-    timer_val.it_value = timer_value / speed_factor;
+    itimerspec timer_val;
+    timer_val.it_interval = state.timer_interval / state.speed_factor;
+    timer_val.it_value = state.timer_value / state.speed_factor;
 
-    if(timer_val.it_interval.tv_sec == 0 && timer_val.it_interval.tv_usec == 0)
-        throw std::runtime_error(std::string(__PRETTY_FUNCTION__) + 
-                ": invalid timer values due to to a to small speed factor");
+    if(timer_val.it_interval.tv_sec == 0 && timer_val.it_interval.tv_nsec == 0)
+        return make_error_code(TimerErrc::speed_factor_too_small);
+
+    // may throw --> read before the timer is started (nothing below the arm throws)
+    const timespec now = reference_time();
 
     //start timer;
-    sysexcept(setitimer(type, &timer_val, nullptr) < 0, "setitimer", errno);
+    arm(timer_val, nullptr);
+    ITIMER_COUNT(syscalls);
+    ITIMER_COUNT(rearms);
+    state.scaled_since = now;
+    state.armed_value = timer_val;
+
+    state.running = true;
+    return std::error_code();
+}
 
-    running = true;
+void ITimer::start(const timeval &value)
+{
+    start(timeval_to_timespec(value));
+}
+
+void ITimer::start(const timespec &value)
+{
+    WriteLock lock(*this);
+    if(state.running) throw_error(make_error_code(TimerErrc::already_started), __PRETTY_FUNCTION__);
+
+    state.timer_value = value;
+    const std::error_code error = start_locked();
+    if(error) throw_error(error, __PRETTY_FUNCTION__);
 }
 
 void ITimer::stop( )
 {
-    if(!running) throw std::runtime_error(std::string(__PRETTY_FUNCTION__) + ": timer already stopped");
+    WriteLock lock(*this);
+    const std::error_code error = stop_locked();
+    if(error) throw_error(error, __PRETTY_FUNCTION__);
+}
+
+std::error_code ITimer::stop_locked( )
+{
+    if(!state.running) return make_error_code(TimerErrc::already_stopped);
+
+    // may throw --> read before the timer is stopped (nothing below the arm throws)
+    const timespec now = reference_time();
 
     // stop timer and save value
-    itimerval timer_val;
-    int temp = setitimer(type, &STOP_TIMER, &timer_val);
-    sysexcept(temp < 0, "setitimer", errno);
+    itimerspec timer_val;
+    arm(STOP_TIMER, &timer_val);
+    ITIMER_COUNT(syscalls);
 
     // normalize value
-    timer_value = timer_val.it_value * speed_factor;
+    state.timer_value = apply_drift(timer_val.it_value * state.speed_factor);
+    if(to_nsec(state.timer_value) < 0) state.timer_value = {0, 0};
+
+    state.expirations += predict_expirations(state, now);
+    update_scaled_time(now);
 
-    running = false;
+    state.running = false;
+    return std::error_code();
 }
 
 // check for nan and inf --> disable direct float equal check warning
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wfloat-equal"
-void ITimer::set_speed_factor(const double speed_factor)
+std::error_code ITimer::check_speed_factor(double speed_factor) noexcept
 {
-    // check speed_factor
-    if(speed_factor <= 0.0) 
-    throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": Negative values not allowed!");
+    if(speed_factor <= 0.0) return make_error_code(TimerErrc::speed_factor_not_positive);
 
-    if(speed_factor == _inf || speed_factor == _nan)
-        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": invalid double value!");
+    if(speed_factor == _inf || std::isnan(speed_factor))
+        return make_error_code(TimerErrc::speed_factor_not_finite);
 
-    bool running = this->running;
+    return std::error_code();
+}
+// re-enable warnings
+#pragma GCC diagnostic pop
 
-    if(running) stop();
+std::error_code ITimer::set_speed_locked(double speed_factor)
+{
+    // re-arm running timer
+    if(state.running)
+    {
+        if(timespec_is_zero(state.timer_interval / speed_factor))
+            return make_error_code(TimerErrc::speed_factor_too_small);
+
+        adjust_speed(speed_factor);
+    }
 
     // save speed factor
-    this->speed_factor = speed_factor;
+    state.speed_factor = speed_factor;
+    return std::error_code();
+}
 
-    if(running) start();
+void ITimer::set_speed_factor(const double speed_factor)
+{
+    // check speed_factor
+    std::error_code error = check_speed_factor(speed_factor);
+    if(error) throw_error(error, __PRETTY_FUNCTION__);
+
+    WriteLock lock(*this);
+    error = set_speed_locked(speed_factor);
+    if(error) throw_error(error, __PRETTY_FUNCTION__);
 }
-// re-enable warnings
-#pragma GCC diagnostic pop
 
 void ITimer::set_speed_to_normal( )
 {
-    // adjust speed if running
-    if(running)
-        adjust_speed(1.0);
+    WriteLock lock(*this);
+    const std::error_code error = set_speed_locked(1.0);
+    if(error) throw_error(error, __PRETTY_FUNCTION__);
+}
+
+std::error_code ITimer::try_start( ) noexcept
+{
+    return no_throw([this]() {
+        WriteLock lock(*this);
+        return start_locked();
+    });
+}
+
+std::error_code ITimer::try_start(const timespec &value) noexcept
+{
+    return no_throw([this, &value]() {
+        WriteLock lock(*this);
+        if(state.running) return make_error_code(TimerErrc::already_started);
 
-    // save speed factor
-    speed_factor = 1.0;
+        state.timer_value = value;
+        return start_locked();
+    });
+}
+
+std::error_code ITimer::try_stop( ) noexcept
+{
+    return no_throw([this]() {
+        WriteLock lock(*this);
+        return stop_locked();
+    });
+}
+
+std::error_code ITimer::try_set_speed_factor(double speed_factor) noexcept
+{
+    const std::error_code error = check_speed_factor(speed_factor);
+    if(error) return error;
+
+    return no_throw([this, speed_factor]() {
+        WriteLock lock(*this);
+        return set_speed_locked(speed_factor);
+    });
+}
+
+std::error_code ITimer::try_set_speed_to_normal( ) noexcept
+{
+    return no_throw([this]() {
+        WriteLock lock(*this);
+        return set_speed_locked(1.0);
+    });
 }
 
 ITimer_Real::ITimer_Real(const timeval &interval) :
         ITimer(ITIMER_REAL, interval)
 {
     // prevent multiple instances
-    if(instance_exists)
+    if(instance_exists.exchange(true))
         throw std::logic_error(std::string(__PRETTY_FUNCTION__) + 
                 ": only one interval timer of each type per process possible");
-
-    instance_exists = true;
 }
 
 ITimer_Real::ITimer_Real(const timeval &interval,
@@ -171,15 +626,26 @@ ITimer_Real::ITimer_Real(const timeval &interval,
         ITimer(ITIMER_REAL, interval, value)
 {
     // prevent multiple instances
-    if(instance_exists)
+    if(instance_exists.exchange(true))
         throw std::logic_error(std::string(__PRETTY_FUNCTION__) + 
                 ": only one interval timer of each type per process possible");
-
-    instance_exists = true;
 }
 
 ITimer_Real::~ITimer_Real( )
 {
+    // stop before a new instance can use the timer
+    if(is_running())
+    {
+        try
+        {
+            stop();
+        }
+        catch (const std::system_error& e)
+        {
+            destructor_exception_terminate(e, std::cerr, EX_OSERR);
+        }
+    }
+
     // allow new instance
     instance_exists = false;
 }
@@ -188,11 +654,9 @@ ITimer_Virtual::ITimer_Virtual(const timeval &interval) :
         ITimer(ITIMER_VIRTUAL, interval)
 {
     // prevent multiple instances
-    if(instance_exists)
+    if(instance_exists.exchange(true))
         throw std::logic_error(std::string(__PRETTY_FUNCTION__) + 
                 ": only one interval timer of each type per process possible");
-
-    instance_exists = true;
 }
 
 ITimer_Virtual::ITimer_Virtual(const timeval &interval,
@@ -200,15 +664,26 @@ ITimer_Virtual::ITimer_Virtual(const timeval &interval,
         ITimer(ITIMER_VIRTUAL, interval, value)
 {
     // prevent multiple instances
-    if(instance_exists)
+    if(instance_exists.exchange(true))
         throw std::logic_error(std::string(__PRETTY_FUNCTION__) + 
                 ": only one interval timer of each type per process possible");
-
-    instance_exists = true;
 }
 
 ITimer_Virtual::~ITimer_Virtual( )
 {
+    // stop before a new instance can use the timer
+    if(is_running())
+    {
+        try
+        {
+            stop();
+        }
+        catch (const std::system_error& e)
+        {
+            destructor_exception_terminate(e, std::cerr, EX_OSERR);
+        }
+    }
+
     // allow new instance
     instance_exists = false;
 }
@@ -217,11 +692,9 @@ ITimer_Prof::ITimer_Prof(const timeval &interval) :
         ITimer(ITIMER_PROF, interval)
 {
     // prevent multiple instances
-    if(instance_exists)
+    if(instance_exists.exchange(true))
         throw std::logic_error(std::string(__PRETTY_FUNCTION__) + 
                 ": only one interval timer of each type per process possible");
-
-    instance_exists = true;
 }
 
 ITimer_Prof::ITimer_Prof(const timeval &interval,
@@ -229,23 +702,33 @@ ITimer_Prof::ITimer_Prof(const timeval &interval,
         ITimer(ITIMER_PROF, interval, value)
 {
     // prevent multiple instances
-    if(instance_exists)
+    if(instance_exists.exchange(true))
         throw std::logic_error(std::string(__PRETTY_FUNCTION__) + 
                 ": only one interval timer of each type per process possible");
-
-    instance_exists = true;
 }
 
 ITimer_Prof::~ITimer_Prof( )
 {
+    // stop before a new instance can use the timer
+    if(is_running())
+    {
+        try
+        {
+            stop();
+        }
+        catch (const std::system_error& e)
+        {
+            destructor_exception_terminate(e, std::cerr, EX_OSERR);
+        }
+    }
+
     // allow new instance
     instance_exists = false;
 }
 
 timeval& operator *=(timeval &left, double right) noexcept
 {
-    double timer_value = timeval_to_double(left) * right;
-    left = double_to_timeval(timer_value);
+    left = timeval_mul(left, right);
     return left;
 }
 
@@ -272,8 +755,7 @@ itimerval operator *(const itimerval &left, double right) noexcept
 
 timeval& operator /=(timeval &left, double right) noexcept
 {
-    double timer_value = timeval_to_double(left) / right;
-    left = double_to_timeval(timer_value);
+    left = timeval_div(left, right);
     return left;
 }
 
@@ -313,45 +795,422 @@ timeval double_to_timeval(const double time) noexcept
     return ret_val;
 }
 
+timespec& operator *=(timespec &left, double right) noexcept
+{
+    left = timespec_mul(left, right);
+    return left;
+}
+
+itimerspec& operator *=(itimerspec &left, double right) noexcept
+{
+    left.it_interval *= right;
+    left.it_value *= right;
+    return left;
+}
+
+timespec operator *(const timespec &left, double right) noexcept
+{
+    auto ret_val = left;
+    ret_val *= right;
+    return ret_val;
+}
+
+itimerspec operator *(const itimerspec &left, double right) noexcept
+{
+    auto ret_val = left;
+    ret_val *= right;
+    return ret_val;
+}
+
+timespec& operator /=(timespec &left, double right) noexcept
+{
+    left = timespec_div(left, right);
+    return left;
+}
+
+itimerspec& operator /=(itimerspec &left, double right) noexcept
+{
+    left.it_interval /= right;
+    left.it_value /= right;
+    return left;
+}
+
+timespec operator /(const timespec &left, double right) noexcept
+{
+    auto ret_val = left;
+    ret_val /= right;
+    return ret_val;
+}
+
+itimerspec operator /(const itimerspec &left, double right) noexcept
+{
+    auto ret_val = left;
+    ret_val /= right;
+    return ret_val;
+}
+
+double timespec_to_double(const timespec &time) noexcept
+{
+    double ret_val = static_cast<double>(time.tv_sec)+
+            static_cast<double>(time.tv_nsec) / static_cast<double>(NSEC_PER_SEC);
+    return ret_val;
+}
+
+timespec double_to_timespec(const double time) noexcept
+{
+    timespec ret_val;
+    ret_val.tv_sec = static_cast<time_t>(time);
+    ret_val.tv_nsec = static_cast<long>(fmod(time, 1.0) * static_cast<double>(NSEC_PER_SEC));
+    return ret_val;
+}
+
+timespec timeval_to_timespec(const timeval &time) noexcept
+{
+    timespec ret_val;
+    ret_val.tv_sec = time.tv_sec;
+    ret_val.tv_nsec = time.tv_usec * NSEC_PER_USEC;
+    return ret_val;
+}
+
+timeval timespec_to_timeval(const timespec &time) noexcept
+{
+    timeval ret_val;
+    ret_val.tv_sec = time.tv_sec;
+    ret_val.tv_usec = time.tv_nsec / NSEC_PER_USEC;
+    return ret_val;
+}
+
 void ITimer::to_fstream(std::ofstream &fstream) const
 {
+    // binary format: itimerval
     itimerval val;
-    if(running)
-    {
-        sysexcept(getitimer(type, &val) < 0, "getitimer", errno);
-        val.it_value *= speed_factor;
-    }
-    else
-    {
-        val.it_value = timer_value;
-    }
-
-    val.it_interval = timer_interval;
+    val.it_interval = timespec_to_timeval(get_interval_timespec());
+    val.it_value = timespec_to_timeval(get_timer_value_timespec());
 
     fstream.write(reinterpret_cast<char*>(&val), sizeof(val));
 }
 
 void ITimer::from_fstream(std::ifstream &fstream)
 {
-    if(running) throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": timer must be stopped!");
+    WriteLock lock(*this);
+    if(state.running) throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": timer must be stopped!");
 
     itimerval val;
     fstream.read(reinterpret_cast<char*>(&val), sizeof(val));
-    timer_interval = val.it_interval;
-    timer_value = val.it_value;
+    state.timer_interval = timeval_to_timespec(val.it_interval);
+    state.timer_value = timeval_to_timespec(val.it_value);
+}
+
+std::size_t ITimer::save_checkpoint(void *buffer, std::size_t size) const
+{
+    const ITimer *timer = this;
+    return save_checkpoint(&timer, 1, buffer, size);
+}
+
+std::size_t ITimer::load_checkpoint(const void *buffer, std::size_t size)
+{
+    ITimer *timer = this;
+    return load_checkpoint(&timer, 1, buffer, size);
+}
+
+std::size_t ITimer::save_checkpoint(const ITimer *const *timers, std::size_t count,
+        void *buffer, std::size_t size)
+{
+    const std::size_t required = checkpoint_size(count);
+    if(size < required)
+        throw std::length_error(std::string(__PRETTY_FUNCTION__) + ": buffer too small");
+
+    auto data = static_cast<unsigned char*>(buffer);
+    store_checkpoint_header(data, count);
+
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        const ITimer &timer = *timers[i];
+        unsigned char *record = data + CHECKPOINT_HEADER_SIZE + i * CHECKPOINT_RECORD_SIZE;
+
+        // consistent state, value is read from the underlying timer
+        timespec now;
+        itimerspec curr_value;
+        const State current = timer.load_state(&now, &curr_value);
+
+        timespec value = current.timer_value;
+        timespec scaled = current.scaled_time;
+        std::uint64_t expirations = current.expirations;
+        if(current.running)
+        {
+            value = unscaled_value(current, curr_value.it_value);
+            scaled = scaled_time_at(current, now);
+            expirations += predict_expirations(current, now);
+        }
+
+        std::uint64_t speed_bits;
+        static_assert(sizeof(speed_bits) == sizeof(current.speed_factor), "double must be 64 bit");
+        std::memcpy(&speed_bits, &current.speed_factor, sizeof(speed_bits));
+
+        store_le<std::int32_t>(record + 0, timer.type);
+        store_le<std::uint32_t>(record + 4, current.running ? CHECKPOINT_RUNNING : 0);
+        store_le<std::uint64_t>(record + 8, speed_bits);
+        store_le<std::int64_t>(record + 16, value.tv_sec);
+        store_le<std::uint32_t>(record + 24, static_cast<std::uint32_t>(value.tv_nsec));
+        store_le<std::uint32_t>(record + 28, static_cast<std::uint32_t>(current.timer_interval.tv_nsec));
+        store_le<std::int64_t>(record + 32, current.timer_interval.tv_sec);
+        store_le<std::int64_t>(record + 40, scaled.tv_sec);
+        store_le<std::uint32_t>(record + 48, static_cast<std::uint32_t>(scaled.tv_nsec));
+        store_le<std::int32_t>(record + 52, checkpoint_clock(timer.reference_clock()));
+        store_le<std::uint64_t>(record + 56, expirations);
+        store_le<std::uint32_t>(record + 64, static_cast<std::uint32_t>(timer.backend_kind()));
+        store_le<std::uint32_t>(record + 68, 0);
+    }
+
+    return required;
+}
+
+std::size_t ITimer::load_checkpoint(ITimer *const *timers, std::size_t count,
+        const void *buffer, std::size_t size)
+{
+    auto data = static_cast<const unsigned char*>(buffer);
+
+    // check everything before the first timer is modified
+    if(load_checkpoint_header(data, size, __PRETTY_FUNCTION__) != count)
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": different number of timers");
+
+    struct Record
+    {
+        timespec value;
+        timespec interval;
+        timespec scaled_time;
+        double speed_factor;
+        std::uint64_t expirations;
+        bool running;
+    };
+    std::vector<Record> records(count);
+
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        const ITimer &timer = *timers[i];
+        const unsigned char *record = data + CHECKPOINT_HEADER_SIZE + i * CHECKPOINT_RECORD_SIZE;
+
+        if(timer.is_running())
+            throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": timer must be stopped!");
+
+        if(load_le<std::int32_t>(record) != timer.type ||
+           load_le<std::uint32_t>(record + 64) != static_cast<std::uint32_t>(timer.backend_kind()))
+            throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": different timer type");
+
+        if(load_le<std::int32_t>(record + 52) != checkpoint_clock(timer.reference_clock()))
+            throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": different reference clock");
+
+        Record &loaded = records[i];
+        const auto speed_bits = load_le<std::uint64_t>(record + 8);
+        std::memcpy(&loaded.speed_factor, &speed_bits, sizeof(loaded.speed_factor));
+        loaded.expirations = load_le<std::uint64_t>(record + 56);
+        loaded.running = load_le<std::uint32_t>(record + 4) & CHECKPOINT_RUNNING;
+
+        if(!load_timespec(record + 16, record + 24, loaded.value) ||
+           !load_timespec(record + 32, record + 28, loaded.interval) ||
+           !load_timespec(record + 40, record + 48, loaded.scaled_time) ||
+           timespec_is_zero(loaded.interval) ||
+           !(loaded.speed_factor > 0.0) || std::isinf(loaded.speed_factor))
+            throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": invalid timer record");
+    }
+
+    // states before the load (restored if a timer can not be started)
+    std::vector<State> previous;
+    previous.reserve(count);
+
+    std::size_t applied = 0;
+    try
+    {
+        for(; applied < count; ++applied)
+        {
+            ITimer &timer = *timers[applied];
+            const Record &loaded = records[applied];
+
+            WriteLock lock(timer);
+            if(timer.state.running)
+                throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": timer was started concurrently!");
+
+            State &state = timer.state;
+            previous.push_back(state);
+            state.timer_value = loaded.value;
+            state.timer_interval = loaded.interval;
+            state.scaled_time = loaded.scaled_time;
+            state.expirations = loaded.expirations;
+            state.drift_pending = {0, 0};
+            state.speed_factor = loaded.speed_factor;
+
+            if(loaded.running)
+            {
+                const std::error_code error = timer.start_locked();
+                if(error)
+                {
+                    state = previous.back();
+                    throw_error(error, __PRETTY_FUNCTION__);
+                }
+            }
+        }
+    }
+    catch(...)
+    {
+        // stop the timers that were started by the load and restore their previous state
+        for(std::size_t i = 0; i < applied; ++i)
+        {
+            ITimer &timer = *timers[i];
+            WriteLock lock(timer);
+
+            try
+            {
+                if(records[i].running && timer.state.running) timer.stop_locked();
+            }
+            catch(const std::system_error &)
+            {
+                // the timer can not be stopped --> keep the loaded state
+                continue;
+            }
+
+            if(!timer.state.running) timer.state = previous[i];
+        }
+
+        throw;
+    }
+
+    return checkpoint_size(count);
 }
 
 timeval ITimer::get_timer_value() const
 {
-	if(running)
-	{
-        itimerval temp;
-        sysexcept(getitimer(type, &temp), "getitimer", errno);
-        return temp.it_value;
-	}
-	else
-		return timer_value;
+    return timespec_to_timeval(get_timer_value_timespec());
+}
+
+ITimer::State ITimer::load_state(timespec *now, itimerspec *curr_value) const
+{
+    State current;
+    for(;;)
+    {
+        const std::uint64_t armed = arm_sequence.load(std::memory_order_acquire);
+        if(curr_value && (armed & 1))
+        {
+            // underlying timer is modified by a writer
+            std::this_thread::yield();
+            continue;
+        }
+
+        const std::uint64_t sequence = snapshot.read_begin();
+        if(!snapshot.try_load(current)) continue;
+
+        if(current.running)
+        {
+            if(now) *now = reference_time();
+            if(curr_value)
+            {
+                gettime(*curr_value);
+                ITIMER_COUNT(syscalls);
+            }
+        }
+
+        if(snapshot.read_retry(sequence)) continue;
+        if(curr_value && arm_sequence.load(std::memory_order_relaxed) != armed) continue;
+        return current;
+    }
+}
+
+timespec ITimer::scaled_time_at(const State &state, const timespec &now) noexcept
+{
+    return timespec_add(state.scaled_time, timespec_mul(timespec_sub(now, state.scaled_since), state.speed_factor));
+}
+
+timespec ITimer::unscaled_value(const State &state, const timespec &value) noexcept
+{
+    const timespec ret_val = timespec_add(value * state.speed_factor, state.drift_pending);
+    return to_nsec(ret_val) < 0 ? timespec{0, 0} : ret_val;
+}
+
+timespec ITimer::get_scaled_time() const
+{
+    timespec now;
+    const State current = load_state(&now);
+    if(!current.running) return current.scaled_time;
+
+    return scaled_time_at(current, now);
+}
+
+timespec ITimer::get_timer_value_timespec() const
+{
+    if(!value_predictable()) return query_timer_value();
+
+    // calculate value from the time of the last arm (clock_gettime via vDSO)
+    timespec now;
+    const State current = load_state(&now);
+    if(!current.running) return current.timer_value;
+
+    return unscaled_value(current, predict_value(current, now));
+}
+
+timespec ITimer::query_timer_value() const
+{
+    itimerspec temp;
+    const State current = load_state(nullptr, &temp);
+    if(!current.running) return current.timer_value;
+
+    return unscaled_value(current, temp.it_value);
+}
+
+std::uint64_t ITimer::get_expirations() const
+{
+    timespec now;
+    const State current = load_state(&now);
+    if(!current.running) return current.expirations;
+
+    return current.expirations + predict_expirations(current, now);
+}
+
+#ifdef ITIMER_INSTRUMENTATION
+void ITimer::record_expiration() const noexcept
+{
+    // single attempt: the signal may interrupt a writer of the same thread
+    State current;
+    if(!snapshot.try_load(current))
+    {
+        counters.expirations.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if(!current.running) return;
+
+    timespec now;
+    if(!read_reference_clock(now)) return;
+
+    // index of the last scheduled expiration
+    const std::uint64_t index = current.expirations + predict_expirations(current, now);
+    const std::uint64_t last = counters.last_index.exchange(index, std::memory_order_relaxed);
+    if(index > last + 1) counters.overruns.fetch_add(index - last - 1, std::memory_order_relaxed);
+    counters.expirations.fetch_add(1, std::memory_order_relaxed);
+
+    // time since the last scheduled expiration
+    const int128_t elapsed = to_nsec(now) - to_nsec(current.scaled_since);
+    const int128_t value = to_nsec(current.armed_value.it_value);
+    if(elapsed < value) return;     // expired early or speed change in progress
+
+    const int128_t interval = to_nsec(current.armed_value.it_interval);
+    const int128_t lateness = interval > 0 ? (elapsed - value) % interval : elapsed - value;
+    counters.lateness.record(static_cast<std::uint64_t>(lateness));
+}
+
+TimerStatistics ITimer::get_statistics() const noexcept
+{
+    TimerStatistics statistics;
+    statistics.expirations = counters.expirations.load(std::memory_order_relaxed);
+    statistics.overruns = counters.overruns.load(std::memory_order_relaxed);
+    statistics.rearms = counters.rearms.load(std::memory_order_relaxed);
+    statistics.syscalls = counters.syscalls.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+void ITimer::reset_statistics() noexcept
+{
+    counters.reset();
 }
+#endif
 
 unsigned long ITimer::getSourceVersion() noexcept
 {
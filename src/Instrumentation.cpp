@@ -0,0 +1,96 @@
+/*
+ * \file Instrumentation.cpp
+ * \brief Source file de::Koesling::ITimer::LatencyHistogram and TimerCounters
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "Instrumentation.hpp"
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+constexpr unsigned LatencyHistogram::SUB_BUCKET_BITS;
+constexpr unsigned LatencyHistogram::SUB_BUCKETS;
+constexpr unsigned LatencyHistogram::BUCKETS;
+
+LatencyHistogram::LatencyHistogram() noexcept :
+        count(0),
+        sum(0),
+        max(0)
+{
+    for(auto &bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset() noexcept
+{
+    for(auto &bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+    count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::get_mean() const noexcept
+{
+    const std::uint64_t n = get_count();
+    if(n == 0) return 0.0;
+    return static_cast<double>(sum.load(std::memory_order_relaxed)) / static_cast<double>(n);
+}
+
+std::uint64_t LatencyHistogram::get_value_at_percentile(double percentile) const noexcept
+{
+    // sum of the buckets (count may differ due to concurrent record())
+    std::uint64_t total = 0;
+    for(const auto &bucket : buckets) total += bucket.load(std::memory_order_relaxed);
+    if(total == 0) return 0;
+
+    if(percentile < 0.0) percentile = 0.0;
+    if(percentile > 100.0) percentile = 100.0;
+
+    auto target = static_cast<std::uint64_t>(percentile / 100.0 * static_cast<double>(total) + 0.5);
+    if(target == 0) target = 1;
+
+    std::uint64_t accumulated = 0;
+    for(unsigned i = 0; i < BUCKETS; ++i)
+    {
+        accumulated += buckets[i].load(std::memory_order_relaxed);
+        if(accumulated >= target)
+        {
+            const std::uint64_t upper = bucket_upper_bound(i);
+            const std::uint64_t largest = get_max();
+            return upper < largest ? upper : largest;
+        }
+    }
+
+    return get_max();
+}
+
+TimerCounters::TimerCounters() noexcept :
+        expirations(0),
+        overruns(0),
+        rearms(0),
+        syscalls(0),
+        last_index(0)
+{
+}
+
+void TimerCounters::reset() noexcept
+{
+    expirations.store(0, std::memory_order_relaxed);
+    overruns.store(0, std::memory_order_relaxed);
+    rearms.store(0, std::memory_order_relaxed);
+    syscalls.store(0, std::memory_order_relaxed);
+    lateness.reset();
+}
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
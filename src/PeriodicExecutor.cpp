@@ -0,0 +1,470 @@
+/*
+ * \file PeriodicExecutor.cpp
+ * \brief Source file de::Koesling::ITimer::PeriodicExecutor
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *          -pthread
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "PeriodicExecutor.hpp"
+#include "sysexcept.hpp"
+#include "destructor_exception.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+//! job that is executed by the current worker thread (remove() from within the job)
+static thread_local const void *current_job = nullptr;
+
+PeriodicExecutor::PeriodicExecutor(const timespec &resolution, unsigned threads) :
+        tick_timer(resolution),
+        ticks(0),
+        next_id(0),
+        next_queue(0),
+        queued(0),
+        terminate(false),
+        event_fd(-1),
+        errors(0)
+{
+    if(to_nsec(resolution) <= 0)
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": resolution must not be zero!");
+
+    if(threads == 0) threads = std::thread::hardware_concurrency();
+    if(threads == 0) threads = 1;
+
+    event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    sysexcept(event_fd < 0, "eventfd", errno);
+
+    try
+    {
+        for(unsigned i = 0; i < threads; ++i)
+            queues.emplace_back(new WorkQueue);
+
+        for(unsigned i = 0; i < threads; ++i)
+            workers.emplace_back(&PeriodicExecutor::worker_thread, this, i);
+
+        scheduler = std::thread(&PeriodicExecutor::scheduler_thread, this);
+    }
+    catch(...)
+    {
+        shutdown();
+        close(event_fd);
+        throw;
+    }
+}
+
+PeriodicExecutor::~PeriodicExecutor()
+{
+    if(tick_timer.is_running())
+    {
+        try
+        {
+            tick_timer.stop();
+        }
+        catch (const std::system_error& e)
+        {
+            destructor_exception_terminate(e, std::cerr, EX_OSERR);
+        }
+    }
+
+    shutdown();
+    close(event_fd);
+}
+
+void PeriodicExecutor::shutdown() noexcept
+{
+    // wake scheduler
+    const std::uint64_t one = 1;
+    const ssize_t ignored = write(event_fd, &one, sizeof(one));
+    static_cast<void>(ignored);
+
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex);
+        terminate.store(true);
+    }
+    idle.notify_all();
+
+    if(scheduler.joinable()) scheduler.join();
+    for(auto &thread : workers) thread.join();
+}
+
+void PeriodicExecutor::record_error(std::exception_ptr exception) noexcept
+{
+    errors.fetch_add(1, std::memory_order_relaxed);
+
+    try
+    {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if(!error) error = exception;
+    }
+    catch(const std::system_error &)
+    {
+        // only counted
+    }
+}
+
+std::exception_ptr PeriodicExecutor::get_error() const
+{
+    std::lock_guard<std::mutex> lock(error_mutex);
+    return error;
+}
+
+std::uint64_t PeriodicExecutor::to_ticks(const timespec &time) const noexcept
+{
+    const auto resolution = static_cast<uint128_t>(to_nsec(tick_timer.get_interval_timespec()));
+    const auto nsec = to_nsec(time);
+    if(nsec <= 0) return 1;
+
+    const auto result = static_cast<std::uint64_t>((static_cast<uint128_t>(nsec) + resolution - 1) / resolution);
+    return result ? result : 1;
+}
+
+PeriodicExecutor::Job& PeriodicExecutor::job_of(JobId id)
+{
+    auto entry = jobs.find(id);
+    if(entry == jobs.end())
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": job not registered");
+
+    return entry->second;
+}
+
+const PeriodicExecutor::Job& PeriodicExecutor::job_of(JobId id) const
+{
+    auto entry = jobs.find(id);
+    if(entry == jobs.end())
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": job not registered");
+
+    return entry->second;
+}
+
+void PeriodicExecutor::schedule_job(Job &job, std::uint64_t due)
+{
+    job.due = due;
+    schedule.emplace(due, job.id);
+    job.scheduled = true;
+}
+
+PeriodicExecutor::JobId PeriodicExecutor::add(const timespec &period, const timespec &phase,
+        Callback callback, void *arg, Mode mode, Overrun overrun)
+{
+    if(to_nsec(period) <= 0)
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": period must not be zero!");
+    if(to_nsec(phase) < 0)
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": phase must not be negative!");
+
+    const std::uint64_t period_ticks = to_ticks(period);
+    const std::uint64_t phase_ticks = to_nsec(phase) > 0 ? to_ticks(phase) : 0;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const JobId id = next_id++;
+    Job &job = jobs[id];
+    job.id = id;
+    job.callback = callback;
+    job.arg = arg;
+    job.period = period_ticks;
+    job.mode = mode;
+    job.overrun = overrun;
+    job.due = 0;
+    job.scheduled = false;
+    job.running = false;
+    job.removed = false;
+    job.owed = 0;
+    job.statistics = {0, 0};
+
+    std::uint64_t due;
+    if(mode == Mode::FIXED_DELAY)
+    {
+        // phase after now (0: next tick)
+        due = ticks + phase_ticks;
+    }
+    else
+    {
+        // next tick of phase + n * period
+        due = phase_ticks;
+        if(due <= ticks) due += ((ticks - due) / period_ticks + 1) * period_ticks;
+    }
+
+    try
+    {
+        schedule_job(job, due);
+    }
+    catch(...)
+    {
+        jobs.erase(id);
+        throw;
+    }
+
+    return id;
+}
+
+void PeriodicExecutor::remove(JobId id)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    Job &job = job_of(id);
+    if(job.scheduled)
+    {
+        schedule.erase(std::make_pair(job.due, id));
+        job.scheduled = false;
+    }
+
+    if(!job.running)
+    {
+        jobs.erase(id);
+        return;
+    }
+
+    // queued: no worker has to run it (it may be busy with the job that calls remove())
+    if(unqueue(job))
+    {
+        jobs.erase(id);
+        return;
+    }
+
+    // removed by the worker (see run())
+    job.removed = true;
+    if(current_job == &job) return;
+
+    finished.wait(lock, [this, id] { return jobs.count(id) == 0; });
+}
+
+void PeriodicExecutor::dispatch(Job &job)
+{
+    job.running = true;
+
+    WorkQueue &queue = *queues[next_queue];
+    if(++next_queue == queues.size()) next_queue = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(&job);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex);
+        queued.fetch_add(1);
+    }
+    idle.notify_one();
+}
+
+bool PeriodicExecutor::unqueue(const Job &job)
+{
+    for(auto &queue : queues)
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        auto entry = std::find(queue->jobs.begin(), queue->jobs.end(), &job);
+        if(entry == queue->jobs.end()) continue;
+
+        queue->jobs.erase(entry);
+        queued.fetch_sub(1);
+        return true;
+    }
+
+    return false;
+}
+
+void PeriodicExecutor::process(std::uint64_t expirations)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    ticks += expirations;
+
+    while(!schedule.empty() && schedule.begin()->first <= ticks)
+    {
+        Job &job = jobs.find(schedule.begin()->second)->second;
+        schedule.erase(schedule.begin());
+        job.scheduled = false;
+
+        // periods that passed without a run (scheduler fell behind)
+        std::uint64_t missed = 0;
+        if(job.mode == Mode::FIXED_RATE)
+        {
+            missed = (ticks - job.due) / job.period;
+            schedule_job(job, job.due + (missed + 1) * job.period);
+        }
+
+        // previous run is not completed yet --> this run is missed as well
+        if(job.running) ++missed;
+
+        if(job.overrun == Overrun::SKIP) job.statistics.skipped += missed;
+        else job.owed += missed;
+
+        if(!job.running) dispatch(job);
+    }
+}
+
+PeriodicExecutor::Job* PeriodicExecutor::take(std::size_t index)
+{
+    Job *job = nullptr;
+
+    // own queue: oldest job first
+    {
+        WorkQueue &queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(!queue.jobs.empty())
+        {
+            job = queue.jobs.front();
+            queue.jobs.pop_front();
+        }
+    }
+
+    // steal from the other end of the queues of the other workers
+    for(std::size_t i = 1; !job && i < queues.size(); ++i)
+    {
+        WorkQueue &queue = *queues[(index + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(!queue.jobs.empty())
+        {
+            job = queue.jobs.back();
+            queue.jobs.pop_back();
+        }
+    }
+
+    if(job) queued.fetch_sub(1);
+    return job;
+}
+
+void PeriodicExecutor::run(Job &job)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while(!job.removed)
+    {
+        lock.unlock();
+        current_job = &job;
+        try
+        {
+            job.callback(job.arg);
+        }
+        catch(...)
+        {
+            // the run ends, the job stays scheduled
+            record_error(std::current_exception());
+        }
+        current_job = nullptr;
+        lock.lock();
+
+        ++job.statistics.runs;
+        if(job.removed) break;
+
+        if(job.owed == 0)
+        {
+            job.running = false;
+            if(job.mode == Mode::FIXED_DELAY) schedule_job(job, ticks + job.period);
+            return;
+        }
+
+        // CATCH_UP: next missed run
+        --job.owed;
+    }
+
+    // removed while queued or running
+    jobs.erase(job.id);
+    finished.notify_all();
+}
+
+void PeriodicExecutor::scheduler_thread()
+{
+    try
+    {
+        scheduler_loop();
+    }
+    catch(...)
+    {
+        // no more runs are dispatched
+        record_error(std::current_exception());
+    }
+}
+
+void PeriodicExecutor::scheduler_loop()
+{
+    pollfd fds[2];
+    fds[0].fd = tick_timer.get_fd();
+    fds[0].events = POLLIN;
+    fds[1].fd = event_fd;
+    fds[1].events = POLLIN;
+
+    for(;;)
+    {
+        if(poll(fds, 2, -1) < 0)
+        {
+            if(errno == EINTR) continue;
+            sysexcept(true, "poll", errno);
+        }
+
+        if(fds[1].revents) return;
+
+        if(fds[0].revents)
+        {
+            const std::uint64_t expirations = tick_timer.read_expirations();
+            if(expirations) process(expirations);
+        }
+    }
+}
+
+void PeriodicExecutor::worker_thread(std::size_t index)
+{
+    try
+    {
+        worker_loop(index);
+    }
+    catch(...)
+    {
+        // the queue of this worker is emptied by the other workers
+        record_error(std::current_exception());
+    }
+}
+
+void PeriodicExecutor::worker_loop(std::size_t index)
+{
+    while(!terminate.load())
+    {
+        Job *job = take(index);
+        if(job)
+        {
+            run(*job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(idle_mutex);
+        idle.wait(lock, [this] { return terminate.load() || queued.load() > 0; });
+    }
+}
+
+PeriodicExecutor::JobStatistics PeriodicExecutor::get_statistics(JobId id) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return job_of(id).statistics;
+}
+
+std::size_t PeriodicExecutor::size() const noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return jobs.size();
+}
+
+std::uint64_t PeriodicExecutor::get_ticks() const noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return ticks;
+}
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
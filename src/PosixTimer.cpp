@@ -0,0 +1,443 @@
+/*
+ * \file PosixTimer.cpp
+ * \brief Source file de::Koesling::ITimer::PosixTimer
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "PosixTimer.hpp"
+#include "sysexcept.hpp"
+#include "destructor_exception.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <pthread.h>
+#include <stdexcept>
+#include <string>
+#include <sys/syscall.h>
+#include <sysexits.h>
+#include <thread>
+#include <unistd.h>
+
+// not defined by glibc < 2.37
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+//! kernel thread id of the calling thread
+static pid_t current_thread_id() noexcept
+{
+    return static_cast<pid_t>(syscall(SYS_gettid));
+}
+
+//! cpu time clock of the calling thread (valid in all threads of the process)
+static clockid_t current_thread_clock()
+{
+    clockid_t clock;
+    int error = pthread_getcpuclockid(pthread_self(), &clock);
+    sysexcept(error != 0, "pthread_getcpuclockid", error);
+    return clock;
+}
+
+//! signal to the calling thread
+static sigevent current_thread_event(int signal_number)
+{
+    sigevent sev;
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = signal_number;
+    sev.sigev_notify_thread_id = current_thread_id();
+    return sev;
+}
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+constexpr std::size_t PosixTimer::MAX_HANDLED_TIMERS;
+
+//! sigval of a registered timer: generation | slot | tag
+static constexpr std::uintptr_t SIGVAL_TAG = 1;
+static constexpr unsigned SIGVAL_SLOT_BITS = 12;
+static constexpr std::uintptr_t SIGVAL_SLOT_MASK = (std::uintptr_t(1) << SIGVAL_SLOT_BITS) - 1;
+static constexpr std::uintptr_t SIGVAL_GENERATION_MASK = ~std::uintptr_t(0) >> (SIGVAL_SLOT_BITS + 1);
+static_assert(PosixTimer::MAX_HANDLED_TIMERS == SIGVAL_SLOT_MASK + 1, "slot bits do not match the registry size");
+
+//! registry of signal_handler(): timers that were created with the default sigval
+static struct HandlerSlot
+{
+    std::atomic<PosixTimer*> timer;             //!< registered timer (nullptr: free)
+    std::atomic<std::uintptr_t> generation;     //!< incremented at each release (stale signals)
+    std::atomic<unsigned> users;                //!< signal handlers that access the timer
+} handler_slots[PosixTimer::MAX_HANDLED_TIMERS];
+
+//! action that was replaced by PosixTimer::install_signal_handler()
+static struct sigaction previous_action[NSIG];
+
+//! pass a foreign signal to the previous action
+static void chain_signal(int sig, siginfo_t *info, void *context)
+{
+    const struct sigaction &previous = previous_action[sig];
+
+    if(previous.sa_flags & SA_SIGINFO)
+    {
+        if(previous.sa_sigaction) previous.sa_sigaction(sig, info, context);
+    }
+    else if(previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN)
+    {
+        previous.sa_handler(sig);
+    }
+}
+
+//! registry slot of an encoded sigval (nullptr: not generated by a registered timer)
+static HandlerSlot* sigval_slot(const sigval &value, std::uintptr_t &generation) noexcept
+{
+    const auto encoded = reinterpret_cast<std::uintptr_t>(value.sival_ptr);
+    if(!(encoded & SIGVAL_TAG)) return nullptr;
+
+    generation = encoded >> (SIGVAL_SLOT_BITS + 1);
+    return &handler_slots[(encoded >> 1) & SIGVAL_SLOT_MASK];
+}
+
+void PosixTimer::create(const sigevent *event)
+{
+    sigevent sev = *event;
+
+    // custom sigval: not handled by signal_handler()
+    if(sev.sigev_value.sival_ptr == nullptr && sev.sigev_notify != SIGEV_NONE)
+    {
+        for(std::size_t i = 0; i < MAX_HANDLED_TIMERS && handler_slot < 0; ++i)
+        {
+            PosixTimer *expected = nullptr;
+            if(handler_slots[i].timer.compare_exchange_strong(expected, this)) handler_slot = static_cast<int>(i);
+        }
+
+        sysexcept(handler_slot < 0, "PosixTimer: more than MAX_HANDLED_TIMERS timers", EAGAIN);
+
+        const std::uintptr_t generation = handler_slots[handler_slot].generation.load();
+        const std::uintptr_t encoded = (generation << (SIGVAL_SLOT_BITS + 1)) |
+                (static_cast<std::uintptr_t>(handler_slot) << 1) | SIGVAL_TAG;
+        sev.sigev_value.sival_ptr = reinterpret_cast<void*>(encoded);
+    }
+
+    if(timer_create(clock, &sev, &timer_id) < 0)
+    {
+        const int error = errno;
+        unregister_handler();
+        sysexcept(true, "timer_create", error);
+    }
+}
+
+void PosixTimer::unregister_handler() noexcept
+{
+    if(handler_slot < 0) return;
+
+    // pending signals of this timer are stale from now on
+    HandlerSlot &slot = handler_slots[handler_slot];
+    slot.generation.store((slot.generation.load() + 1) & SIGVAL_GENERATION_MASK);
+    slot.timer.store(nullptr);
+
+    // a signal handler may still access the timer
+    while(slot.users.load() != 0) std::this_thread::yield();
+
+    handler_slot = -1;
+}
+
+PosixTimer* PosixTimer::from_sigval(const sigval &value) noexcept
+{
+    std::uintptr_t generation;
+    HandlerSlot *slot = sigval_slot(value, generation);
+    if(!slot) return nullptr;
+
+    PosixTimer *timer = slot->timer.load();
+    return slot->generation.load() == generation ? timer : nullptr;
+}
+
+PosixTimer::PosixTimer(clockid_t clock, const timespec &interval,
+        const timespec &value, int signal_number) :
+        ITimer(-1, interval, value),
+        clock(clock),
+        timer_id(),
+        signal_number(signal_number),
+        signal_callback(nullptr),
+        signal_callback_arg(nullptr),
+        handler_slot(-1)
+{
+    sigevent sev;
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = signal_number;
+    sev.sigev_value.sival_ptr = nullptr;
+    create(&sev);
+}
+
+PosixTimer::PosixTimer(clockid_t clock, const timespec &interval,
+        const timespec &value, const sigevent &event) :
+        ITimer(-1, interval, value),
+        clock(clock),
+        timer_id(),
+        signal_number(event.sigev_notify == SIGEV_NONE ? 0 : event.sigev_signo),
+        signal_callback(nullptr),
+        signal_callback_arg(nullptr),
+        handler_slot(-1)
+{
+    create(&event);
+}
+
+PosixTimer::~PosixTimer( )
+{
+    // stop here, ITimer::~ITimer() can not call the overridden settime()
+    if(is_running())
+    {
+        try
+        {
+            stop();
+        }
+        catch (const std::system_error& e)
+        {
+            destructor_exception_terminate(e, std::cerr, EX_OSERR);
+        }
+    }
+
+    timer_delete(timer_id);
+
+    // signals that are still pending are passed to the previous action
+    unregister_handler();
+}
+
+void PosixTimer::settime(const itimerspec &new_value, itimerspec *old_value)
+{
+    sysexcept(timer_settime(timer_id, 0, &new_value, old_value) < 0, "timer_settime", errno);
+}
+
+void PosixTimer::gettime(itimerspec &curr_value) const
+{
+    sysexcept(timer_gettime(timer_id, &curr_value) < 0, "timer_gettime", errno);
+}
+
+TimerBackend PosixTimer::backend_kind() const noexcept
+{
+    return TimerBackend::posix_timer;
+}
+
+clockid_t PosixTimer::reference_clock() const noexcept
+{
+    return clock;
+}
+
+int PosixTimer::get_signal() const noexcept
+{
+    return signal_number;
+}
+
+int PosixTimer::get_overrun() const
+{
+    int overrun = timer_getoverrun(timer_id);
+    sysexcept(overrun < 0, "timer_getoverrun", errno);
+    return overrun;
+}
+
+void PosixTimer::set_signal_callback(SignalCallback callback, void *arg) noexcept
+{
+    signal_callback_arg.store(arg, std::memory_order_relaxed);
+    signal_callback.store(callback, std::memory_order_release);
+}
+
+void PosixTimer::signal_handler(int sig, siginfo_t *info, void *context)
+{
+    const int saved_errno = errno;
+
+    // the slot is pinned before the timer is read, the destructor waits for users
+    std::uintptr_t generation = 0;
+    HandlerSlot *slot = info->si_code == SI_TIMER ? sigval_slot(info->si_value, generation) : nullptr;
+    PosixTimer *timer = nullptr;
+    if(slot)
+    {
+        slot->users.fetch_add(1);
+        timer = slot->timer.load();
+        if(!timer || slot->generation.load() != generation)
+        {
+            slot->users.fetch_sub(1);
+            timer = nullptr;
+        }
+    }
+
+    if(!timer)
+    {
+        chain_signal(sig, info, context);
+        errno = saved_errno;
+        return;
+    }
+
+    timer->record_expiration();
+
+    const SignalCallback callback = timer->signal_callback.load(std::memory_order_acquire);
+    if(callback) callback(*timer, info->si_overrun, timer->signal_callback_arg.load(std::memory_order_relaxed));
+
+    slot->users.fetch_sub(1);
+    errno = saved_errno;
+}
+
+void PosixTimer::install_signal_handler(int signal_number, struct sigaction *old_action)
+{
+    if(signal_number <= 0 || signal_number >= NSIG)
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": invalid signal " +
+                std::to_string(signal_number));
+
+    // the previous action must be known before the handler can be called
+    struct sigaction previous;
+    sysexcept(sigaction(signal_number, nullptr, &previous) < 0, "sigaction", errno);
+    if(!(previous.sa_flags & SA_SIGINFO) || previous.sa_sigaction != signal_handler)
+        previous_action[signal_number] = previous;
+
+    struct sigaction action;
+    action.sa_sigaction = signal_handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sysexcept(sigaction(signal_number, &action, old_action) < 0, "sigaction", errno);
+}
+
+int realtime_signal(int n)
+{
+    if(n < 0 || n > SIGRTMAX - SIGRTMIN)
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": no realtime signal SIGRTMIN + " +
+                std::to_string(n));
+
+    return SIGRTMIN + n;
+}
+
+PosixTimer_Monotonic::PosixTimer_Monotonic(const timespec &interval, int signal_number) :
+        PosixTimer(CLOCK_MONOTONIC, interval, interval, signal_number)
+{
+}
+
+PosixTimer_Monotonic::PosixTimer_Monotonic(const timespec &interval,
+        const timespec &value, int signal_number) :
+        PosixTimer(CLOCK_MONOTONIC, interval, value, signal_number)
+{
+}
+
+PosixTimer_Monotonic::PosixTimer_Monotonic(const timeval &interval) :
+        PosixTimer(CLOCK_MONOTONIC, timeval_to_timespec(interval),
+                timeval_to_timespec(interval), SIGALRM)
+{
+}
+
+PosixTimer_Monotonic::PosixTimer_Monotonic(const timeval &interval,
+        const timeval &value) :
+        PosixTimer(CLOCK_MONOTONIC, timeval_to_timespec(interval),
+                timeval_to_timespec(value), SIGALRM)
+{
+}
+
+PosixTimer_Realtime::PosixTimer_Realtime(const timespec &interval, int signal_number) :
+        PosixTimer(CLOCK_REALTIME, interval, interval, signal_number)
+{
+}
+
+PosixTimer_Realtime::PosixTimer_Realtime(const timespec &interval,
+        const timespec &value, int signal_number) :
+        PosixTimer(CLOCK_REALTIME, interval, value, signal_number)
+{
+}
+
+PosixTimer_Realtime::PosixTimer_Realtime(const timeval &interval) :
+        PosixTimer(CLOCK_REALTIME, timeval_to_timespec(interval),
+                timeval_to_timespec(interval), SIGALRM)
+{
+}
+
+PosixTimer_Realtime::PosixTimer_Realtime(const timeval &interval,
+        const timeval &value) :
+        PosixTimer(CLOCK_REALTIME, timeval_to_timespec(interval),
+                timeval_to_timespec(value), SIGALRM)
+{
+}
+
+PosixTimer_Process::PosixTimer_Process(const timespec &interval, int signal_number) :
+        PosixTimer(CLOCK_PROCESS_CPUTIME_ID, interval, interval, signal_number)
+{
+}
+
+PosixTimer_Process::PosixTimer_Process(const timespec &interval,
+        const timespec &value, int signal_number) :
+        PosixTimer(CLOCK_PROCESS_CPUTIME_ID, interval, value, signal_number)
+{
+}
+
+PosixTimer_Process::PosixTimer_Process(const timeval &interval) :
+        PosixTimer(CLOCK_PROCESS_CPUTIME_ID, timeval_to_timespec(interval),
+                timeval_to_timespec(interval), SIGPROF)
+{
+}
+
+PosixTimer_Process::PosixTimer_Process(const timeval &interval,
+        const timeval &value) :
+        PosixTimer(CLOCK_PROCESS_CPUTIME_ID, timeval_to_timespec(interval),
+                timeval_to_timespec(value), SIGPROF)
+{
+}
+
+PosixTimer_Boottime::PosixTimer_Boottime(const timespec &interval, int signal_number) :
+        PosixTimer(CLOCK_BOOTTIME, interval, interval, signal_number)
+{
+}
+
+PosixTimer_Boottime::PosixTimer_Boottime(const timespec &interval,
+        const timespec &value, int signal_number) :
+        PosixTimer(CLOCK_BOOTTIME, interval, value, signal_number)
+{
+}
+
+PosixTimer_Boottime::PosixTimer_Boottime(const timeval &interval) :
+        PosixTimer(CLOCK_BOOTTIME, timeval_to_timespec(interval),
+                timeval_to_timespec(interval), SIGALRM)
+{
+}
+
+PosixTimer_Boottime::PosixTimer_Boottime(const timeval &interval,
+        const timeval &value) :
+        PosixTimer(CLOCK_BOOTTIME, timeval_to_timespec(interval),
+                timeval_to_timespec(value), SIGALRM)
+{
+}
+
+PosixTimer_Thread::PosixTimer_Thread(const timespec &interval, int signal_number) :
+        PosixTimer(current_thread_clock(), interval, interval, current_thread_event(signal_number)),
+        thread_id(current_thread_id())
+{
+}
+
+PosixTimer_Thread::PosixTimer_Thread(const timespec &interval,
+        const timespec &value, int signal_number) :
+        PosixTimer(current_thread_clock(), interval, value, current_thread_event(signal_number)),
+        thread_id(current_thread_id())
+{
+}
+
+PosixTimer_Thread::PosixTimer_Thread(const timeval &interval) :
+        PosixTimer(current_thread_clock(), timeval_to_timespec(interval),
+                timeval_to_timespec(interval), current_thread_event(SIGPROF)),
+        thread_id(current_thread_id())
+{
+}
+
+PosixTimer_Thread::PosixTimer_Thread(const timeval &interval,
+        const timeval &value) :
+        PosixTimer(current_thread_clock(), timeval_to_timespec(interval),
+                timeval_to_timespec(value), current_thread_event(SIGPROF)),
+        thread_id(current_thread_id())
+{
+}
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
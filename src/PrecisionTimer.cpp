@@ -0,0 +1,209 @@
+/*
+ * \file PrecisionTimer.cpp
+ * \brief Source file de::Koesling::ITimer::PrecisionTimer
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "PrecisionTimer.hpp"
+#include "sysexcept.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+
+//! initial wakeup latency estimation (before the first measurement)
+static constexpr std::int64_t INITIAL_LATENCY = 50000;
+
+//! current time of CLOCK_MONOTONIC in nanoseconds (vDSO)
+static std::int64_t monotonic_now()
+{
+    timespec now;
+    sysexcept(clock_gettime(CLOCK_MONOTONIC, &now) < 0, "clock_gettime", errno);
+    return static_cast<std::int64_t>(de::Koesling::ITimer::to_nsec(now));
+}
+
+//! hint for the cpu that this is a busy loop
+static inline void cpu_relax() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+PrecisionTimer::PrecisionTimer(const timespec &value, const timespec &burn_cap) noexcept :
+        ITimer(-1, value),
+        deadline(0),
+        armed_interval(0),
+        burn_cap(0),
+        latency_mean(INITIAL_LATENCY),
+        latency_deviation(0),
+        waits(0),
+        missed(0),
+        spin_time(0),
+        max_lateness(0)
+{
+    set_burn_cap(burn_cap);
+}
+
+PrecisionTimer::PrecisionTimer(const timeval &value, const timespec &burn_cap) noexcept :
+        PrecisionTimer(timeval_to_timespec(value), burn_cap)
+{
+}
+
+PrecisionTimer::~PrecisionTimer( )
+{
+    // stop here, ITimer::~ITimer() can not call the overridden settime()
+    if(is_running()) stop();
+}
+
+itimerspec PrecisionTimer::remaining() const noexcept
+{
+    itimerspec ret_val;
+    ret_val.it_interval = nsec_to_timespec(armed_interval.load());
+    ret_val.it_value = {0, 0};
+
+    const std::int64_t armed = deadline.load();
+    if(!armed) return ret_val;
+
+    timespec now;
+    if(clock_gettime(CLOCK_MONOTONIC, &now) < 0) return ret_val;
+
+    const auto value = armed - to_nsec(now);
+    if(value > 0) ret_val.it_value = nsec_to_timespec(value);
+    return ret_val;
+}
+
+void PrecisionTimer::settime(const itimerspec &new_value, itimerspec *old_value)
+{
+    if(old_value) *old_value = remaining();
+
+    const auto interval = to_nsec(new_value.it_interval);
+    auto value = to_nsec(new_value.it_value);
+
+    // expired one shot --> restart with the interval
+    if(value <= 0) value = interval;
+
+    armed_interval.store(static_cast<std::int64_t>(interval));
+    deadline.store(value > 0 ? monotonic_now() + static_cast<std::int64_t>(value) : 0);
+}
+
+void PrecisionTimer::gettime(itimerspec &curr_value) const
+{
+    curr_value = remaining();
+}
+
+TimerBackend PrecisionTimer::backend_kind() const noexcept
+{
+    return TimerBackend::precision;
+}
+
+bool PrecisionTimer::value_predictable() const noexcept
+{
+    return false;
+}
+
+void PrecisionTimer::calibrate(std::int64_t latency) noexcept
+{
+    // exponentially weighted mean and mean deviation (like the TCP rtt estimation)
+    const std::int64_t mean = latency_mean.load(std::memory_order_relaxed);
+    const std::int64_t deviation = latency_deviation.load(std::memory_order_relaxed);
+    const std::int64_t error = latency - mean;
+
+    latency_mean.store(mean + error / 8, std::memory_order_relaxed);
+    latency_deviation.store(deviation + ((error < 0 ? -error : error) - deviation) / 4, std::memory_order_relaxed);
+}
+
+timespec PrecisionTimer::get_margin() const noexcept
+{
+    const std::int64_t margin = latency_mean.load(std::memory_order_relaxed) +
+            4 * latency_deviation.load(std::memory_order_relaxed);
+    return nsec_to_timespec(std::max<std::int64_t>(0, std::min(margin, burn_cap.load(std::memory_order_relaxed))));
+}
+
+bool PrecisionTimer::wait()
+{
+    std::int64_t armed = deadline.load();
+    if(!armed || !is_running()) return false;
+
+    // sleep until deadline - margin (repeated if the deadline was moved)
+    for(;;)
+    {
+        const std::int64_t margin = static_cast<std::int64_t>(to_nsec(get_margin()));
+        const std::int64_t wakeup = armed - margin;
+        if(monotonic_now() >= wakeup) break;
+
+        const timespec target = nsec_to_timespec(wakeup);
+        const int error = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &target, nullptr);
+        sysexcept(error != 0 && error != EINTR, "clock_nanosleep", error);
+
+        if(error == 0) calibrate(monotonic_now() - wakeup);
+
+        armed = deadline.load();
+        if(!armed) return false;
+    }
+
+    // busy loop until the deadline
+    const std::int64_t spin_start = monotonic_now();
+    std::int64_t now = spin_start;
+    if(now > armed) missed.fetch_add(1, std::memory_order_relaxed);
+
+    while(now < armed)
+    {
+        cpu_relax();
+        now = monotonic_now();
+
+        // speed change or stop() by another thread
+        const std::int64_t current = deadline.load(std::memory_order_relaxed);
+        if(current != armed)
+        {
+            if(!current) return false;
+            if(current - now > to_nsec(get_margin())) return wait();
+            armed = current;
+        }
+    }
+
+    spin_time.fetch_add(now - spin_start, std::memory_order_relaxed);
+    waits.fetch_add(1, std::memory_order_relaxed);
+    if(now - armed > max_lateness.load(std::memory_order_relaxed))
+        max_lateness.store(now - armed, std::memory_order_relaxed);
+
+    record_expiration();
+
+    try
+    {
+        stop();
+    }
+    catch(const std::runtime_error &)
+    {
+        // stopped by another thread
+    }
+
+    return true;
+}
+
+PrecisionTimer::Statistics PrecisionTimer::get_statistics() const noexcept
+{
+    Statistics ret_val;
+    ret_val.waits = waits.load(std::memory_order_relaxed);
+    ret_val.missed = missed.load(std::memory_order_relaxed);
+    ret_val.spin_time = nsec_to_timespec(spin_time.load(std::memory_order_relaxed));
+    ret_val.max_lateness = nsec_to_timespec(max_lateness.load(std::memory_order_relaxed));
+    return ret_val;
+}
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -0,0 +1,326 @@
+/*
+ * \file Profiler.cpp
+ * \brief Source file de::Koesling::ITimer::Profiler
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *          -pthread
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "Profiler.hpp"
+#include "sysexcept.hpp"
+#include "destructor_exception.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sysexits.h>
+
+//! frames of the signal handler and the signal trampoline
+static constexpr std::size_t SKIP_FRAMES = 2;
+
+//! get name of the function that contains address
+static std::string symbol_name(void *address)
+{
+    Dl_info info;
+    if(!dladdr(address, &info)) info.dli_fname = nullptr;
+
+    if(info.dli_fname && info.dli_sname)
+    {
+        int status;
+        char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        if(status == 0 && demangled)
+        {
+            std::string ret_val(demangled);
+            std::free(demangled);
+            return ret_val;
+        }
+        return info.dli_sname;
+    }
+
+    // unknown function --> module (e.g. static functions of shared libraries)
+    std::ostringstream stream;
+    if(info.dli_fname)
+    {
+        const char *module = std::strrchr(info.dli_fname, '/');
+        stream << '[' << (module ? module + 1 : info.dli_fname) << ']';
+    }
+    else
+    {
+        stream << address;
+    }
+    return stream.str();
+}
+
+//! write native word (legacy CPU profile format)
+static void write_word(std::ostream &stream, std::uintptr_t word)
+{
+    stream.write(reinterpret_cast<const char*>(&word), sizeof(word));
+}
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+constexpr std::size_t Profiler::MAX_FRAMES;
+
+std::atomic<Profiler*> Profiler::instance(nullptr);
+
+std::atomic<std::uint64_t> Profiler::next_id(1);
+
+thread_local std::uint64_t Profiler::thread_owner = 0;
+
+thread_local Profiler::ThreadBuffer *Profiler::thread_buffer = nullptr;
+
+void Profiler::signal_handler(int sig, siginfo_t *info, void *context)
+{
+    static_cast<void>(sig);
+    static_cast<void>(info);
+    static_cast<void>(context);
+
+    Profiler *profiler = instance.load(std::memory_order_acquire);
+    if(!profiler) return;
+
+    if(thread_owner != profiler->id)
+    {
+        profiler->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const int saved_errno = errno;
+
+    void *frames[MAX_FRAMES + SKIP_FRAMES];
+    const int depth = backtrace(frames, static_cast<int>(MAX_FRAMES + SKIP_FRAMES));
+
+    Sample sample;
+    sample.depth = 0;
+    for(auto i = SKIP_FRAMES; i < static_cast<std::size_t>(depth); ++i)
+        sample.frames[sample.depth++] = frames[i];
+
+    if(!thread_buffer->push(sample))
+        profiler->dropped.fetch_add(1, std::memory_order_relaxed);
+
+    errno = saved_errno;
+}
+
+Profiler::Profiler(const timeval &interval, std::size_t buffer_size, const timeval &drain_period) :
+        timer(interval),
+        speed_factor(1.0),
+        id(next_id.fetch_add(1)),
+        buffer_size(buffer_size),
+        drain_period(drain_period),
+        samples(0),
+        dropped(0),
+        terminate(false)
+{
+    if(to_usec(interval) <= 0 || buffer_size == 0 || to_usec(drain_period) <= 0)
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) +
+                ": interval, buffer_size and drain_period must not be zero!");
+
+    // the first call of backtrace() loads libgcc (not async signal safe)
+    void *frame;
+    backtrace(&frame, 1);
+
+    register_thread();
+
+    // install signal handler
+    struct sigaction action;
+    action.sa_sigaction = signal_handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+
+    instance.store(this);
+    if(sigaction(SIGPROF, &action, &old_action) < 0)
+    {
+        int error = errno;
+        instance.store(nullptr);
+        sysexcept(true, "sigaction", error);
+    }
+
+    try
+    {
+        drain_thread = std::thread(&Profiler::drain_loop, this);
+    }
+    catch(...)
+    {
+        sigaction(SIGPROF, &old_action, nullptr);
+        instance.store(nullptr);
+        throw;
+    }
+}
+
+Profiler::~Profiler()
+{
+    // timer must be stopped before the signal handler is restored
+    if(timer.is_running())
+    {
+        try
+        {
+            timer.stop();
+        }
+        catch (const std::system_error& e)
+        {
+            destructor_exception_terminate(e, std::cerr, EX_OSERR);
+        }
+    }
+
+    sigaction(SIGPROF, &old_action, nullptr);
+    instance.store(nullptr);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        terminate = true;
+    }
+    condition.notify_all();
+    drain_thread.join();
+}
+
+void Profiler::register_thread()
+{
+    if(thread_owner == id) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    buffers.emplace_back(new ThreadBuffer(buffer_size));
+    thread_buffer = buffers.back().get();
+    thread_owner = id;
+}
+
+void Profiler::start()
+{
+    timer.start();
+}
+
+void Profiler::stop()
+{
+    timer.stop();
+}
+
+void Profiler::set_speed_factor(double speed_factor)
+{
+    timer.set_speed_factor(speed_factor);
+    this->speed_factor.store(speed_factor, std::memory_order_relaxed);
+}
+
+void Profiler::set_speed_to_normal()
+{
+    timer.set_speed_to_normal();
+    speed_factor.store(1.0, std::memory_order_relaxed);
+}
+
+void Profiler::drain_loop()
+{
+    const auto period = timeval_to_duration<std::chrono::microseconds>(drain_period);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while(!terminate)
+    {
+        condition.wait_for(lock, period);
+        drain();
+    }
+}
+
+void Profiler::drain()
+{
+    Sample sample;
+    for(auto &buffer : buffers)
+    {
+        while(buffer->pop(sample))
+        {
+            ++profile[std::vector<void*>(sample.frames, sample.frames + sample.depth)];
+            ++samples;
+        }
+    }
+}
+
+void Profiler::reset()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    drain();
+    profile.clear();
+    samples = 0;
+}
+
+std::uint64_t Profiler::get_samples()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    drain();
+    return samples;
+}
+
+void Profiler::write_folded(std::ostream &stream)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    drain();
+
+    // different addresses of the same function --> same folded stack
+    std::map<void*, std::string> names;
+    std::map<std::string, std::uint64_t> folded;
+    for(const auto &entry : profile)
+    {
+        const auto &stack = entry.first;
+        std::string line;
+        for(std::size_t i = stack.size(); i-- > 0;)
+        {
+            // return addresses point behind the call instruction
+            void *address = i == 0 ? stack[i] : static_cast<char*>(stack[i]) - 1;
+
+            auto name = names.find(address);
+            if(name == names.end()) name = names.emplace(address, symbol_name(address)).first;
+
+            line += name->second;
+            if(i != 0) line += ';';
+        }
+        folded[line] += entry.second;
+    }
+
+    for(const auto &entry : folded)
+        stream << entry.first << ' ' << entry.second << '\n';
+}
+
+void Profiler::write_pprof(std::ostream &stream)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    drain();
+
+    const auto period = static_cast<std::uintptr_t>(static_cast<double>(to_usec(timer.get_interval())) /
+            speed_factor.load(std::memory_order_relaxed));
+
+    // header: header words, header size, version, sampling period, padding
+    write_word(stream, 0);
+    write_word(stream, 3);
+    write_word(stream, 0);
+    write_word(stream, period ? period : 1);
+    write_word(stream, 0);
+
+    // records: count, depth, stack (leaf first)
+    for(const auto &entry : profile)
+    {
+        write_word(stream, static_cast<std::uintptr_t>(entry.second));
+        write_word(stream, entry.first.size());
+        for(void *address : entry.first) write_word(stream, reinterpret_cast<std::uintptr_t>(address));
+    }
+
+    // trailer
+    write_word(stream, 0);
+    write_word(stream, 1);
+    write_word(stream, 0);
+
+    // memory map (symbolization)
+    std::ifstream maps("/proc/self/maps");
+    stream << maps.rdbuf();
+}
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
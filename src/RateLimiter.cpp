@@ -0,0 +1,99 @@
+/*
+ * \file RateLimiter.cpp
+ * \brief Source file de::Koesling::ITimer::RateLimiter, TokenBucket, LeakyBucket
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "RateLimiter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <sched.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+RateLimiter::RateLimiter(const ITimer &timer, double rate, double budget, unsigned shards) :
+        timer(timer),
+        shard_count(shards ? shards : std::max(1u, std::thread::hardware_concurrency())),
+        rate(rate),
+        emission_interval(0.0),
+        tolerance(0)
+{
+    if(!(rate > 0.0) || std::isinf(rate))
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": invalid rate");
+
+    if(!(budget >= static_cast<double>(shard_count)) || budget * 1e9 / rate > 9e18)
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) +
+                ": budget must be at least one token per shard");
+
+    // rate and budget are split evenly --> the tolerance in time is the same for each shard
+    emission_interval = static_cast<double>(shard_count) * 1e9 / rate;
+    tolerance = static_cast<std::int64_t>(budget * 1e9 / rate);
+
+    this->shards.reset(new Shard[shard_count]);
+    for(unsigned i = 0; i < shard_count; ++i) this->shards[i].tat.store(0, std::memory_order_relaxed);
+}
+
+bool RateLimiter::reserve_shard(Shard &shard, std::uint32_t tokens, std::int64_t now,
+        std::int64_t &start) noexcept
+{
+    const std::int64_t increment = std::llround(static_cast<double>(tokens) * emission_interval);
+
+    std::int64_t tat = shard.tat.load(std::memory_order_relaxed);
+    for(;;)
+    {
+        const std::int64_t base = tat > now ? tat : now;
+        const std::int64_t new_tat = base + increment;
+        if(new_tat - now > tolerance) return false;
+
+        if(shard.tat.compare_exchange_weak(tat, new_tat, std::memory_order_relaxed))
+        {
+            start = base;
+            return true;
+        }
+    }
+}
+
+bool RateLimiter::reserve(std::uint32_t tokens, std::int64_t now, std::int64_t &start) noexcept
+{
+    // shard of the current cpu first, then the others (keeps the total rate)
+    unsigned first = 0;
+    if(shard_count > 1)
+    {
+        const int cpu = sched_getcpu();
+        first = cpu > 0 ? static_cast<unsigned>(cpu) % shard_count : 0;
+    }
+
+    for(unsigned i = 0; i < shard_count; ++i)
+    {
+        if(reserve_shard(shards[(first + i) % shard_count], tokens, now, start)) return true;
+    }
+
+    return false;
+}
+
+TokenBucket::TokenBucket(const ITimer &timer, double rate, double burst, unsigned shards) :
+        RateLimiter(timer, rate, burst, shards)
+{
+}
+
+LeakyBucket::LeakyBucket(const ITimer &timer, double rate, double capacity, unsigned shards) :
+        RateLimiter(timer, rate, capacity, shards)
+{
+}
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -0,0 +1,267 @@
+/*
+ * \file SignalDispatcher.cpp
+ * \brief Source file de::Koesling::ITimer::SignalDispatcher
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *          -pthread
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "SignalDispatcher.hpp"
+#include "PosixTimer.hpp"
+#include "sysexcept.hpp"
+#include <cerrno>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+std::atomic<SignalDispatcher*> SignalDispatcher::instance(nullptr);
+std::atomic<unsigned> SignalDispatcher::handlers(0);
+
+//! timer whose callback is running in the calling worker thread
+static thread_local const ITimer *current_timer = nullptr;
+
+void SignalDispatcher::signal_handler(int sig, siginfo_t *info, void *context)
+{
+    static_cast<void>(context);
+
+    // the destructor waits for running handlers before the semaphore is destroyed
+    handlers.fetch_add(1);
+    SignalDispatcher *dispatcher = instance.load();
+    if(!dispatcher)
+    {
+        handlers.fetch_sub(1);
+        return;
+    }
+
+    const int saved_errno = errno;
+
+    // the timer is only a lookup key: it may be destroyed concurrently
+    Expiration expiration;
+    expiration.signal = sig;
+    if(info->si_code == SI_TIMER)
+    {
+        expiration.timer = PosixTimer::from_sigval(info->si_value);
+        expiration.overrun = info->si_overrun;
+    }
+    else
+    {
+        expiration.timer = dispatcher->signal_timer[sig].load(std::memory_order_relaxed);
+        expiration.overrun = 0;
+    }
+    expiration.generation = dispatcher->generation.load();
+    clock_gettime(CLOCK_MONOTONIC, &expiration.time);
+
+    if(expiration.timer && dispatcher->queue.push(expiration))
+        sem_post(&dispatcher->semaphore);
+    else
+        dispatcher->dropped.fetch_add(1, std::memory_order_relaxed);
+
+    handlers.fetch_sub(1);
+    errno = saved_errno;
+}
+
+SignalDispatcher::SignalDispatcher(std::size_t queue_capacity, unsigned threads) :
+        queue(queue_capacity),
+        dropped(0),
+        semaphore(),
+        terminate(false),
+        generation(0),
+        errors(0)
+{
+    if(threads == 0)
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": at least one thread required!");
+
+    for(int sig = 0; sig < NSIG; ++sig)
+    {
+        signal_timer[sig].store(nullptr, std::memory_order_relaxed);
+        signal_users[sig] = 0;
+    }
+
+    SignalDispatcher *expected = nullptr;
+    if(!instance.compare_exchange_strong(expected, this))
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) +
+                ": only one signal dispatcher per process possible");
+
+    if(sem_init(&semaphore, 0, 0) < 0)
+    {
+        int error = errno;
+        instance.store(nullptr);
+        sysexcept(true, "sem_init", error);
+    }
+
+    try
+    {
+        for(unsigned i = 0; i < threads; ++i)
+            workers.emplace_back(&SignalDispatcher::worker, this);
+    }
+    catch(...)
+    {
+        terminate.store(true);
+        for(std::size_t i = 0; i < workers.size(); ++i) sem_post(&semaphore);
+        for(auto &thread : workers) thread.join();
+        sem_destroy(&semaphore);
+        instance.store(nullptr);
+        throw;
+    }
+}
+
+SignalDispatcher::~SignalDispatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(int sig = 0; sig < NSIG; ++sig)
+            if(signal_users[sig]) sigaction(sig, &old_action[sig], nullptr);
+    }
+
+    instance.store(nullptr);
+
+    // a handler that passed the instance check may still post the semaphore
+    while(handlers.load() != 0) std::this_thread::yield();
+
+    terminate.store(true);
+    for(std::size_t i = 0; i < workers.size(); ++i) sem_post(&semaphore);
+    for(auto &thread : workers) thread.join();
+
+    sem_destroy(&semaphore);
+}
+
+void SignalDispatcher::record_error(std::exception_ptr exception) noexcept
+{
+    errors.fetch_add(1, std::memory_order_relaxed);
+
+    try
+    {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if(!error) error = exception;
+    }
+    catch(const std::system_error &)
+    {
+        // only counted
+    }
+}
+
+std::exception_ptr SignalDispatcher::get_error() const
+{
+    std::lock_guard<std::mutex> lock(error_mutex);
+    return error;
+}
+
+void SignalDispatcher::add(const ITimer &timer, Callback callback, void *arg)
+{
+    const int sig = timer.get_signal();
+    if(sig <= 0 || sig >= NSIG)
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": timer does not generate a signal");
+
+    // POSIX timers are identified by their sigval, all others by their signal
+    const bool by_signal = dynamic_cast<const PosixTimer*>(&timer) == nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if(registrations.count(&timer))
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": timer already registered");
+
+    if(by_signal && signal_timer[sig].load())
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": another timer uses this signal");
+
+    if(signal_users[sig] == 0)
+    {
+        struct sigaction action;
+        action.sa_sigaction = signal_handler;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_SIGINFO | SA_RESTART;
+        sysexcept(sigaction(sig, &action, &old_action[sig]) < 0, "sigaction", errno);
+    }
+
+    registrations[&timer] = {callback, arg, generation.fetch_add(1) + 1, 0, false};
+    if(by_signal) signal_timer[sig].store(&timer);
+    ++signal_users[sig];
+}
+
+void SignalDispatcher::remove(const ITimer &timer)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    auto entry = registrations.find(&timer);
+    if(entry == registrations.end() || entry->second.removed)
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": timer not registered");
+
+    // no new callbacks
+    Registration &registration = entry->second;
+    registration.removed = true;
+
+    const int sig = timer.get_signal();
+    if(signal_timer[sig].load() == &timer) signal_timer[sig].store(nullptr);
+
+    if(--signal_users[sig] == 0)
+        sigaction(sig, &old_action[sig], nullptr);
+
+    // wait for running callbacks (a callback may remove its own timer)
+    const unsigned own = current_timer == &timer ? 1 : 0;
+    idle.wait(lock, [&registration, own] { return registration.active <= own; });
+
+    registrations.erase(entry);
+}
+
+void SignalDispatcher::worker()
+{
+    for(;;)
+    {
+        while(sem_wait(&semaphore) < 0 && errno == EINTR);
+
+        if(terminate.load()) return;
+
+        // an element was pushed before sem_post, but a concurrent push to an
+        // earlier position may not be published yet --> retry
+        Expiration expiration;
+        while(!queue.pop(expiration)) std::this_thread::yield();
+
+        Registration registration;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto entry = registrations.find(expiration.timer);
+            if(entry == registrations.end()) continue;
+
+            // removed or registered after the signal (another timer at the same address)
+            registration = entry->second;
+            if(registration.removed || registration.generation > expiration.generation) continue;
+
+            // remove() waits for the callback
+            ++entry->second.active;
+        }
+
+        expiration.timer->record_expiration();
+
+        const ITimer *const previous = current_timer;
+        current_timer = expiration.timer;
+        try
+        {
+            registration.callback(expiration, registration.arg);
+        }
+        catch(...)
+        {
+            // the worker continues
+            record_error(std::current_exception());
+        }
+        current_timer = previous;
+
+        // the callback may have removed (and registered again) its own timer
+        std::lock_guard<std::mutex> lock(mutex);
+        auto entry = registrations.find(expiration.timer);
+        if(entry == registrations.end() || entry->second.generation != registration.generation) continue;
+
+        --entry->second.active;
+        if(entry->second.removed) idle.notify_all();
+    }
+}
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -0,0 +1,208 @@
+/*
+ * \file SimulatedClock.cpp
+ * \brief Source file de::Koesling::ITimer::SimulatedClock and SimulatedTimer
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "SimulatedClock.hpp"
+#include <stdexcept>
+#include <string>
+
+//! latest representable time (limit for step() and run())
+static constexpr timespec END_OF_TIME = {std::numeric_limits<time_t>::max(), 999999999};
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+bool SimulatedClock::Event::operator<(const Event &other) const noexcept
+{
+    const int order = timespec_compare(expires, other.expires);
+    if(order != 0) return order < 0;
+    return sequence < other.sequence;
+}
+
+SimulatedClock::SimulatedClock(const timespec &start) noexcept :
+        now(start),
+        next_sequence(0),
+        expirations(0)
+{
+}
+
+void SimulatedClock::schedule(SimulatedTimer &timer, const timespec &expires)
+{
+    timer.event.expires = expires;
+    timer.event.sequence = next_sequence++;
+    timer.event.timer = &timer;
+    events.insert(timer.event);
+    timer.armed = true;
+}
+
+void SimulatedClock::cancel(SimulatedTimer &timer) noexcept
+{
+    if(!timer.armed) return;
+
+    events.erase(timer.event);
+    timer.armed = false;
+}
+
+bool SimulatedClock::process_next(const timespec &limit)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if(events.empty() || timespec_compare(events.begin()->expires, limit) > 0) return false;
+
+    SimulatedTimer &timer = *events.begin()->timer;
+    events.erase(events.begin());
+    timer.armed = false;
+    now = timer.event.expires;
+    ++expirations;
+
+    // periodic timer --> reload before the callback (may stop the timer)
+    if(!timespec_is_zero(timer.armed_interval)) schedule(timer, timespec_add(now, timer.armed_interval));
+
+    lock.unlock();
+
+    timer.record_expiration();
+    if(timer.callback) timer.callback(timer, timer.arg);
+    return true;
+}
+
+timespec SimulatedClock::get_time() const noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return now;
+}
+
+std::size_t SimulatedClock::advance(const timespec &duration)
+{
+    if(to_nsec(duration) < 0)
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": negative duration");
+
+    return advance_to(timespec_add(get_time(), duration));
+}
+
+std::size_t SimulatedClock::advance_to(const timespec &time)
+{
+    if(timespec_compare(time, get_time()) < 0)
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": time is in the past");
+
+    std::size_t count = 0;
+    while(process_next(time)) ++count;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    now = time;
+    return count;
+}
+
+bool SimulatedClock::step()
+{
+    return process_next(END_OF_TIME);
+}
+
+std::size_t SimulatedClock::run(std::size_t max_expirations)
+{
+    std::size_t count = 0;
+    while(count < max_expirations && process_next(END_OF_TIME)) ++count;
+    return count;
+}
+
+std::size_t SimulatedClock::size() const noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return events.size();
+}
+
+bool SimulatedClock::get_next_expiration(timespec &time) const noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if(events.empty()) return false;
+
+    time = events.begin()->expires;
+    return true;
+}
+
+std::uint64_t SimulatedClock::get_expirations() const noexcept
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return expirations;
+}
+
+SimulatedTimer::SimulatedTimer(SimulatedClock &clock, const timespec &interval,
+        Callback callback, void *arg) noexcept :
+        SimulatedTimer(clock, interval, interval, callback, arg)
+{
+}
+
+SimulatedTimer::SimulatedTimer(SimulatedClock &clock, const timespec &interval,
+        const timespec &value, Callback callback, void *arg) noexcept :
+        ITimer(-1, interval, value),
+        clock(clock),
+        event({{0, 0}, 0, this}),
+        armed(false),
+        armed_interval({0, 0}),
+        callback(callback),
+        arg(arg)
+{
+}
+
+SimulatedTimer::~SimulatedTimer( )
+{
+    // stop here, ITimer::~ITimer() can not call the overridden settime()
+    if(is_running()) stop();
+}
+
+itimerspec SimulatedTimer::remaining() const noexcept
+{
+    itimerspec ret_val;
+    ret_val.it_interval = armed_interval;
+    ret_val.it_value = armed ? timespec_sub(event.expires, clock.now) : timespec{0, 0};
+    return ret_val;
+}
+
+void SimulatedTimer::settime(const itimerspec &new_value, itimerspec *old_value)
+{
+    std::lock_guard<std::mutex> lock(clock.mutex);
+
+    if(old_value) *old_value = remaining();
+
+    clock.cancel(*this);
+    armed_interval = new_value.it_interval;
+
+    if(to_nsec(new_value.it_value) <= 0) return;
+    clock.schedule(*this, timespec_add(clock.now, new_value.it_value));
+}
+
+void SimulatedTimer::gettime(itimerspec &curr_value) const
+{
+    std::lock_guard<std::mutex> lock(clock.mutex);
+    curr_value = remaining();
+}
+
+TimerBackend SimulatedTimer::backend_kind() const noexcept
+{
+    return TimerBackend::simulated;
+}
+
+bool SimulatedTimer::read_reference_clock(timespec &now) const noexcept
+{
+    now = clock.get_time();
+    return true;
+}
+
+bool SimulatedTimer::value_predictable() const noexcept
+{
+    return true;
+}
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -0,0 +1,125 @@
+/*
+ * \file TimerFd.cpp
+ * \brief Source file de::Koesling::ITimer::TimerFd
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "TimerFd.hpp"
+#include "sysexcept.hpp"
+#include "destructor_exception.hpp"
+#include <cerrno>
+#include <iostream>
+#include <sys/timerfd.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+void TimerFd::create()
+{
+    fd = timerfd_create(clock, TFD_NONBLOCK | TFD_CLOEXEC);
+    sysexcept(fd < 0, "timerfd_create", errno);
+}
+
+TimerFd::TimerFd(const timespec &interval, clockid_t clock) :
+        ITimer(-1, interval),
+        clock(clock),
+        fd(-1)
+{
+    create();
+}
+
+TimerFd::TimerFd(const timespec &interval, const timespec &value,
+        clockid_t clock) :
+        ITimer(-1, interval, value),
+        clock(clock),
+        fd(-1)
+{
+    create();
+}
+
+TimerFd::TimerFd(const timeval &interval, clockid_t clock) :
+        ITimer(-1, interval),
+        clock(clock),
+        fd(-1)
+{
+    create();
+}
+
+TimerFd::TimerFd(const timeval &interval, const timeval &value,
+        clockid_t clock) :
+        ITimer(-1, interval, value),
+        clock(clock),
+        fd(-1)
+{
+    create();
+}
+
+TimerFd::~TimerFd( )
+{
+    // stop here, ITimer::~ITimer() can not call the overridden settime()
+    if(is_running())
+    {
+        try
+        {
+            stop();
+        }
+        catch (const std::system_error& e)
+        {
+            destructor_exception_terminate(e, std::cerr, EX_OSERR);
+        }
+    }
+
+    close(fd);
+}
+
+void TimerFd::settime(const itimerspec &new_value, itimerspec *old_value)
+{
+    sysexcept(timerfd_settime(fd, 0, &new_value, old_value) < 0, "timerfd_settime", errno);
+}
+
+void TimerFd::gettime(itimerspec &curr_value) const
+{
+    sysexcept(timerfd_gettime(fd, &curr_value) < 0, "timerfd_gettime", errno);
+}
+
+TimerBackend TimerFd::backend_kind() const noexcept
+{
+    return TimerBackend::timerfd;
+}
+
+clockid_t TimerFd::reference_clock() const noexcept
+{
+    return clock;
+}
+
+std::uint64_t TimerFd::read_expirations()
+{
+    std::uint64_t expirations;
+    ssize_t ret;
+    do
+    {
+        ret = read(fd, &expirations, sizeof(expirations));
+    } while(ret < 0 && errno == EINTR);
+
+    if(ret < 0 && errno == EAGAIN) return 0;
+    sysexcept(ret < 0, "read", errno);
+
+    record_expiration();
+
+    return expirations;
+}
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
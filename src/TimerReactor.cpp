@@ -0,0 +1,108 @@
+/*
+ * \file TimerReactor.cpp
+ * \brief Source file de::Koesling::ITimer::TimerReactor
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "TimerReactor.hpp"
+#include "sysexcept.hpp"
+#include <cerrno>
+#include <unistd.h>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+TimerReactor::TimerReactor() :
+        epoll_fd(epoll_create1(EPOLL_CLOEXEC))
+{
+    sysexcept(epoll_fd < 0, "epoll_create1", errno);
+}
+
+TimerReactor::~TimerReactor()
+{
+    close(epoll_fd);
+}
+
+void TimerReactor::add(int fd, std::uint32_t events, const Registration &registration)
+{
+    if(registrations.count(fd))
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": file descriptor already registered");
+
+    epoll_event event;
+    event.events = events;
+    event.data.fd = fd;
+    sysexcept(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0, "epoll_ctl", errno);
+
+    registrations[fd] = registration;
+}
+
+void TimerReactor::add(TimerFd &timer, TimerCallback callback, void *arg)
+{
+    Registration registration = {&timer, callback, nullptr, arg};
+    add(timer.get_fd(), EPOLLIN, registration);
+}
+
+void TimerReactor::add(int fd, std::uint32_t events, FdCallback callback, void *arg)
+{
+    Registration registration = {nullptr, nullptr, callback, arg};
+    add(fd, events, registration);
+}
+
+void TimerReactor::remove(TimerFd &timer)
+{
+    remove(timer.get_fd());
+}
+
+void TimerReactor::remove(int fd)
+{
+    auto entry = registrations.find(fd);
+    if(entry == registrations.end())
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": file descriptor not registered");
+
+    // keep the registration if the fd stays in the epoll set
+    sysexcept(epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr) < 0, "epoll_ctl", errno);
+    registrations.erase(entry);
+}
+
+std::size_t TimerReactor::wait(int timeout)
+{
+    int n = epoll_wait(epoll_fd, events, MAX_EVENTS, timeout);
+    if(n < 0 && errno == EINTR) return 0;
+    sysexcept(n < 0, "epoll_wait", errno);
+
+    std::size_t count = 0;
+    for(int i = 0; i < n; ++i)
+    {
+        // lookup by fd: a callback may have removed the registration
+        auto entry = registrations.find(events[i].data.fd);
+        if(entry == registrations.end()) continue;
+
+        const Registration registration = entry->second;
+        if(registration.timer)
+        {
+            std::uint64_t expirations = registration.timer->read_expirations();
+            if(!expirations) continue;
+            registration.timer_callback(*registration.timer, expirations, registration.arg);
+        }
+        else
+        {
+            registration.fd_callback(events[i].data.fd, events[i].events, registration.arg);
+        }
+        ++count;
+    }
+
+    return count;
+}
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -0,0 +1,366 @@
+/*
+ * \file TimerService.cpp
+ * \brief Source file de::Koesling::ITimer::TimerService
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *          -pthread
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "TimerService.hpp"
+#include "PosixTimer.hpp"
+#include "sysexcept.hpp"
+#include <cerrno>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+std::atomic<TimerService*> TimerService::instance(nullptr);
+
+void TimerService::stray_handler(int sig)
+{
+    static_cast<void>(sig);
+}
+
+TimerService::TimerService(const Config &config, bool spawn, std::initializer_list<int> signals) :
+        config(config),
+        signals(),
+        dispatching(nullptr),
+        service_thread(pthread_t()),
+        thread_id(0),
+        terminate(false),
+        expirations(0),
+        spawned(spawn),
+        errors(0)
+{
+    sigemptyset(&this->signals);
+    for(int sig : signals)
+    {
+        if(sig <= 0 || sig >= NSIG || sig == SIGKILL || sig == SIGSTOP)
+            throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": invalid signal " + std::to_string(sig));
+        sigaddset(&this->signals, sig);
+    }
+
+    for(int sig = 0; sig < NSIG; ++sig) signal_timer[sig] = nullptr;
+
+    TimerService *expected = nullptr;
+    if(!instance.compare_exchange_strong(expected, this))
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) +
+                ": only one timer service per process possible");
+
+    // signals that reach a thread which does not block them must not terminate the process
+    struct sigaction action;
+    action.sa_handler = stray_handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+
+    for(int sig = 1; sig < NSIG; ++sig)
+    {
+        if(sigismember(&this->signals, sig) != 1) continue;
+
+        if(sigaction(sig, &action, &old_action[sig]) < 0)
+        {
+            const int error = errno;
+            for(int i = 1; i < sig; ++i)
+                if(sigismember(&this->signals, i) == 1) sigaction(i, &old_action[i], nullptr);
+            instance.store(nullptr);
+            sysexcept(true, "sigaction", error);
+        }
+    }
+
+    try
+    {
+        // inherited by the service thread and all threads created later
+        block_signals();
+
+        if(spawn)
+        {
+            thread = std::thread(&TimerService::spawned_thread, this);
+            service_thread.store(thread.native_handle());
+            configure_thread();
+        }
+    }
+    catch(...)
+    {
+        if(thread.joinable())
+        {
+            terminate.store(true);
+            service_thread.store(thread.native_handle());
+            wake();
+            thread.join();
+        }
+
+        for(int sig = 1; sig < NSIG; ++sig)
+            if(sigismember(&this->signals, sig) == 1) sigaction(sig, &old_action[sig], nullptr);
+        instance.store(nullptr);
+        throw;
+    }
+}
+
+TimerService::~TimerService()
+{
+    if(thread.joinable())
+    {
+        terminate.store(true);
+        wake();
+        thread.join();
+    }
+    else
+    {
+        try
+        {
+            stop();
+        }
+        catch(const std::system_error &)
+        {
+            // adopted thread has already terminated
+        }
+    }
+
+    for(int sig = 1; sig < NSIG; ++sig)
+        if(sigismember(&signals, sig) == 1) sigaction(sig, &old_action[sig], nullptr);
+
+    instance.store(nullptr);
+}
+
+void TimerService::block_signals() const
+{
+    const int error = pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    sysexcept(error != 0, "pthread_sigmask", error);
+}
+
+void TimerService::configure_thread()
+{
+    const pthread_t handle = service_thread.load();
+
+    if(config.cpu >= 0)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(static_cast<std::size_t>(config.cpu), &cpus);
+        const int error = pthread_setaffinity_np(handle, sizeof(cpus), &cpus);
+        sysexcept(error != 0, "pthread_setaffinity_np", error);
+    }
+
+    if(config.priority > 0)
+    {
+        sched_param param;
+        param.sched_priority = config.priority;
+        const int error = pthread_setschedparam(handle, SCHED_FIFO, &param);
+        sysexcept(error != 0, "pthread_setschedparam", error);
+    }
+}
+
+void TimerService::add(const ITimer &timer, Callback callback, void *arg)
+{
+    const int sig = timer.get_signal();
+    if(sig <= 0 || sig >= NSIG || sigismember(&signals, sig) != 1)
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": signal of the timer is not handled by the service");
+
+    // POSIX timers are identified by their sigval, all others by their signal
+    const bool by_signal = dynamic_cast<const PosixTimer*>(&timer) == nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if(registrations.count(&timer))
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": timer already registered");
+
+    if(by_signal && signal_timer[sig])
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": another timer uses this signal");
+
+    registrations[&timer] = {callback, arg};
+    if(by_signal) signal_timer[sig] = &timer;
+}
+
+void TimerService::remove(const ITimer &timer)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if(!registrations.erase(&timer))
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": timer not registered");
+
+    const int sig = timer.get_signal();
+    if(signal_timer[sig] == &timer) signal_timer[sig] = nullptr;
+
+    // the service thread would wait for itself (callback removes a timer)
+    if(thread_id.load() == static_cast<pid_t>(syscall(SYS_gettid))) return;
+
+    idle.wait(lock, [this, &timer] { return dispatching != &timer; });
+}
+
+void TimerService::run()
+{
+    if(thread.joinable())
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": service runs in a spawned thread");
+
+    pthread_t expected = pthread_t();
+    if(!service_thread.compare_exchange_strong(expected, pthread_self()))
+        throw std::logic_error(std::string(__PRETTY_FUNCTION__) + ": service is already running");
+
+    try
+    {
+        block_signals();
+        configure_thread();
+        service_loop();
+    }
+    catch(...)
+    {
+        thread_id.store(0);
+        service_thread.store(pthread_t());
+        throw;
+    }
+
+    service_thread.store(pthread_t());
+}
+
+void TimerService::stop()
+{
+    terminate.store(true);
+
+    // wake the adopted thread (see service_loop())
+    if(thread_id.load() == 0) return;
+
+    const int error = wake();
+    sysexcept(error != 0, "pthread_kill", error);
+}
+
+int TimerService::wake() noexcept
+{
+    for(int sig = 1; sig < NSIG; ++sig)
+        if(sigismember(&signals, sig) == 1) return pthread_kill(service_thread.load(), sig);
+
+    return 0;
+}
+
+void TimerService::spawned_thread()
+{
+    try
+    {
+        service_loop();
+    }
+    catch(...)
+    {
+        // the service thread ends
+        thread_id.store(0);
+        record_error(std::current_exception());
+    }
+}
+
+void TimerService::record_error(std::exception_ptr exception) noexcept
+{
+    errors.fetch_add(1, std::memory_order_relaxed);
+
+    try
+    {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if(!error) error = exception;
+    }
+    catch(const std::system_error &)
+    {
+        // only counted
+    }
+}
+
+std::exception_ptr TimerService::get_error() const
+{
+    std::lock_guard<std::mutex> lock(error_mutex);
+    return error;
+}
+
+void TimerService::service_loop()
+{
+    thread_id.store(static_cast<pid_t>(syscall(SYS_gettid)));
+
+    while(!terminate.load())
+    {
+        siginfo_t info;
+        if(sigwaitinfo(&signals, &info) < 0)
+        {
+            if(errno == EINTR) continue;
+            thread_id.store(0);
+            sysexcept(true, "sigwaitinfo", errno);
+        }
+
+        if(terminate.load()) break;
+        dispatch(info);
+    }
+
+    thread_id.store(0);
+}
+
+void TimerService::dispatch(const siginfo_t &info)
+{
+    Expiration expiration;
+    expiration.signal = info.si_signo;
+    clock_gettime(CLOCK_MONOTONIC, &expiration.time);
+
+    Registration registration;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if(info.si_code == SI_TIMER)
+        {
+            expiration.timer = PosixTimer::from_sigval(info.si_value);
+            expiration.overrun = info.si_overrun;
+        }
+        else if(info.si_code == SI_KERNEL)
+        {
+            // setitimer
+            expiration.timer = signal_timer[info.si_signo];
+            expiration.overrun = 0;
+        }
+        else
+        {
+            // e.g. wakeup of stop()
+            return;
+        }
+
+        auto entry = registrations.find(expiration.timer);
+        if(entry == registrations.end()) return;
+        registration = entry->second;
+
+        // remove() waits for the callback
+        dispatching = expiration.timer;
+    }
+
+    expiration.timer->record_expiration();
+    expirations.fetch_add(1, std::memory_order_relaxed);
+
+    std::exception_ptr exception;
+    try
+    {
+        registration.callback(expiration, registration.arg);
+    }
+    catch(...)
+    {
+        exception = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        dispatching = nullptr;
+    }
+    idle.notify_all();
+
+    if(!exception) return;
+
+    // adopted thread: thrown by run()
+    if(!spawned) std::rethrow_exception(exception);
+
+    // the service continues
+    record_error(exception);
+}
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */
@@ -0,0 +1,328 @@
+/*
+ * \file TimerWheel.cpp
+ * \brief Source file de::Koesling::ITimer::TimerWheel
+ *
+ * required compiler options:
+ *          -std=c++11 (or higher)
+ *
+ * recommended compiler options:
+ *          -O2
+ *
+ * Copyright (c) 2020 Nikolas Koesling
+ *
+ */
+
+#include "TimerWheel.hpp"
+#include "sysexcept.hpp"
+#include "destructor_exception.hpp"
+#include <cerrno>
+#include <iostream>
+#include <sysexits.h>
+
+//! largest tick offset that can be stored in the wheel
+static constexpr std::uint64_t MAX_TICK_OFFSET =
+        (std::uint64_t(1) << (de::Koesling::ITimer::TimerWheel::SLOT_BITS *
+                              de::Koesling::ITimer::TimerWheel::LEVELS)) - 1;
+
+//! slot index mask
+static constexpr std::uint64_t SLOT_MASK = de::Koesling::ITimer::TimerWheel::SLOTS - 1;
+
+//! number of ticks (rounded up) of a time period (negative values are treated as zero)
+static std::uint64_t to_ticks(const timespec &time, std::uint64_t resolution) noexcept
+{
+    const auto nsec = de::Koesling::ITimer::to_nsec(time);
+    if(nsec <= 0) return 0;
+    return static_cast<std::uint64_t>((static_cast<de::Koesling::ITimer::uint128_t>(nsec) + resolution - 1) / resolution);
+}
+
+//! initialize list head
+static void list_init(de::Koesling::ITimer::TimerWheel::Node *head) noexcept
+{
+    head->prev = head;
+    head->next = head;
+    head->owner = nullptr;
+}
+
+//! append node to list
+static void list_append(de::Koesling::ITimer::TimerWheel::Node *head,
+        de::Koesling::ITimer::TimerWheel::Node *node) noexcept
+{
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+//! remove node from its list
+static void list_remove(de::Koesling::ITimer::TimerWheel::Node *node) noexcept
+{
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = nullptr;
+    node->next = nullptr;
+}
+
+//! move all nodes from list src to (empty) list dst
+static void list_splice(de::Koesling::ITimer::TimerWheel::Node *src,
+        de::Koesling::ITimer::TimerWheel::Node *dst) noexcept
+{
+    list_init(dst);
+    if(src->next == src) return;
+
+    dst->next = src->next;
+    dst->prev = src->prev;
+    dst->next->prev = dst;
+    dst->prev->next = dst;
+    list_init(src);
+}
+
+namespace de {
+namespace Koesling {
+namespace ITimer {
+
+std::atomic<TimerWheel*> TimerWheel::instance(nullptr);
+
+void TimerWheel::signal_handler(int sig)
+{
+    static_cast<void>(sig);
+
+    TimerWheel *wheel = instance.load(std::memory_order_relaxed);
+    if(wheel) wheel->tick();
+}
+
+TimerWheel::TimerWheel(const timeval &resolution) :
+        tick_timer(resolution),
+        resolution(resolution),
+        next_tick(0),
+        pending_ticks(0),
+        armed(0)
+{
+    if(to_usec(resolution) <= 0)
+        throw std::invalid_argument(std::string(__PRETTY_FUNCTION__) + ": resolution must not be zero!");
+
+    for(unsigned level = 0; level < LEVELS; ++level)
+        for(unsigned slot = 0; slot < SLOTS; ++slot)
+            list_init(&slots[level][slot]);
+
+    // install signal handler
+    struct sigaction action;
+    action.sa_handler = signal_handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+
+    instance.store(this);
+    if(sigaction(SIGALRM, &action, &old_action) < 0)
+    {
+        int error = errno;
+        instance.store(nullptr);
+        sysexcept(true, "sigaction", error);
+    }
+}
+
+TimerWheel::~TimerWheel()
+{
+    // tick timer must be stopped before the signal handler is restored
+    if(tick_timer.is_running())
+    {
+        try
+        {
+            tick_timer.stop();
+        }
+        catch (const std::system_error& e)
+        {
+            destructor_exception_terminate(e, std::cerr, EX_OSERR);
+        }
+    }
+
+    sigaction(SIGALRM, &old_action, nullptr);
+    instance.store(nullptr);
+}
+
+void TimerWheel::insert(Node *node) noexcept
+{
+    const std::uint64_t expires = node->owner->expires;
+    std::uint64_t offset = expires - next_tick;
+
+    // already expired --> next tick
+    if(expires < next_tick)
+    {
+        list_append(&slots[0][next_tick & SLOT_MASK], node);
+        return;
+    }
+
+    for(unsigned level = 0; level < LEVELS - 1; ++level)
+    {
+        if(offset < (std::uint64_t(1) << (SLOT_BITS * (level + 1))))
+        {
+            list_append(&slots[level][(expires >> (SLOT_BITS * level)) & SLOT_MASK], node);
+            return;
+        }
+    }
+
+    // out of range --> insert at end of wheel, the timer is re-inserted during cascade
+    if(offset > MAX_TICK_OFFSET) offset = MAX_TICK_OFFSET;
+    const std::uint64_t slot_tick = next_tick + offset;
+    list_append(&slots[LEVELS - 1][(slot_tick >> (SLOT_BITS * (LEVELS - 1))) & SLOT_MASK], node);
+}
+
+unsigned TimerWheel::cascade(unsigned level, unsigned index) noexcept
+{
+    Node list;
+    list_splice(&slots[level][index], &list);
+
+    while(list.next != &list)
+    {
+        Node *node = list.next;
+        list_remove(node);
+        insert(node);
+    }
+
+    return index;
+}
+
+std::size_t TimerWheel::run_tick()
+{
+    const std::uint64_t tick = next_tick;
+    const unsigned index = static_cast<unsigned>(tick & SLOT_MASK);
+
+    // move timers of the higher levels down
+    if(index == 0)
+    {
+        for(unsigned level = 1; level < LEVELS; ++level)
+        {
+            auto level_index = static_cast<unsigned>((tick >> (SLOT_BITS * level)) & SLOT_MASK);
+            if(cascade(level, level_index) != 0) break;
+        }
+    }
+
+    ++next_tick;
+
+    // timers are taken from a local list --> callbacks may start/stop any timer
+    Node work;
+    list_splice(&slots[0][index], &work);
+
+    std::size_t count = 0;
+    while(work.next != &work)
+    {
+        Node *node = work.next;
+        list_remove(node);
+
+        WheelTimer *timer = node->owner;
+        if(timer->interval_ticks)
+        {
+            timer->expires += timer->interval_ticks;
+            insert(node);
+        }
+        else
+        {
+            --armed;
+        }
+
+        ++count;
+        timer->callback(*timer, timer->arg);
+    }
+
+    return count;
+}
+
+std::size_t TimerWheel::process()
+{
+    std::size_t count = 0;
+    for(unsigned long ticks = pending_ticks.exchange(0); ticks; --ticks)
+        count += run_tick();
+
+    return count;
+}
+
+WheelTimer::WheelTimer(TimerWheel &wheel, const timeval &interval,
+        Callback callback, void *arg) noexcept :
+        ITimer(-1, interval),
+        wheel(wheel),
+        expires(0),
+        interval_ticks(0),
+        callback(callback),
+        arg(arg)
+{
+    node.prev = nullptr;
+    node.next = nullptr;
+    node.owner = this;
+}
+
+WheelTimer::WheelTimer(TimerWheel &wheel, const timeval &interval,
+        const timeval &value, Callback callback, void *arg) noexcept :
+        ITimer(-1, interval, value),
+        wheel(wheel),
+        expires(0),
+        interval_ticks(0),
+        callback(callback),
+        arg(arg)
+{
+    node.prev = nullptr;
+    node.next = nullptr;
+    node.owner = this;
+}
+
+WheelTimer::~WheelTimer( )
+{
+    // stop here, ITimer::~ITimer() can not call the overridden settime()
+    if(is_running()) stop();
+}
+
+void WheelTimer::unlink() noexcept
+{
+    if(!node.next) return;
+
+    list_remove(&node);
+    --wheel.armed;
+}
+
+timespec WheelTimer::remaining() const noexcept
+{
+    if(!node.next) return {0, 0};
+
+    const std::uint64_t res = static_cast<std::uint64_t>(to_usec(wheel.resolution) * NSEC_PER_MICROSECOND);
+    return nsec_to_timespec((expires - wheel.next_tick + 1) * res);
+}
+
+void WheelTimer::settime(const itimerspec &new_value, itimerspec *old_value)
+{
+    const std::uint64_t res = static_cast<std::uint64_t>(to_usec(wheel.resolution) * NSEC_PER_MICROSECOND);
+
+    if(old_value)
+    {
+        old_value->it_value = remaining();
+        old_value->it_interval = nsec_to_timespec(interval_ticks * res);
+    }
+
+    unlink();
+
+    const std::uint64_t value_ticks = to_ticks(new_value.it_value, res);
+    if(value_ticks == 0) return;
+
+    interval_ticks = to_ticks(new_value.it_interval, res);
+    expires = wheel.next_tick + value_ticks - 1;
+    wheel.insert(&node);
+    ++wheel.armed;
+}
+
+void WheelTimer::gettime(itimerspec &curr_value) const
+{
+    const std::uint64_t res = static_cast<std::uint64_t>(to_usec(wheel.resolution) * NSEC_PER_MICROSECOND);
+
+    curr_value.it_value = remaining();
+    curr_value.it_interval = nsec_to_timespec(interval_ticks * res);
+}
+
+TimerBackend WheelTimer::backend_kind() const noexcept
+{
+    return TimerBackend::wheel;
+}
+
+bool WheelTimer::value_predictable() const noexcept
+{
+    return false;
+}
+
+} /* namespace ITimer */
+} /* namespace Koesling */
+} /* namespace de */